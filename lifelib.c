@@ -0,0 +1,394 @@
+/*================================================================================================
+
+ライフゲームのライブラリ(使い方はlifelib.hを参照)
+
+================================================================================================*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "lifelib.h"
+
+struct life_universe {
+  int height;
+  int width;
+  int words; // 1行あたりのワード数
+  uint64_t *bits;
+  uint64_t *next_bits;
+  long generation;
+  long alive; // 生きているセルの数(書き換えるたびに数え直しておき、life_get_stats()で盤面全体を数えずに済ませる)
+  int can_survive[9];
+  int can_born[9];
+};
+
+/*------------------------------------------------------------------------------------------------
+  盤面
+------------------------------------------------------------------------------------------------*/
+
+life_universe *life_create(int height, int width) {
+
+  if (height <= 0 || width <= 0) return NULL;
+
+  life_universe *u = calloc(1, sizeof(life_universe));
+  if (u == NULL) return NULL;
+
+  u->height = height;
+  u->width = width;
+  u->words = (width + 63) / 64;
+  u->bits = calloc((size_t)height * u->words, sizeof(uint64_t));
+  u->next_bits = calloc((size_t)height * u->words, sizeof(uint64_t));
+  if (u->bits == NULL || u->next_bits == NULL) {
+    life_destroy(u);
+    return NULL;
+  }
+
+  life_set_rule(u, "B3/S23");
+  return u;
+}
+
+void life_destroy(life_universe *u) {
+
+  if (u == NULL) return;
+  free(u->bits);
+  free(u->next_bits);
+  free(u);
+}
+
+int life_set_rule(life_universe *u, const char *rule) {
+
+  int born[9] = {0}, survive[9] = {0};
+  int *target = NULL;
+
+  for (int i=0; rule[i] != 0; i++) {
+    char c = rule[i];
+    if (c == 'B' || c == 'b') {
+      target = born;
+    } else if (c == 'S' || c == 's') {
+      target = survive;
+    } else if ('0' <= c && c <= '8' && target != NULL) {
+      target[c - '0'] = 1;
+    } else if (c != '/') {
+      return -1;
+    }
+  }
+
+  memcpy(u->can_born, born, sizeof(born));
+  memcpy(u->can_survive, survive, sizeof(survive));
+  return 0;
+}
+
+static void set_cell(life_universe *u, long y, long x) {
+
+  if (y < 0 || u->height <= y || x < 0 || u->width <= x) return; // 盤面の外は無視する
+  uint64_t *word = &u->bits[y * u->words + x / 64];
+  uint64_t bit = 1ULL << (x % 64);
+  if ((*word & bit) == 0) u->alive++;
+  *word |= bit;
+}
+
+/*------------------------------------------------------------------------------------------------
+  読み込み
+------------------------------------------------------------------------------------------------*/
+
+/*
+  text[*pos]から1行を取り出す関数(lineは改行と行末の空白(CRLFの\rを含む)を含まず、0終端)
+  行が無ければ0、lineに入りきらずに切り詰めた場合は-1を返す(どちらの場合も行末までは読み進める)
+*/
+static int next_line(const char *text, size_t len, size_t *pos, char *line, size_t line_len) {
+
+  if (*pos >= len) return 0;
+
+  size_t n = 0;
+  int truncated = 0;
+  while (*pos < len && text[*pos] != '\n') {
+    if (n < line_len - 1) {
+      line[n++] = text[*pos];
+    } else {
+      truncated = 1;
+    }
+    (*pos)++;
+  }
+  if (*pos < len) (*pos)++; // 改行を飛ばす
+  while (n > 0 && (line[n - 1] == ' ' || line[n - 1] == '\t' || line[n - 1] == '\r')) n--;
+  line[n] = 0;
+  return truncated ? -1 : 1;
+}
+
+static int load_life106(life_universe *u, const char *text, size_t len) {
+
+  size_t pos = 0;
+  char line[256];
+  int result;
+  while ((result = next_line(text, len, &pos, line, sizeof(line))) != 0) {
+    if (line[0] == '#') continue; // コメントは切り詰められても構わない
+    if (result < 0) return -1;
+
+    long x, y;
+    char *end;
+    x = strtol(line, &end, 10);
+    if (end == line) continue; // 空行
+    char *p = end;
+    y = strtol(p, &end, 10);
+    if (end == p) return -1;
+    set_cell(u, y, x);
+  }
+  return 0;
+}
+
+/*
+  ヘッダー(#で始まる行とxで始まる行)は1行ずつ取り出し、
+  本体は行の長さに制限が無いようにtextから直接1文字ずつ読む
+*/
+static int load_rle(life_universe *u, const char *text, size_t len) {
+
+  long y = 0, x = 0;
+  long offset_x = 0;
+  size_t pos = 0;
+  char line[256];
+
+  while (pos < len) {
+
+    /* オフセット指定以外のヘッダー情報は読み飛ばす */
+    if (text[pos] == '#') {
+      next_line(text, len, &pos, line, sizeof(line)); // コメントは切り詰められても構わない
+      if (line[1] == 'P' || line[1] == 'R') {
+        char *end;
+        offset_x = strtol(line + 2, &end, 10);
+        y = strtol(end, NULL, 10);
+        x = offset_x;
+      }
+      continue;
+    }
+
+    /* サイズ情報は読み飛ばし、ルールは反映する */
+    if (text[pos] == 'x') {
+      if (next_line(text, len, &pos, line, sizeof(line)) < 0) return -1;
+      char *rule = strstr(line, "rule");
+      if (rule != NULL) {
+        rule = strchr(rule, '=');
+        if (rule == NULL) return -1;
+        rule++;
+        while (*rule == ' ') rule++;
+        if (life_set_rule(u, rule) != 0) return -1;
+      }
+      continue;
+    }
+
+    /* 本体を行末まで読む */
+    while (pos < len && text[pos] != '\n') {
+      char c = text[pos];
+      if (c == ' ' || c == '\t' || c == '\r') {
+        pos++;
+        continue;
+      }
+
+      long run = 1;
+      if ('0' <= c && c <= '9') {
+        run = 0;
+        while (pos < len && '0' <= text[pos] && text[pos] <= '9') run = run * 10 + (text[pos++] - '0');
+        if (pos == len) return -1;
+      }
+
+      c = text[pos++];
+      if (c == '!') {
+        return 0;
+      } else if (c == '$') {
+        y += run;
+        x = offset_x;
+      } else if (c == 'b') {
+        x += run;
+      } else if (c == 'o') {
+        for (long i=0; i<run; i++) set_cell(u, y, x++);
+      } else {
+        return -1;
+      }
+    }
+    if (pos < len) pos++; // 改行を飛ばす
+  }
+  return 0;
+}
+
+int life_load(life_universe *u, const char *text, size_t len) {
+
+  memset(u->bits, 0, sizeof(uint64_t) * u->height * u->words);
+  u->generation = 0;
+  u->alive = 0;
+  life_set_rule(u, "B3/S23");
+
+  if (len >= 10 && memcmp(text, "#Life 1.06", 10) == 0) {
+    return load_life106(u, text, len);
+  }
+  return load_rle(u, text, len);
+}
+
+/*------------------------------------------------------------------------------------------------
+  更新
+  64セル分の隣接数を4bit(s3 s2 s1 s0)の加算器で求め、ルールをビット演算で当てる。
+------------------------------------------------------------------------------------------------*/
+
+static void step_once(life_universe *u) {
+
+  const int words = u->words;
+  const int rest = u->width % 64;
+  const uint64_t last_mask = (rest == 0) ? ~0ULL : ((1ULL << rest) - 1);
+
+  /* 隣接数nで次に生きるのは、誕生(今死んでいる)か生存(今生きている)の場合 */
+  uint64_t born_mask[9], survive_mask[9];
+  for (int n=0; n<=8; n++) {
+    born_mask[n] = u->can_born[n] ? ~0ULL : 0;
+    survive_mask[n] = u->can_survive[n] ? ~0ULL : 0;
+  }
+
+  long count = 0;
+  for (int y=0; y<u->height; y++) {
+    const uint64_t *rows[3];
+    rows[0] = (y > 0) ? u->bits + (size_t)(y - 1) * words : NULL;
+    rows[1] = u->bits + (size_t)y * words;
+    rows[2] = (y < u->height - 1) ? u->bits + (size_t)(y + 1) * words : NULL;
+    uint64_t *out = u->next_bits + (size_t)y * words;
+
+    for (int k=0; k<words; k++) {
+      uint64_t a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+
+      for (int r=0; r<3; r++) {
+        if (rows[r] == NULL) continue;
+        uint64_t cur = rows[r][k];
+        uint64_t prev = (k > 0) ? rows[r][k - 1] : 0;
+        uint64_t next = (k < words - 1) ? rows[r][k + 1] : 0;
+
+        uint64_t in[3];
+        in[0] = (cur << 1) | (prev >> 63); // 左隣(x-1)
+        in[1] = (cur >> 1) | (next << 63); // 右隣(x+1)
+        in[2] = (r != 1) ? cur : 0;         // 真上と真下
+
+        for (int i=0; i<3; i++) {
+          uint64_t c0 = a0 & in[i];
+          a0 ^= in[i];
+          uint64_t c1 = a1 & c0;
+          a1 ^= c0;
+          uint64_t c2 = a2 & c1;
+          a2 ^= c1;
+          a3 |= c2;
+        }
+      }
+
+      uint64_t alive = rows[1][k];
+      uint64_t result = 0;
+      for (int n=0; n<=8; n++) {
+        if ((born_mask[n] | survive_mask[n]) == 0) continue;
+        uint64_t eq = ((n & 1) ? a0 : ~a0) & ((n & 2) ? a1 : ~a1) & ((n & 4) ? a2 : ~a2) & ((n & 8) ? a3 : ~a3);
+        result |= eq & ((~alive & born_mask[n]) | (alive & survive_mask[n]));
+      }
+      if (k == words - 1) result &= last_mask;
+      out[k] = result;
+      count += __builtin_popcountll(result);
+    }
+  }
+  u->alive = count;
+
+  uint64_t *tmp = u->bits;
+  u->bits = u->next_bits;
+  u->next_bits = tmp;
+}
+
+void life_step(life_universe *u, long n) {
+
+  for (long i=0; i<n; i++) step_once(u);
+  u->generation += (n > 0) ? n : 0;
+}
+
+/*------------------------------------------------------------------------------------------------
+  セルの読み書きと書き出し
+------------------------------------------------------------------------------------------------*/
+
+static int in_universe(const life_universe *u, int y, int x, int h, int w) {
+  return 0 <= y && 0 <= x && 0 <= h && 0 <= w && h <= u->height - y && w <= u->width - x;
+}
+
+int life_get_cells(const life_universe *u, int y, int x, int h, int w, uint8_t *cells) {
+
+  if (!in_universe(u, y, x, h, w)) return -1;
+
+  for (int i=0; i<h; i++) {
+    const uint64_t *row = u->bits + (size_t)(y + i) * u->words;
+    uint8_t *out = cells + (size_t)i * w;
+    for (int j=0; j<w; j++) {
+      int cx = x + j;
+      out[j] = (row[cx / 64] >> (cx % 64)) & 1;
+    }
+  }
+  return 0;
+}
+
+int life_set_cells(life_universe *u, int y, int x, int h, int w, const uint8_t *cells) {
+
+  if (!in_universe(u, y, x, h, w)) return -1;
+
+  for (int i=0; i<h; i++) {
+    uint64_t *row = u->bits + (size_t)(y + i) * u->words;
+    const uint8_t *in = cells + (size_t)i * w;
+    for (int j=0; j<w; j++) {
+      int cx = x + j;
+      uint64_t bit = 1ULL << (cx % 64);
+      int was_alive = (row[cx / 64] & bit) != 0;
+      if (in[j]) {
+        row[cx / 64] |= bit;
+      } else {
+        row[cx / 64] &= ~bit;
+      }
+      u->alive += (in[j] != 0) - was_alive;
+    }
+  }
+  return 0;
+}
+
+/* 行rowの[x0, x1)の範囲の生きたセルを数える(範囲は盤面の中) */
+static uint32_t count_range(const uint64_t *row, long x0, long x1) {
+
+  uint32_t count = 0;
+  while (x0 < x1) {
+    int b = x0 % 64;
+    int n = (x1 - x0 < 64 - b) ? (int)(x1 - x0) : 64 - b;
+    uint64_t mask = (n == 64) ? ~0ULL : ((1ULL << n) - 1) << b;
+    count += __builtin_popcountll(row[x0 / 64] & mask);
+    x0 += n;
+  }
+  return count;
+}
+
+int life_get_view(const life_universe *u, long y, long x, int rows, int cols, int zoom, uint32_t *counts) {
+
+  if (rows < 0 || cols < 0 || zoom < 1) return -1;
+
+  memset(counts, 0, sizeof(uint32_t) * rows * cols);
+
+  for (int r=0; r<rows; r++) {
+    for (int i=0; i<zoom; i++) {
+      long cy = y + (long)r * zoom + i;
+      if (cy < 0 || u->height <= cy) continue;
+      const uint64_t *row = u->bits + (size_t)cy * u->words;
+      for (int c=0; c<cols; c++) {
+        long x0 = x + (long)c * zoom, x1 = x0 + zoom;
+        if (x0 < 0) x0 = 0;
+        if (x1 > u->width) x1 = u->width;
+        if (x0 < x1) counts[r * cols + c] += count_range(row, x0, x1);
+      }
+    }
+  }
+  return 0;
+}
+
+int life_row_words(const life_universe *u) {
+  return u->words;
+}
+
+void life_export_bits(const life_universe *u, uint64_t *bits) {
+  memcpy(bits, u->bits, sizeof(uint64_t) * u->height * u->words);
+}
+
+void life_get_stats(const life_universe *u, life_stats *stats) {
+
+  stats->generation = u->generation;
+  stats->alive = u->alive;
+  stats->height = u->height;
+  stats->width = u->width;
+}
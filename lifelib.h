@@ -0,0 +1,79 @@
+/*================================================================================================
+
+ライフゲームのライブラリ
+
+これまでのプログラムは全ての処理がmain()の中にあり、結果は標準出力に文字で描くだけだった。
+他のプログラムから使えるように、盤面の計算部分をライブラリにした。
+盤面はlife_universeの中身を見せないハンドルで扱い、
+セルの読み書きは1セルずつではなく長方形の範囲をまとめて行う。
+内部では1行をuint64_tの配列に詰めて(1bit/セル)、64セルずつまとめて更新する(mylife5.cのpackedカーネル)。
+盤面の外は死んでいるものとして扱う。
+
+エラーのときは、ポインタを返す関数はNULL、intを返す関数は-1を返す。
+
+ビルド
+  静的ライブラリ: gcc -O2 -c lifelib.c && ar rcs liblife.a lifelib.o
+  共有ライブラリ: gcc -O2 -fPIC -shared -o liblife.so lifelib.c
+  使う側        : gcc -O2 mylife16.c -L. -llife
+
+================================================================================================*/
+
+#ifndef LIFELIB_H
+#define LIFELIB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct life_universe life_universe;
+
+typedef struct {
+  long generation; // life_load()またはlife_create()からの世代数
+  long alive;      // 生きているセルの数
+  int height;
+  int width;
+} life_stats;
+
+/* height x widthの全て死んだ盤面を作る(ルールはB3/S23) */
+life_universe *life_create(int height, int width);
+void life_destroy(life_universe *u);
+
+/* "B36/S23"のようなルールを設定する */
+int life_set_rule(life_universe *u, const char *rule);
+
+/*
+  メモリ上のパターン(RLEかLife 1.06)を読み込む
+  盤面は一度全て死んだ状態に戻し、世代数も0にする。RLEにルールがあればそれも反映する。
+  盤面の外に出るセルは無視する。
+*/
+int life_load(life_universe *u, const char *text, size_t len);
+
+/* n世代進める */
+void life_step(life_universe *u, long n);
+
+/*
+  (y, x)を左上とするh x wの範囲のセルを、1セル1バイト(0か1)で行ごとにcellsに読み書きする
+  範囲が盤面からはみ出す場合は-1を返す
+*/
+int life_get_cells(const life_universe *u, int y, int x, int h, int w, uint8_t *cells);
+int life_set_cells(life_universe *u, int y, int x, int h, int w, const uint8_t *cells);
+
+/*
+  盤面全体を1bit/セルで書き出す
+  1行はlife_row_words()個のuint64_tで、x番目のセルは(x/64)番目のワードの(x%64)ビット目
+  bitsにはheight * life_row_words()個のuint64_tが必要
+*/
+int life_row_words(const life_universe *u);
+void life_export_bits(const life_universe *u, uint64_t *bits);
+
+/*
+  表示用に、(y, x)を左上とするrows x colsの範囲を、1つがzoom x zoomセルのブロックごとに数える
+  countsにはrows * cols個のuint32_tが必要で、各ブロックの生きたセルの数が入る
+  盤面の外にはみ出した部分は死んだセルとして数えるので、範囲は盤面の外にあってもよい
+  見える範囲のワードだけを読むので、かかる時間は盤面の大きさによらない
+*/
+int life_get_view(const life_universe *u, long y, long x, int rows, int cols, int zoom, uint32_t *counts);
+
+/* 世代数や生きているセルの数を返す(生きているセルの数は書き換えるたびに数えてあるので、盤面の大きさによらない) */
+void life_get_stats(const life_universe *u, life_stats *stats);
+
+#endif
@@ -0,0 +1,627 @@
+/*================================================================================================
+
+64個の盤面をまとめて計算する(ビットスライス)
+
+同じ大きさの盤面を64個用意し、uint64_tの1ワードに「64個の盤面の同じ位置のセル」を詰める。
+(board[y][x]のlビット目がl番目の盤面のセル。)
+隣接8セルのワードを半加算器の論理演算で足すと、64個の盤面の隣接数が4bitずつ(s3 s2 s1 s0)で求まるので、
+1回の計算で64個分のシミュレーションが進む。
+
+ルールはビットマスクで持つ。
+  born_mask[n]   : 隣接数nで誕生するレーン(盤面)の集合
+  survive_mask[n]: 隣接数nで生存するレーンの集合
+全レーンが同じルールならマスクは0か~0になるだけだが、レーンごとに違うルールを持たせることもできる。
+
+モード
+  soup : 64個の異なるランダムな初期状態を同じルールで進める
+  rules: 1つの初期状態(パターンファイルかランダム)を64個の異なるルールで進める
+         ルールはB3固定で、Sを{0,1,2,3,4,5}の部分集合の64通り(レーンlのSはlのビットの立っている数)にする
+
+どちらも最後にレーンごとの生きているセル数を表示する。
+-cを付けると、全てのレーンをmylife3.cのmy_update_cells()でも1つずつ計算し、結果が一致するか確認する。
+
+引数
+  [-c] soup [ルール(B3/S23など)] [密度(%)] [世代数] [height] [width]
+  [-c] rules [世代数] [初期状態のファイル(省略時はランダム)]
+
+実行例
+  ./a.out soup B36/S23 30 500
+  ./a.out -c rules 100 Pulsar.rle
+
+================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h> // sleep()関数を使う
+#include <time.h>
+#include <string.h>
+#include <stdint.h>
+
+/* デフォルトのルール */
+int can_survive[9] = {0, 0, 1, 1, 0};
+int can_born[9] = {0, 0, 0, 1, 0};
+char rule_S[10] = "23";
+char rule_B[10] = "3";
+
+/*
+  文字列strの最後がsuffixに一致するか判定する関数
+*/
+int ends_with(const char str[], const char suffix[]) {
+
+  int len_str = strlen(str);
+  int len_suf = strlen(suffix);
+
+  if (len_str < len_suf) return 0;
+
+  char lower_str[255];
+  char lower_suffix[255];
+  strcpy(lower_str, str);
+  strcpy(lower_suffix, suffix);
+
+  /* 大文字は全て小文字にする */
+  for (int i=0; lower_str[i] != 0; i++) {
+    if ('A' <= lower_str[i] && lower_str[i] <= 'Z') {
+      lower_str[i] += 'a' - 'A';
+    }
+  }
+  for (int i=0; lower_suffix[i] != 0; i++) {
+    if ('A' <= lower_suffix[i] && lower_suffix[i] <= 'Z') {
+      lower_suffix[i] += 'a' - 'A';
+    }
+  }
+
+  return (strcmp(lower_str + len_str - len_suf, lower_suffix) == 0);
+}
+
+/*
+  文字列を10進数で表した時の長さを返す関数
+  ただし、0の長さは0とする
+*/
+int number_len(int n) {
+  int len = 0;
+  while(n > 0) {
+    len++;
+    n /= 10;
+  }
+
+  return len;
+}
+
+/*
+  文字が空白、タブ、CR、LFのいずれかなら1を返す関数
+*/
+int isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+int loadRLE(const int height, const int width, int cell[height][width], FILE *fp) {
+
+  char buffer[(int)1e4+1]; // 1行は70文字以下だが念のため
+  int y = 0, x = 0;
+  int offsetY = 0, offsetX = 0;
+  while(fgets(buffer, 1e4, fp) != NULL) {
+
+    /* オフセット指定以外のヘッダー情報は読み飛ばす */
+    if (buffer[0] == '#') {
+      if (buffer[1] == 'P' || buffer[1] == 'R') {
+        sscanf(buffer+2, "%d%d", &offsetX, &offsetY);
+        if (offsetY < 0 || offsetX < 0) {
+          offsetY = 0;
+          offsetX = 0;
+        } else {
+          y = offsetY;
+          x = offsetX;
+        }
+      }
+      continue;
+    }
+
+    /* サイズ情報は読み飛ばし、ルールは反映する */
+    if (buffer[0] == 'x') {
+      int result = sscanf(buffer, "x = %*d, y = %*d, rule = B%9[^/n]/S%9s", rule_B, rule_S);
+
+      for (int i=0; i<=8; i++) {
+        can_survive[i] = 0;
+        can_born[i] = 0;
+      }
+
+      for (int i=0; i<10; i++) {
+        int s = rule_S[i] - '0';
+        int b = rule_B[i] - '0';
+        if (0 <= s && s <= 8) can_survive[s] = 1;
+        if (0 <= b && b <= 8) can_born[b] = 1;
+      }
+
+      continue;
+    }
+
+    int offset = 0; // 行の何文字目を次に読むか
+    while(1) {
+      int len = 0; // ランの長さ
+      char c; // タグ('o', 'b', '$', '!'のいずれか)
+
+      // 途中に空白が入っても対応可能
+      while(isWhitespace(buffer[offset])) offset++;
+
+      // ランの長さを取得(1が省略されている場合は何も読み込まない)
+      int result = sscanf(buffer+offset, "%d", &len);
+      // 読み込んだ分だけoffsetを加算(ただし0のままの場合は読みこんでないのでそのまま)
+      offset += number_len(len);
+
+      // 長さ省略時は1
+      if (len == 0) len = 1;
+
+      // ランのタグを取得
+      result = sscanf(buffer+offset, "%c", &c);
+      offset++;
+
+      if (result <= 0 || c == '!') { // 終了
+        break;
+      } else if (c == '$') { // 改行
+        y += len;
+        x = offsetX;
+      } else if (c == 'b') { // dead
+        x += len;
+      } else if (c == 'o') { // alive
+        for (int i=0; i<len; i++) {
+          cell[y][x] = 1;
+          x++;
+        }
+      } else {
+        fprintf(stderr,"Invalid syntax\n");
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ ファイルによるセルの初期化: 生きているセルの座標が記述されたファイルをもとに2次元配列の状態を初期化する
+ fp = NULL のときは、関数内で適宜定められた初期状態に初期化する。関数内初期値はdefault.lif と同じもの
+ */
+int my_init_cells(const int height, const int width, int cell[height][width], char filename[]) {
+
+  if (filename[0] == 0) {
+    /* ランダムに配置する */
+    srand(time(NULL));
+
+    for (int y=0; y<height; y++) {
+      for (int x=0; x<width; x++) {
+        cell[y][x] = (rand() % 10 == 0 ? 1 : 0);
+      }
+    }
+  } else {
+
+    FILE *fp = fopen(filename,"r");
+    if (fp == NULL) {
+      fprintf(stderr,"cannot open file %s\n", filename);
+      return EXIT_FAILURE;
+    }
+
+    if (ends_with(filename, ".lif")) {
+
+      fscanf(fp, "%*[^\n]\n"); // バージョン情報は読み飛ばす
+
+      int x, y;
+      while (fscanf(fp, "%d%d", &x, &y) > 0) {
+        cell[y][x] = 1;
+      }
+
+    } else if (ends_with(filename, ".rle")) {
+
+      int result = loadRLE(height, width, cell, fp);
+      if (result != 0) return EXIT_FAILURE;
+
+    } else {
+
+      fprintf(stderr,"Supported: .lif .rle\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ グリッドの描画: 世代情報とグリッドの配列等を受け取り、ファイルポインタに該当する出力にグリッドを描画する
+ */
+void my_print_cells(FILE *fp, int gen, const int height, const int width, int cell[height][width]) {
+
+  /* 0,1それぞれの状態のセルをカウント */
+  int count_cells[2] = {0, 0};
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      count_cells[cell[y][x]]++;
+    }
+  }
+
+  // 世代情報と存在比を表示
+  fprintf(fp, "rule: B%s/S%s, generateion = %d, alive:dead = %7d:%7d\r\n", rule_B, rule_S, gen, count_cells[1], count_cells[0]);
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  /* グリッド */
+  for (int y=0; y<height; y++) {
+    fprintf(fp, "|");
+    for (int x=0; x<width; x++) {
+      fprintf(fp, "\e[31m%c\e[0m", (cell[y][x] ? '#' : ' ')); // 赤色で表示
+    }
+    fprintf(fp, "|\r\n");
+  }
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  fflush(fp);
+}
+
+int in_cells(int y, int x, const int height, const int width) {
+
+  if (y < 0 || height <= y) return 0;
+  if (x < 0 || width <= x) return 0;
+
+  return 1;
+}
+
+/*
+ 着目するセルの周辺の生きたセルをカウントする関数
+ */
+int my_count_adjacent_cells(int y, int x, const int height, const int width, int cell[height][width]) {
+
+  /*
+    dy, dx: 相対位置
+    012
+    7.3
+    654
+  */
+  int dy[] = {-1, -1, -1, 0, 1, 1, 1, 0};
+  int dx[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+
+  int count = 0;
+  
+  for (int i=0; i<8; i++) {
+
+    int ny = y + dy[i];
+    int nx = x + dx[i];
+
+    if (in_cells(ny, nx, height, width) && cell[ny][nx]) {
+      count++;
+    }
+
+  }
+
+  return count;
+}
+
+/*
+  着目するセルの次の世代での状態を返す関数
+*/
+int next_state(int y, int x, const int height, const int width, int cell[height][width], int neighbors) {
+
+  if (cell[y][x]) { 
+    return can_survive[neighbors];
+  } else {
+    return can_born[neighbors];
+  }
+
+}
+
+/*
+ ライフゲームのルールに基づいて2次元配列の状態を更新する
+ */
+void my_update_cells(const int height, const int width, int cell[height][width]) {
+
+  int next_cell[height][width];
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      next_cell[y][x] = 0;
+    }
+  }
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      int neighbors = my_count_adjacent_cells(y, x, height, width, cell);
+      next_cell[y][x] = next_state(y, x, height, width, cell, neighbors);
+    }
+  }
+
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      cell[y][x] = next_cell[y][x];
+    }
+  }
+
+}
+
+#define LANES 64
+
+uint64_t born_mask[9];
+uint64_t survive_mask[9];
+
+/*
+  "B36/S23"のようなルール文字列を読み、born[], survive[]に設定する関数
+  読めなければ-1を返す
+*/
+int parse_rule(const char str[], int born[9], int survive[9]) {
+
+  for (int i=0; i<=8; i++) {
+    born[i] = 0;
+    survive[i] = 0;
+  }
+
+  int *target = NULL;
+  for (int i=0; str[i] != 0; i++) {
+    char c = str[i];
+    if (c == 'B' || c == 'b') {
+      target = born;
+    } else if (c == 'S' || c == 's') {
+      target = survive;
+    } else if ('0' <= c && c <= '8' && target != NULL) {
+      target[c - '0'] = 1;
+    } else if (c != '/') {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/*
+  レーンlaneのルールをborn_mask, survive_maskに設定する関数
+*/
+void set_lane_rule(int lane, const int born[9], const int survive[9]) {
+
+  for (int n=0; n<=8; n++) {
+    born_mask[n] &= ~(1ULL << lane);
+    survive_mask[n] &= ~(1ULL << lane);
+    if (born[n]) born_mask[n] |= 1ULL << lane;
+    if (survive[n]) survive_mask[n] |= 1ULL << lane;
+  }
+}
+
+/*
+  レーンlaneのルールを"B3/S23"の形の文字列にする関数
+*/
+void lane_rule_string(int lane, char str[]) {
+
+  int n = 0;
+  str[n++] = 'B';
+  for (int i=0; i<=8; i++) {
+    if ((born_mask[i] >> lane) & 1) str[n++] = '0' + i;
+  }
+  str[n++] = '/';
+  str[n++] = 'S';
+  for (int i=0; i<=8; i++) {
+    if ((survive_mask[i] >> lane) & 1) str[n++] = '0' + i;
+  }
+  str[n] = 0;
+}
+
+/*
+  64レーン分の盤面を1世代進める関数
+  boardの外側は全レーンで死んでいるものとする
+*/
+void lanes_update_cells(const int height, const int width, uint64_t board[height][width], uint64_t next[height][width]) {
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+
+      /* 隣接8セルを4bitのカウンタ(a3 a2 a1 a0)に足していく */
+      uint64_t a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+      for (int ny=y-1; ny<=y+1; ny++) {
+        if (ny < 0 || height <= ny) continue;
+        for (int nx=x-1; nx<=x+1; nx++) {
+          if (nx < 0 || width <= nx || (ny == y && nx == x)) continue;
+          uint64_t in = board[ny][nx];
+          uint64_t c0 = a0 & in;
+          a0 ^= in;
+          uint64_t c1 = a1 & c0;
+          a1 ^= c0;
+          uint64_t c2 = a2 & c1;
+          a2 ^= c1;
+          a3 |= c2; // 隣接数は最大8なので、これより上の桁は無い
+        }
+      }
+
+      /* 隣接数がnのレーンにルールを当てる */
+      uint64_t alive = board[y][x];
+      uint64_t result = 0;
+      for (int n=0; n<=8; n++) {
+        if ((born_mask[n] | survive_mask[n]) == 0) continue;
+        uint64_t eq = ((n & 1) ? a0 : ~a0) & ((n & 2) ? a1 : ~a1) & ((n & 4) ? a2 : ~a2) & ((n & 8) ? a3 : ~a3);
+        result |= eq & ((~alive & born_mask[n]) | (alive & survive_mask[n]));
+      }
+      next[y][x] = result;
+    }
+  }
+}
+
+/*
+  レーンlaneの盤面をint配列に取り出す関数
+*/
+void extract_lane(const int height, const int width, uint64_t board[height][width], int lane, int cell[height][width]) {
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      cell[y][x] = (board[y][x] >> lane) & 1;
+    }
+  }
+}
+
+/*
+  レーンごとに生きているセルを数える関数
+*/
+void count_lanes(const int height, const int width, uint64_t board[height][width], long counts[LANES]) {
+
+  for (int l=0; l<LANES; l++) counts[l] = 0;
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      uint64_t w = board[y][x];
+      while (w != 0) {
+        counts[__builtin_ctzll(w)]++;
+        w &= w - 1;
+      }
+    }
+  }
+}
+
+/*
+  初期状態の各レーンを、mylife3.cのmy_update_cells()でgens世代進めたものと比べる関数
+  全て一致すれば1を返す
+*/
+int check_lanes(const int height, const int width, uint64_t initial[height][width], uint64_t board[height][width], int gens) {
+
+  int (*cell)[width] = malloc(sizeof(int) * height * width);
+  int (*result)[width] = malloc(sizeof(int) * height * width);
+  int ok = 1;
+
+  for (int l=0; l<LANES; l++) {
+    for (int n=0; n<=8; n++) {
+      can_born[n] = (born_mask[n] >> l) & 1;
+      can_survive[n] = (survive_mask[n] >> l) & 1;
+    }
+
+    extract_lane(height, width, initial, l, cell);
+    for (int gen=0; gen<gens; gen++) my_update_cells(height, width, cell);
+    extract_lane(height, width, board, l, result);
+
+    if (memcmp(cell, result, sizeof(int) * height * width) != 0) {
+      fprintf(stderr, "lane %d differs from my_update_cells()\n", l);
+      ok = 0;
+    }
+  }
+
+  free(cell);
+  free(result);
+  return ok;
+}
+
+/*
+  初期状態からgens世代進めて結果を表示する関数
+*/
+int run_lanes(const int height, const int width, uint64_t board[height][width], int gens, int check) {
+
+  uint64_t (*initial)[width] = malloc(sizeof(uint64_t) * height * width);
+  uint64_t (*next)[width] = malloc(sizeof(uint64_t) * height * width);
+  memcpy(initial, board, sizeof(uint64_t) * height * width);
+
+  long before[LANES], after[LANES];
+  count_lanes(height, width, board, before);
+
+  clock_t start = clock();
+  for (int gen=0; gen<gens; gen++) {
+    lanes_update_cells(height, width, board, next);
+    memcpy(board, next, sizeof(uint64_t) * height * width);
+  }
+  double sec = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  count_lanes(height, width, board, after);
+
+  printf("lane  rule              alive(gen 0)  alive(gen %d)\n", gens);
+  for (int l=0; l<LANES; l++) {
+    char rule[24];
+    lane_rule_string(l, rule);
+    printf("%4d  %-16s  %12ld  %12ld\n", l, rule, before[l], after[l]);
+  }
+  printf("%dx%d x %d lanes x %d generations: %.3f s (%.2f ns/cell)\n", height, width, LANES, gens, sec,
+         sec * 1e9 / ((double)height * width * LANES * (gens > 0 ? gens : 1)));
+
+  int ok = 1;
+  if (check) {
+    ok = check_lanes(height, width, initial, board, gens);
+    printf("check: %s\n", ok ? "ok" : "MISMATCH");
+  }
+
+  free(initial);
+  free(next);
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char **argv)
+{
+  int check = 0;
+
+  if (argc >= 2 && strcmp(argv[1], "-c") == 0) {
+    check = 1;
+    argc--;
+    argv++;
+  }
+
+  srand(time(NULL));
+
+  if (argc >= 5 && argc <= 7 && strcmp(argv[1], "soup") == 0) {
+    int born[9], survive[9];
+    if (parse_rule(argv[2], born, survive) != 0) {
+      fprintf(stderr, "invalid rule %s\n", argv[2]);
+      return EXIT_FAILURE;
+    }
+    const int density = atoi(argv[3]);
+    const int gens = atoi(argv[4]);
+    const int height = (argc >= 6) ? atoi(argv[5]) : 40;
+    const int width = (argc >= 7) ? atoi(argv[6]) : 70;
+    if (height <= 0 || width <= 0) {
+      fprintf(stderr, "invalid size %dx%d\n", height, width);
+      return EXIT_FAILURE;
+    }
+
+    for (int l=0; l<LANES; l++) set_lane_rule(l, born, survive);
+
+    /* レーンごとに別のランダムな初期状態 */
+    uint64_t (*board)[width] = malloc(sizeof(uint64_t) * height * width);
+    for (int y=0; y<height; y++) {
+      for (int x=0; x<width; x++) {
+        uint64_t w = 0;
+        for (int l=0; l<LANES; l++) {
+          if (rand() % 100 < density) w |= 1ULL << l;
+        }
+        board[y][x] = w;
+      }
+    }
+
+    int result = run_lanes(height, width, board, gens, check);
+    free(board);
+    return result;
+
+  } else if (argc >= 3 && argc <= 4 && strcmp(argv[1], "rules") == 0) {
+    const int height = 40;
+    const int width = 70;
+    const int gens = atoi(argv[2]);
+
+    int cell[height][width];
+    for(int y = 0 ; y < height ; y++){
+      for(int x = 0 ; x < width ; x++){
+        cell[y][x] = 0;
+      }
+    }
+    int result = my_init_cells(height, width, cell, (argc == 4) ? argv[3] : "");
+    if (result != 0) return EXIT_FAILURE;
+
+    /* レーンlはB3/S(lのビットが立っている数) */
+    for (int l=0; l<LANES; l++) {
+      int born[9] = {0, 0, 0, 1, 0, 0, 0, 0, 0};
+      int survive[9] = {0};
+      for (int n=0; n<6; n++) survive[n] = (l >> n) & 1;
+      set_lane_rule(l, born, survive);
+    }
+
+    /* 全レーンに同じ初期状態を置く */
+    uint64_t board[height][width];
+    for (int y=0; y<height; y++) {
+      for (int x=0; x<width; x++) {
+        board[y][x] = cell[y][x] ? ~0ULL : 0;
+      }
+    }
+
+    return run_lanes(height, width, board, gens, check);
+  }
+
+  fprintf(stderr, "usage: %s [-c] soup [rule] [density] [generations] [height] [width]\n", argv[0]);
+  fprintf(stderr, "       %s [-c] rules [generations] [filename for init]\n", argv[0]);
+  return EXIT_FAILURE;
+}
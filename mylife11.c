@@ -0,0 +1,657 @@
+/*================================================================================================
+
+Larger-than-Life(範囲Rのルール)に対応
+
+mylife3.cのmy_count_adjacent_cells()はdy[], dx[]で隣接8セルだけを数えていた。
+ここでは半径Rの近傍を数えるLarger-than-Lifeのルールを扱う。RLEのヘッダーに
+  x = 100, y = 100, rule = R5,C0,M1,S34..58,B34..45,NM
+のように書かれたルールを読む。
+  R: 範囲(1〜MAX_RANGE)
+  C: 状態数(0か2のみ対応)
+  M: 1なら自分自身も数える
+  S, B: 生存・誕生する近傍の数の範囲(min..max)
+  N: M(Moore, 正方形)かN(von Neumann, ひし形)
+B3/S23のような普通のルールはR1,M0,NMとして扱う。
+
+1セルずつ(2R+1)^2個のセルを数えるとRの2乗に比例して遅くなるので、近傍の数はまとめて求める。
+  Moore      : 累積和の表(summed-area table)を作り、長方形の和を4回の参照で求める
+  von Neumann: 斜め方向(右下向き・左下向き)の累積和を作っておき、ひし形を1つ右にずらすときは
+               左端の「<」型の辺を引いて右端の「>」型の辺を足す。各辺は斜めの累積和2本で求まる。
+どちらも1セルあたりの計算量はRによらない(von Neumannは各行の最初のセルだけ直接数える)。
+盤面の外は死んでいるものとして扱う。
+
+-cを付けると、各世代で素朴に(2R+1)^2個数えた結果と比べて、違えば終了する。
+-rでルールを指定できる(ファイルのルールより優先する)。
+
+引数
+  [-c] [-r ルール] [初期状態のファイル(省略時はランダム)] [height] [width]
+
+実行例
+  ./a.out -r R5,C0,M1,S34..58,B34..45,NM "" 60 120
+  ./a.out -c -r R2,C0,M0,S2..5,B4..6,NN Pulsar.rle
+
+================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h> // sleep()関数を使う
+#include <time.h>
+#include <string.h>
+
+#define MAX_RANGE 10
+#define MAX_NEIGHBORS ((2*MAX_RANGE+1) * (2*MAX_RANGE+1)) // 自分自身を含めた近傍の数の最大値
+
+/* デフォルトのルール(B3/S23) */
+int can_survive[MAX_NEIGHBORS+1] = {0, 0, 1, 1, 0};
+int can_born[MAX_NEIGHBORS+1] = {0, 0, 0, 1, 0};
+int range = 1;           // 近傍の範囲R
+char neighborhood = 'M'; // 'M'ならMoore, 'N'ならvon Neumann
+int middle = 0;          // 1なら自分自身も近傍の数に含める
+char rule_name[64] = "B3/S23";
+int rule_fixed = 0;      // -rで指定されたらファイルのルールは無視する
+
+/*
+  "min..max"の形の範囲を読み、table[min]からtable[max]を1にする関数
+  読めなければ-1を返す
+*/
+int parse_range(const char str[], int table[]) {
+
+  int min, max;
+  if (sscanf(str, "%d..%d", &min, &max) != 2) {
+    if (sscanf(str, "%d", &min) != 1) return -1;
+    max = min;
+  }
+  if (min < 0 || max > MAX_NEIGHBORS || min > max) return -1;
+
+  for (int i=min; i<=max; i++) table[i] = 1;
+  return 0;
+}
+
+/*
+  ルールの文字列を読んでグローバルのルールを設定する関数
+  "R5,C0,M1,S34..58,B34..45,NM"のようなLarger-than-Lifeの形式と、"B3/S23"の形式に対応する
+  読めなければ-1を返す(その場合ルールは変えない)
+*/
+int parse_rule(const char str[]) {
+
+  int survive[MAX_NEIGHBORS+1] = {0};
+  int born[MAX_NEIGHBORS+1] = {0};
+  int r = 1, m = 0;
+  char n = 'M';
+
+  if (str[0] == 'R' || str[0] == 'r') {
+    char buffer[64];
+    strncpy(buffer, str, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = 0;
+
+    for (char *token = strtok(buffer, ","); token != NULL; token = strtok(NULL, ",")) {
+      char c = token[0];
+      if (c == 'R' || c == 'r') {
+        r = atoi(token + 1);
+      } else if (c == 'C' || c == 'c') {
+        int states = atoi(token + 1);
+        if (states != 0 && states != 2) return -1; // 3状態以上は対応しない
+      } else if (c == 'M' || c == 'm') {
+        m = atoi(token + 1);
+      } else if (c == 'S' || c == 's') {
+        if (parse_range(token + 1, survive) != 0) return -1;
+      } else if (c == 'B' || c == 'b') {
+        if (parse_range(token + 1, born) != 0) return -1;
+      } else if (c == 'N' || c == 'n') {
+        n = (token[1] == 'N' || token[1] == 'n') ? 'N' : 'M';
+      } else {
+        return -1;
+      }
+    }
+    if (r < 1 || MAX_RANGE < r) return -1;
+
+  } else {
+    int *target = NULL;
+    for (int i=0; str[i] != 0; i++) {
+      char c = str[i];
+      if (c == 'B' || c == 'b') {
+        target = born;
+      } else if (c == 'S' || c == 's') {
+        target = survive;
+      } else if ('0' <= c && c <= '8' && target != NULL) {
+        target[c - '0'] = 1;
+      } else if (c != '/') {
+        return -1;
+      }
+    }
+  }
+
+  memcpy(can_survive, survive, sizeof(can_survive));
+  memcpy(can_born, born, sizeof(can_born));
+  range = r;
+  middle = m;
+  neighborhood = n;
+  strncpy(rule_name, str, sizeof(rule_name) - 1);
+  rule_name[sizeof(rule_name) - 1] = 0;
+  return 0;
+}
+
+/*
+  文字列strの最後がsuffixに一致するか判定する関数
+*/
+int ends_with(const char str[], const char suffix[]) {
+
+  int len_str = strlen(str);
+  int len_suf = strlen(suffix);
+
+  if (len_str < len_suf) return 0;
+
+  char lower_str[255];
+  char lower_suffix[255];
+  strcpy(lower_str, str);
+  strcpy(lower_suffix, suffix);
+
+  /* 大文字は全て小文字にする */
+  for (int i=0; lower_str[i] != 0; i++) {
+    if ('A' <= lower_str[i] && lower_str[i] <= 'Z') {
+      lower_str[i] += 'a' - 'A';
+    }
+  }
+  for (int i=0; lower_suffix[i] != 0; i++) {
+    if ('A' <= lower_suffix[i] && lower_suffix[i] <= 'Z') {
+      lower_suffix[i] += 'a' - 'A';
+    }
+  }
+
+  return (strcmp(lower_str + len_str - len_suf, lower_suffix) == 0);
+}
+
+/*
+  文字列を10進数で表した時の長さを返す関数
+  ただし、0の長さは0とする
+*/
+int number_len(int n) {
+  int len = 0;
+  while(n > 0) {
+    len++;
+    n /= 10;
+  }
+
+  return len;
+}
+
+/*
+  文字が空白、タブ、CR、LFのいずれかなら1を返す関数
+*/
+int isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+int loadRLE(const int height, const int width, int cell[height][width], FILE *fp) {
+
+  char buffer[(int)1e4+1]; // 1行は70文字以下だが念のため
+  int y = 0, x = 0;
+  int offsetY = 0, offsetX = 0;
+  while(fgets(buffer, 1e4, fp) != NULL) {
+
+    /* オフセット指定以外のヘッダー情報は読み飛ばす */
+    if (buffer[0] == '#') {
+      if (buffer[1] == 'P' || buffer[1] == 'R') {
+        sscanf(buffer+2, "%d%d", &offsetX, &offsetY);
+        if (offsetY < 0 || offsetX < 0) {
+          offsetY = 0;
+          offsetX = 0;
+        } else {
+          y = offsetY;
+          x = offsetX;
+        }
+      }
+      continue;
+    }
+
+    /* サイズ情報は読み飛ばし、ルールは反映する */
+    if (buffer[0] == 'x') {
+      char rule[64];
+      if (sscanf(buffer, "x = %*d, y = %*d, rule = %63s", rule) == 1 && !rule_fixed) {
+        if (parse_rule(rule) != 0) {
+          fprintf(stderr, "Unsupported rule %s\n", rule);
+          return EXIT_FAILURE;
+        }
+      }
+      continue;
+    }
+
+    int offset = 0; // 行の何文字目を次に読むか
+    while(1) {
+      int len = 0; // ランの長さ
+      char c; // タグ('o', 'b', '$', '!'のいずれか)
+
+      // 途中に空白が入っても対応可能
+      while(isWhitespace(buffer[offset])) offset++;
+
+      // ランの長さを取得(1が省略されている場合は何も読み込まない)
+      int result = sscanf(buffer+offset, "%d", &len);
+      // 読み込んだ分だけoffsetを加算(ただし0のままの場合は読みこんでないのでそのまま)
+      offset += number_len(len);
+
+      // 長さ省略時は1
+      if (len == 0) len = 1;
+
+      // ランのタグを取得
+      result = sscanf(buffer+offset, "%c", &c);
+      offset++;
+
+      if (result <= 0 || c == '!') { // 終了
+        break;
+      } else if (c == '$') { // 改行
+        y += len;
+        x = offsetX;
+      } else if (c == 'b') { // dead
+        x += len;
+      } else if (c == 'o') { // alive
+        for (int i=0; i<len; i++) {
+          if (0 <= y && y < height && 0 <= x && x < width) cell[y][x] = 1; // 盤面の外は無視する
+          x++;
+        }
+      } else {
+        fprintf(stderr,"Invalid syntax\n");
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ ファイルによるセルの初期化: 生きているセルの座標が記述されたファイルをもとに2次元配列の状態を初期化する
+ fp = NULL のときは、関数内で適宜定められた初期状態に初期化する。関数内初期値はdefault.lif と同じもの
+ */
+int my_init_cells(const int height, const int width, int cell[height][width], char filename[]) {
+
+  if (filename[0] == 0) {
+    /* ランダムに配置する */
+    srand(time(NULL));
+
+    for (int y=0; y<height; y++) {
+      for (int x=0; x<width; x++) {
+        cell[y][x] = (rand() % 10 == 0 ? 1 : 0);
+      }
+    }
+  } else {
+
+    FILE *fp = fopen(filename,"r");
+    if (fp == NULL) {
+      fprintf(stderr,"cannot open file %s\n", filename);
+      return EXIT_FAILURE;
+    }
+
+    if (ends_with(filename, ".lif")) {
+
+      fscanf(fp, "%*[^\n]\n"); // バージョン情報は読み飛ばす
+
+      int x, y;
+      while (fscanf(fp, "%d%d", &x, &y) > 0) {
+        if (0 <= y && y < height && 0 <= x && x < width) cell[y][x] = 1; // 盤面の外は無視する
+      }
+
+    } else if (ends_with(filename, ".rle")) {
+
+      int result = loadRLE(height, width, cell, fp);
+      if (result != 0) return EXIT_FAILURE;
+
+    } else {
+
+      fprintf(stderr,"Supported: .lif .rle\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ グリッドの描画: 世代情報とグリッドの配列等を受け取り、ファイルポインタに該当する出力にグリッドを描画する
+ */
+void my_print_cells(FILE *fp, int gen, const int height, const int width, int cell[height][width]) {
+
+  /* 0,1それぞれの状態のセルをカウント */
+  int count_cells[2] = {0, 0};
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      count_cells[cell[y][x]]++;
+    }
+  }
+
+  // 世代情報と存在比を表示
+  fprintf(fp, "rule: %s, generateion = %d, alive:dead = %7d:%7d\r\n", rule_name, gen, count_cells[1], count_cells[0]);
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  /* グリッド */
+  for (int y=0; y<height; y++) {
+    fprintf(fp, "|");
+    for (int x=0; x<width; x++) {
+      fprintf(fp, "\e[31m%c\e[0m", (cell[y][x] ? '#' : ' ')); // 赤色で表示
+    }
+    fprintf(fp, "|\r\n");
+  }
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  fflush(fp);
+}
+
+int in_cells(int y, int x, const int height, const int width) {
+
+  if (y < 0 || height <= y) return 0;
+  if (x < 0 || width <= x) return 0;
+
+  return 1;
+}
+
+/*
+ 着目するセルの周辺の生きたセルをカウントする関数
+ */
+int my_count_adjacent_cells(int y, int x, const int height, const int width, int cell[height][width]) {
+
+  /*
+    dy, dx: 相対位置
+    012
+    7.3
+    654
+  */
+  int dy[] = {-1, -1, -1, 0, 1, 1, 1, 0};
+  int dx[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+
+  int count = 0;
+  
+  for (int i=0; i<8; i++) {
+
+    int ny = y + dy[i];
+    int nx = x + dx[i];
+
+    if (in_cells(ny, nx, height, width) && cell[ny][nx]) {
+      count++;
+    }
+
+  }
+
+  return count;
+}
+
+/*
+  着目するセルの次の世代での状態を返す関数
+*/
+int next_state(int y, int x, const int height, const int width, int cell[height][width], int neighbors) {
+
+  if (cell[y][x]) { 
+    return can_survive[neighbors];
+  } else {
+    return can_born[neighbors];
+  }
+
+}
+
+/*
+ ライフゲームのルールに基づいて2次元配列の状態を更新する
+ */
+void my_update_cells(const int height, const int width, int cell[height][width]) {
+
+  int next_cell[height][width];
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      next_cell[y][x] = 0;
+    }
+  }
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      int neighbors = my_count_adjacent_cells(y, x, height, width, cell);
+      next_cell[y][x] = next_state(y, x, height, width, cell, neighbors);
+    }
+  }
+
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      cell[y][x] = next_cell[y][x];
+    }
+  }
+
+}
+
+/*------------------------------------------------------------------------------------------------
+  Moore近傍: 累積和の表
+  sat[y][x]はcell[0..y-1][0..x-1]の和(sat[0][*] = sat[*][0] = 0)
+------------------------------------------------------------------------------------------------*/
+
+/*
+  長方形[y1,y2]x[x1,x2]の和を返す関数(盤面の外にはみ出した部分は0として扱う)
+*/
+int rect_sum(const int height, const int width, int sat[height+1][width+1], int y1, int x1, int y2, int x2) {
+
+  if (y1 < 0) y1 = 0;
+  if (x1 < 0) x1 = 0;
+  if (y2 > height - 1) y2 = height - 1;
+  if (x2 > width - 1) x2 = width - 1;
+  if (y1 > y2 || x1 > x2) return 0;
+
+  return sat[y2+1][x2+1] - sat[y1][x2+1] - sat[y2+1][x1] + sat[y1][x1];
+}
+
+void count_moore(const int height, const int width, int cell[height][width], int count[height][width]) {
+
+  int (*sat)[width+1] = malloc(sizeof(int) * (height + 1) * (width + 1));
+
+  for (int x=0; x<=width; x++) sat[0][x] = 0;
+  for (int y=0; y<height; y++) {
+    int row = 0;
+    sat[y+1][0] = 0;
+    for (int x=0; x<width; x++) {
+      row += cell[y][x];
+      sat[y+1][x+1] = sat[y][x+1] + row;
+    }
+  }
+
+  const int r = range;
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      count[y][x] = rect_sum(height, width, sat, y-r, x-r, y+r, x+r);
+    }
+  }
+
+  free(sat);
+}
+
+/*------------------------------------------------------------------------------------------------
+  von Neumann近傍: 斜めの累積和
+  dr[y][x]: (y,x)から左上に向かって盤面の端までの和(右下向きの対角線の累積和)
+  dl[y][x]: (y,x)から右上に向かって盤面の端までの和(左下向きの対角線の累積和)
+------------------------------------------------------------------------------------------------*/
+
+/*
+  (y,x)から右下に向かうlen個のセルの和を返す関数(盤面の外は0)
+*/
+int diag_dr_sum(const int height, const int width, int dr[height][width], int y, int x, int len) {
+
+  /* 盤面に入っている区間 t_lo <= t <= t_hi を求める */
+  int t_lo = 0, t_hi = len - 1;
+  if (t_lo < -y) t_lo = -y;
+  if (t_lo < -x) t_lo = -x;
+  if (t_hi > height - 1 - y) t_hi = height - 1 - y;
+  if (t_hi > width - 1 - x) t_hi = width - 1 - x;
+  if (t_lo > t_hi) return 0;
+
+  int sum = dr[y + t_hi][x + t_hi];
+  if (y + t_lo > 0 && x + t_lo > 0) sum -= dr[y + t_lo - 1][x + t_lo - 1];
+  return sum;
+}
+
+/*
+  (y,x)から左下に向かうlen個のセルの和を返す関数(盤面の外は0)
+*/
+int diag_dl_sum(const int height, const int width, int dl[height][width], int y, int x, int len) {
+
+  int t_lo = 0, t_hi = len - 1;
+  if (t_lo < -y) t_lo = -y;
+  if (t_lo < x - (width - 1)) t_lo = x - (width - 1);
+  if (t_hi > height - 1 - y) t_hi = height - 1 - y;
+  if (t_hi > x) t_hi = x;
+  if (t_lo > t_hi) return 0;
+
+  int sum = dl[y + t_hi][x - t_hi];
+  if (y + t_lo > 0 && x - t_lo < width - 1) sum -= dl[y + t_lo - 1][x - t_lo + 1];
+  return sum;
+}
+
+void count_von_neumann(const int height, const int width, int cell[height][width], int count[height][width]) {
+
+  int (*dr)[width] = malloc(sizeof(int) * height * width);
+  int (*dl)[width] = malloc(sizeof(int) * height * width);
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      dr[y][x] = cell[y][x] + ((y > 0 && x > 0) ? dr[y-1][x-1] : 0);
+      dl[y][x] = cell[y][x] + ((y > 0 && x < width - 1) ? dl[y-1][x+1] : 0);
+    }
+  }
+
+  const int r = range;
+  for (int y=0; y<height; y++) {
+
+    /* 行の最初のセルだけ直接数える */
+    int sum = 0;
+    for (int dy=-r; dy<=r; dy++) {
+      int reach = r - abs(dy);
+      for (int dx=-reach; dx<=reach; dx++) {
+        if (in_cells(y+dy, dx, height, width)) sum += cell[y+dy][dx];
+      }
+    }
+    count[y][0] = sum;
+
+    for (int x=1; x<width; x++) {
+      /* 左端の「<」型の辺(x-1を中心とするひし形の左端) */
+      int left = diag_dl_sum(height, width, dl, y-r, x-1, r+1) + diag_dr_sum(height, width, dr, y, x-1-r, r+1);
+      if (in_cells(y, x-1-r, height, width)) left -= cell[y][x-1-r];
+
+      /* 右端の「>」型の辺(xを中心とするひし形の右端) */
+      int right = diag_dr_sum(height, width, dr, y-r, x, r+1) + diag_dl_sum(height, width, dl, y, x+r, r+1);
+      if (in_cells(y, x+r, height, width)) right -= cell[y][x+r];
+
+      sum += right - left;
+      count[y][x] = sum;
+    }
+  }
+
+  free(dr);
+  free(dl);
+}
+
+/*
+  近傍の数を素朴に数える関数(確認用)
+*/
+int naive_count(int y, int x, const int height, const int width, int cell[height][width]) {
+
+  int count = 0;
+  for (int dy=-range; dy<=range; dy++) {
+    for (int dx=-range; dx<=range; dx++) {
+      if (neighborhood == 'N' && abs(dy) + abs(dx) > range) continue;
+      if (dy == 0 && dx == 0 && !middle) continue;
+      if (in_cells(y+dy, x+dx, height, width)) count += cell[y+dy][x+dx];
+    }
+  }
+  return count;
+}
+
+/*
+  Larger-than-Lifeのルールに基づいて2次元配列の状態を更新する
+  checkが1なら、素朴に数えた近傍の数と一致するか確認する(一致しなければ-1を返す)
+ */
+int my_update_cells_ltl(const int height, const int width, int cell[height][width], int check) {
+
+  int (*count)[width] = malloc(sizeof(int) * height * width);
+
+  /* 近傍の数(自分自身も含む) */
+  if (neighborhood == 'N') {
+    count_von_neumann(height, width, cell, count);
+  } else {
+    count_moore(height, width, cell, count);
+  }
+
+  int result = 0;
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      int neighbors = count[y][x] - (middle ? 0 : cell[y][x]);
+      if (check && neighbors != naive_count(y, x, height, width, cell)) result = -1;
+      count[y][x] = neighbors;
+    }
+  }
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      cell[y][x] = next_state(y, x, height, width, cell, count[y][x]);
+    }
+  }
+
+  free(count);
+  return result;
+}
+
+int main(int argc, char **argv)
+{
+  FILE *fp = stdout;
+  int check = 0;
+
+  /* オプション */
+  while (argc >= 2 && argv[1][0] == '-') {
+    if (strcmp(argv[1], "-c") == 0) {
+      check = 1;
+    } else if (strcmp(argv[1], "-r") == 0 && argc >= 3) {
+      if (parse_rule(argv[2]) != 0) {
+        fprintf(stderr, "Unsupported rule %s\n", argv[2]);
+        return EXIT_FAILURE;
+      }
+      rule_fixed = 1;
+      argc--;
+      argv++;
+    } else {
+      break;
+    }
+    argc--;
+    argv++;
+  }
+
+  if (argc > 4) {
+    fprintf(stderr, "usage: %s [-c] [-r rule] [filename for init] [height] [width]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const int height = (argc >= 3) ? atoi(argv[2]) : 40;
+  const int width = (argc >= 4) ? atoi(argv[3]) : 70;
+  if (height <= 0 || width <= 0) {
+    fprintf(stderr, "invalid size %dx%d\n", height, width);
+    return EXIT_FAILURE;
+  }
+
+  int (*cell)[width] = calloc((size_t)height * width, sizeof(int));
+
+  /* ファイルを引数にとるか、ない場合はデフォルトの初期値を使う */
+  int result = my_init_cells(height, width, cell, (argc >= 2) ? argv[1] : "");
+  if (result != 0) return EXIT_FAILURE;
+
+  my_print_cells(fp, 0, height, width, cell); // 表示する
+
+  /* 世代を進める*/
+  for (int gen = 1 ;; gen++) {
+    if (my_update_cells_ltl(height, width, cell, check) != 0) { // セルを更新
+      fprintf(stderr, "generation %d: neighbor count differs from naive count\n", gen);
+      return EXIT_FAILURE;
+    }
+    my_print_cells(fp, gen, height, width, cell);  // 表示する
+    usleep(200*1000); //0.2秒休止する
+    fprintf(fp,"\e[%dA",height+3);//height+3 の分、カーソルを上に戻す(壁2、表示部1)
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,604 @@
+/*================================================================================================
+
+大きな盤面のためのメモリ確保(ヒュージページとNUMA)
+
+盤面が大きくなると、TLBミスや、別のNUMAノードにあるメモリへのアクセスが目立つようになる。
+盤面の配列(cellとnext_cell)を次の順に確保を試みる。
+  1. 明示的なヒュージページ(mmapのMAP_HUGETLB, /proc/sys/vm/nr_hugepagesで予約されている場合)
+  2. 透過的ヒュージページ(THP, 通常のmmapの後にmadvise(MADV_HUGEPAGE))
+  3. 通常のページ(malloc)
+盤面がヒュージページ1枚(HUGE_PAGE_SIZE)より小さいときは通常のページにする。
+どの方法になったかは起動時に標準エラー出力に表示する。
+
+複数スレッドで更新するときは、盤面を横の帯に分けて各スレッドが1つの帯を担当する。
+Linuxはページを最初に書き込んだスレッドが動いているNUMAノードにメモリを割り当てる(first touch)ので、
+mmapで確保した直後のまだ触っていない配列を、各スレッドが自分の担当する帯だけ0で初期化する。
+スレッドはCPUに固定し、最後まで同じスレッドが同じ帯を更新するので、帯のメモリはそのスレッドのノードに乗る。
+(mallocにフォールバックした場合は、確保した時点で既に触られていることがあるので効果は保証されない。)
+
+-gで世代数を指定すると表示せずにその世代数だけ進め、かかった時間を表示する。
+
+コンパイル
+  gcc -O2 -pthread mylife13.c
+
+引数
+  [-t スレッド数] [-g 世代数] [初期状態のファイル(省略時はランダム)] [height] [width]
+
+実行例
+  ./a.out -t 4 gosperglidergun.lif
+  ./a.out -t 8 -g 100 "" 8192 8192
+
+================================================================================================*/
+
+#define _GNU_SOURCE // pthread_setaffinity_np()を使う
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h> // sleep()関数を使う
+#include <time.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+/* デフォルトのルール */
+int can_survive[9] = {0, 0, 1, 1, 0};
+int can_born[9] = {0, 0, 0, 1, 0};
+char rule_S[10] = "23";
+char rule_B[10] = "3";
+
+/*
+  文字列strの最後がsuffixに一致するか判定する関数
+*/
+int ends_with(const char str[], const char suffix[]) {
+
+  int len_str = strlen(str);
+  int len_suf = strlen(suffix);
+
+  if (len_str < len_suf) return 0;
+
+  char lower_str[255];
+  char lower_suffix[255];
+  strcpy(lower_str, str);
+  strcpy(lower_suffix, suffix);
+
+  /* 大文字は全て小文字にする */
+  for (int i=0; lower_str[i] != 0; i++) {
+    if ('A' <= lower_str[i] && lower_str[i] <= 'Z') {
+      lower_str[i] += 'a' - 'A';
+    }
+  }
+  for (int i=0; lower_suffix[i] != 0; i++) {
+    if ('A' <= lower_suffix[i] && lower_suffix[i] <= 'Z') {
+      lower_suffix[i] += 'a' - 'A';
+    }
+  }
+
+  return (strcmp(lower_str + len_str - len_suf, lower_suffix) == 0);
+}
+
+/*
+  文字列を10進数で表した時の長さを返す関数
+  ただし、0の長さは0とする
+*/
+int number_len(int n) {
+  int len = 0;
+  while(n > 0) {
+    len++;
+    n /= 10;
+  }
+
+  return len;
+}
+
+/*
+  文字が空白、タブ、CR、LFのいずれかなら1を返す関数
+*/
+int isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+int loadRLE(const int height, const int width, int cell[height][width], FILE *fp) {
+
+  char buffer[(int)1e4+1]; // 1行は70文字以下だが念のため
+  int y = 0, x = 0;
+  int offsetY = 0, offsetX = 0;
+  while(fgets(buffer, 1e4, fp) != NULL) {
+
+    /* オフセット指定以外のヘッダー情報は読み飛ばす */
+    if (buffer[0] == '#') {
+      if (buffer[1] == 'P' || buffer[1] == 'R') {
+        sscanf(buffer+2, "%d%d", &offsetX, &offsetY);
+        if (offsetY < 0 || offsetX < 0) {
+          offsetY = 0;
+          offsetX = 0;
+        } else {
+          y = offsetY;
+          x = offsetX;
+        }
+      }
+      continue;
+    }
+
+    /* サイズ情報は読み飛ばし、ルールは反映する */
+    if (buffer[0] == 'x') {
+      int result = sscanf(buffer, "x = %*d, y = %*d, rule = B%9[^/n]/S%9s", rule_B, rule_S);
+
+      for (int i=0; i<=8; i++) {
+        can_survive[i] = 0;
+        can_born[i] = 0;
+      }
+
+      for (int i=0; i<10; i++) {
+        int s = rule_S[i] - '0';
+        int b = rule_B[i] - '0';
+        if (0 <= s && s <= 8) can_survive[s] = 1;
+        if (0 <= b && b <= 8) can_born[b] = 1;
+      }
+
+      continue;
+    }
+
+    int offset = 0; // 行の何文字目を次に読むか
+    while(1) {
+      int len = 0; // ランの長さ
+      char c; // タグ('o', 'b', '$', '!'のいずれか)
+
+      // 途中に空白が入っても対応可能
+      while(isWhitespace(buffer[offset])) offset++;
+
+      // ランの長さを取得(1が省略されている場合は何も読み込まない)
+      int result = sscanf(buffer+offset, "%d", &len);
+      // 読み込んだ分だけoffsetを加算(ただし0のままの場合は読みこんでないのでそのまま)
+      offset += number_len(len);
+
+      // 長さ省略時は1
+      if (len == 0) len = 1;
+
+      // ランのタグを取得
+      result = sscanf(buffer+offset, "%c", &c);
+      offset++;
+
+      if (result <= 0 || c == '!') { // 終了
+        break;
+      } else if (c == '$') { // 改行
+        y += len;
+        x = offsetX;
+      } else if (c == 'b') { // dead
+        x += len;
+      } else if (c == 'o') { // alive
+        for (int i=0; i<len; i++) {
+          if (0 <= y && y < height && 0 <= x && x < width) cell[y][x] = 1; // 盤面の外は無視する
+          x++;
+        }
+      } else {
+        fprintf(stderr,"Invalid syntax\n");
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ ファイルによるセルの初期化: 生きているセルの座標が記述されたファイルをもとに2次元配列の状態を初期化する
+ fp = NULL のときは、関数内で適宜定められた初期状態に初期化する。関数内初期値はdefault.lif と同じもの
+ */
+int my_init_cells(const int height, const int width, int cell[height][width], char filename[]) {
+
+  if (filename[0] == 0) {
+    /* ランダムに配置する */
+    srand(time(NULL));
+
+    for (int y=0; y<height; y++) {
+      for (int x=0; x<width; x++) {
+        cell[y][x] = (rand() % 10 == 0 ? 1 : 0);
+      }
+    }
+  } else {
+
+    FILE *fp = fopen(filename,"r");
+    if (fp == NULL) {
+      fprintf(stderr,"cannot open file %s\n", filename);
+      return EXIT_FAILURE;
+    }
+
+    if (ends_with(filename, ".lif")) {
+
+      fscanf(fp, "%*[^\n]\n"); // バージョン情報は読み飛ばす
+
+      int x, y;
+      while (fscanf(fp, "%d%d", &x, &y) > 0) {
+        if (0 <= y && y < height && 0 <= x && x < width) cell[y][x] = 1; // 盤面の外は無視する
+      }
+
+    } else if (ends_with(filename, ".rle")) {
+
+      int result = loadRLE(height, width, cell, fp);
+      if (result != 0) return EXIT_FAILURE;
+
+    } else {
+
+      fprintf(stderr,"Supported: .lif .rle\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ グリッドの描画: 世代情報とグリッドの配列等を受け取り、ファイルポインタに該当する出力にグリッドを描画する
+ */
+void my_print_cells(FILE *fp, int gen, const int height, const int width, int cell[height][width]) {
+
+  /* 0,1それぞれの状態のセルをカウント */
+  int count_cells[2] = {0, 0};
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      count_cells[cell[y][x]]++;
+    }
+  }
+
+  // 世代情報と存在比を表示
+  fprintf(fp, "rule: B%s/S%s, generateion = %d, alive:dead = %7d:%7d\r\n", rule_B, rule_S, gen, count_cells[1], count_cells[0]);
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  /* グリッド */
+  for (int y=0; y<height; y++) {
+    fprintf(fp, "|");
+    for (int x=0; x<width; x++) {
+      fprintf(fp, "\e[31m%c\e[0m", (cell[y][x] ? '#' : ' ')); // 赤色で表示
+    }
+    fprintf(fp, "|\r\n");
+  }
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  fflush(fp);
+}
+
+int in_cells(int y, int x, const int height, const int width) {
+
+  if (y < 0 || height <= y) return 0;
+  if (x < 0 || width <= x) return 0;
+
+  return 1;
+}
+
+/*
+ 着目するセルの周辺の生きたセルをカウントする関数
+ */
+int my_count_adjacent_cells(int y, int x, const int height, const int width, int cell[height][width]) {
+
+  /*
+    dy, dx: 相対位置
+    012
+    7.3
+    654
+  */
+  int dy[] = {-1, -1, -1, 0, 1, 1, 1, 0};
+  int dx[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+
+  int count = 0;
+  
+  for (int i=0; i<8; i++) {
+
+    int ny = y + dy[i];
+    int nx = x + dx[i];
+
+    if (in_cells(ny, nx, height, width) && cell[ny][nx]) {
+      count++;
+    }
+
+  }
+
+  return count;
+}
+
+/*
+  着目するセルの次の世代での状態を返す関数
+*/
+int next_state(int y, int x, const int height, const int width, int cell[height][width], int neighbors) {
+
+  if (cell[y][x]) { 
+    return can_survive[neighbors];
+  } else {
+    return can_born[neighbors];
+  }
+
+}
+
+/*
+ ライフゲームのルールに基づいて2次元配列の状態を更新する
+ */
+void my_update_cells(const int height, const int width, int cell[height][width]) {
+
+  int next_cell[height][width];
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      next_cell[y][x] = 0;
+    }
+  }
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      int neighbors = my_count_adjacent_cells(y, x, height, width, cell);
+      next_cell[y][x] = next_state(y, x, height, width, cell, neighbors);
+    }
+  }
+
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      cell[y][x] = next_cell[y][x];
+    }
+  }
+
+}
+
+/*------------------------------------------------------------------------------------------------
+  盤面のメモリ確保
+------------------------------------------------------------------------------------------------*/
+
+#define HUGE_PAGE_SIZE (2UL << 20) // x86-64のヒュージページ(2MB)
+
+enum { POLICY_HUGETLB, POLICY_THP, POLICY_NORMAL };
+
+const char *policy_names[] = {
+  "explicit huge pages (MAP_HUGETLB)",
+  "transparent huge pages (madvise)",
+  "normal pages",
+};
+
+typedef struct {
+  int *cells;
+  size_t size;  // 確保したバイト数(mmapの場合はページ境界に切り上げたもの)
+  int policy;
+} CellBuffer;
+
+/*
+  透過的ヒュージページが使えるか(/sys/kernel/mm/transparent_hugepage/enabledが[never]でないか)
+*/
+int thp_available() {
+
+  FILE *fp = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+  if (fp == NULL) return 0;
+
+  char buffer[128] = "";
+  fgets(buffer, sizeof(buffer), fp);
+  fclose(fp);
+  return strstr(buffer, "[never]") == NULL;
+}
+
+/*
+  盤面用のメモリを確保する関数
+  mmapで確保した場合はまだページに触っていないので、中身は最初に書き込んだスレッドのノードに乗る
+*/
+CellBuffer cell_alloc(size_t size) {
+
+  CellBuffer b;
+
+  if (size >= HUGE_PAGE_SIZE) {
+    size_t rounded = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+    void *p = mmap(NULL, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+      b.cells = p;
+      b.size = rounded;
+      b.policy = POLICY_HUGETLB;
+      return b;
+    }
+
+    if (thp_available()) {
+      p = mmap(NULL, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (p != MAP_FAILED) {
+        if (madvise(p, rounded, MADV_HUGEPAGE) == 0) {
+          b.cells = p;
+          b.size = rounded;
+          b.policy = POLICY_THP;
+          return b;
+        }
+        munmap(p, rounded);
+      }
+    }
+  }
+
+  b.cells = malloc(size);
+  b.size = size;
+  b.policy = POLICY_NORMAL;
+  return b;
+}
+
+void cell_free(CellBuffer *b) {
+
+  if (b->policy == POLICY_NORMAL) {
+    free(b->cells);
+  } else {
+    munmap(b->cells, b->size);
+  }
+  b->cells = NULL;
+}
+
+/*------------------------------------------------------------------------------------------------
+  複数スレッドによる更新
+  mainを含めたthreads+1個がbarrierで足並みをそろえる。
+------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+  int height;
+  int width;
+  int threads;
+  int *cell;      // 今の世代
+  int *next_cell; // 次の世代
+  int done;       // 1になったらスレッドは終了する
+  pthread_barrier_t barrier;
+} Shared;
+
+typedef struct {
+  int id;
+  Shared *shared;
+} Worker;
+
+/*
+  スレッドidが担当する帯の最初の行を返す関数(id = threadsなら盤面の高さ)
+*/
+int band_begin(int id, int threads, int height) {
+  return (int)((long)height * id / threads);
+}
+
+/*
+  帯の中のセルを1世代進める関数(結果はnext_cellに書く)
+*/
+void update_band(const int height, const int width, int cell[height][width], int next_cell[height][width], int begin, int end) {
+
+  for (int y=begin; y<end; y++) {
+    for (int x=0; x<width; x++) {
+      int neighbors = my_count_adjacent_cells(y, x, height, width, cell);
+      next_cell[y][x] = next_state(y, x, height, width, cell, neighbors);
+    }
+  }
+}
+
+void *worker_main(void *arg) {
+
+  Worker *w = arg;
+  Shared *s = w->shared;
+  const int height = s->height;
+  const int width = s->width;
+  const int begin = band_begin(w->id, s->threads, height);
+  const int end = band_begin(w->id + 1, s->threads, height);
+
+  /* このスレッドを1つのCPUに固定する */
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(w->id % sysconf(_SC_NPROCESSORS_ONLN), &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+  /* first touch: 自分の帯は自分で初期化する */
+  size_t offset = (size_t)begin * width;
+  size_t len = sizeof(int) * (size_t)(end - begin) * width;
+  memset(s->cell + offset, 0, len);
+  memset(s->next_cell + offset, 0, len);
+  pthread_barrier_wait(&s->barrier); // 初期化の完了
+
+  while (1) {
+    pthread_barrier_wait(&s->barrier); // 世代の開始(またはdoneの通知)
+    if (s->done) break;
+    update_band(height, width, (int (*)[width])s->cell, (int (*)[width])s->next_cell, begin, end);
+    pthread_barrier_wait(&s->barrier); // 世代の終了
+  }
+
+  return NULL;
+}
+
+double now_sec() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+  FILE *fp = stdout;
+  int threads = 1;
+  int gens = -1; // -1なら表示しながら無限に進める
+
+  /* オプション */
+  while (argc >= 3 && argv[1][0] == '-') {
+    if (strcmp(argv[1], "-t") == 0) {
+      threads = atoi(argv[2]);
+    } else if (strcmp(argv[1], "-g") == 0) {
+      gens = atoi(argv[2]);
+    } else {
+      break;
+    }
+    argc -= 2;
+    argv += 2;
+  }
+
+  if (argc > 4 || threads < 1) {
+    fprintf(stderr, "usage: %s [-t threads] [-g generations] [filename for init] [height] [width]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const int height = (argc >= 3) ? atoi(argv[2]) : 40;
+  const int width = (argc >= 4) ? atoi(argv[3]) : 70;
+  if (height <= 0 || width <= 0) {
+    fprintf(stderr, "invalid size %dx%d\n", height, width);
+    return EXIT_FAILURE;
+  }
+  if (threads > height) threads = height;
+
+  /* まだ触らずに確保だけする */
+  size_t size = sizeof(int) * (size_t)height * width;
+  CellBuffer a = cell_alloc(size);
+  CellBuffer b = cell_alloc(size);
+  if (a.cells == NULL || b.cells == NULL) {
+    fprintf(stderr, "cannot allocate %zu bytes\n", size);
+    return EXIT_FAILURE;
+  }
+  fprintf(stderr, "alloc: %dx%d cells, %s / %s, first touch by %d thread%s\n", height, width,
+          policy_names[a.policy], policy_names[b.policy], threads, threads > 1 ? "s" : "");
+
+  Shared shared;
+  shared.height = height;
+  shared.width = width;
+  shared.threads = threads;
+  shared.cell = a.cells;
+  shared.next_cell = b.cells;
+  shared.done = 0;
+  pthread_barrier_init(&shared.barrier, NULL, threads + 1);
+
+  pthread_t tids[threads];
+  Worker workers[threads];
+  for (int i=0; i<threads; i++) {
+    workers[i].id = i;
+    workers[i].shared = &shared;
+    pthread_create(&tids[i], NULL, worker_main, &workers[i]);
+  }
+  pthread_barrier_wait(&shared.barrier); // 各スレッドが自分の帯を初期化し終わるのを待つ
+
+  /* ファイルを引数にとるか、ない場合はデフォルトの初期値を使う */
+  int result = my_init_cells(height, width, (int (*)[width])shared.cell, (argc >= 2) ? argv[1] : "");
+  if (result != 0) return EXIT_FAILURE;
+
+  double start = now_sec();
+  if (gens < 0) my_print_cells(fp, 0, height, width, (int (*)[width])shared.cell); // 表示する
+
+  /* 世代を進める*/
+  for (int gen = 1 ; gens < 0 || gen <= gens; gen++) {
+    pthread_barrier_wait(&shared.barrier); // 各スレッドが帯を更新する
+    pthread_barrier_wait(&shared.barrier);
+
+    int *tmp = shared.cell;
+    shared.cell = shared.next_cell;
+    shared.next_cell = tmp;
+
+    if (gens < 0) {
+      my_print_cells(fp, gen, height, width, (int (*)[width])shared.cell);  // 表示する
+      usleep(200*1000); //0.2秒休止する
+      fprintf(fp,"\e[%dA",height+3);//height+3 の分、カーソルを上に戻す(壁2、表示部1)
+    }
+  }
+
+  double sec = now_sec() - start;
+  if (gens > 0) {
+    fprintf(stderr, "%d generations: %.3f s (%.3f ns/cell)\n", gens, sec, sec * 1e9 / ((double)height * width * gens));
+  }
+
+  shared.done = 1;
+  pthread_barrier_wait(&shared.barrier);
+  for (int i=0; i<threads; i++) pthread_join(tids[i], NULL);
+  pthread_barrier_destroy(&shared.barrier);
+
+  cell_free(&a);
+  cell_free(&b);
+  return EXIT_SUCCESS;
+}
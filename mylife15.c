@@ -0,0 +1,741 @@
+/*================================================================================================
+
+読み込んだパターンのキャッシュ
+
+同じパターンを何度も読み込むとき、毎回RLEやLife 1.06の文字列をfgets/sscanf/fscanfで解析するのは無駄なので、
+mylife14.cと同じ方法で一度読み込んだパターンを、そのままmmapで使える形のバイナリファイルに保存しておく。
+
+キャッシュファイル
+  場所  : CACHE_DIR(環境変数LIFE_CACHE_DIRで変更可)の下の「元ファイルの絶対パスのハッシュ.bin」
+  中身  : CacheHeader(外接する長方形、セル数、ルール、元ファイルの大きさと内容のハッシュ)
+          + 外接する長方形の中のセルを1bit/セルに詰めた行((幅+7)/8バイト x 高さ)
+元ファイルの内容のハッシュ(FNV-1a)がヘッダーのものと一致すればキャッシュは有効とみなし、
+mmapしたビット列からそのまま盤面を作る。一致しなければ(またはキャッシュが無ければ)解析し直して書き直す。
+書き込みは一時ファイルに書いてからrenameするので、途中で止まっても壊れたキャッシュは残らない。
+
+キャッシュを使ったかどうかは標準エラー出力に表示する。-nを付けるとキャッシュを使わずに毎回解析する。
+
+引数
+  [-n] [-m 余白(省略時は10)] [初期状態のファイル]
+
+実行例
+  ./a.out gosperglidergun.lif
+  LIFE_CACHE_DIR=/tmp/lifecache ./a.out -m 20 Bomber.rle
+
+================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h> // sleep()関数を使う
+#include <time.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* デフォルトのルール */
+int can_survive[9] = {0, 0, 1, 1, 0};
+int can_born[9] = {0, 0, 0, 1, 0};
+char rule_S[10] = "23";
+char rule_B[10] = "3";
+
+/*
+  文字列strの最後がsuffixに一致するか判定する関数
+*/
+int ends_with(const char str[], const char suffix[]) {
+
+  int len_str = strlen(str);
+  int len_suf = strlen(suffix);
+
+  if (len_str < len_suf) return 0;
+
+  char lower_str[255];
+  char lower_suffix[255];
+  strcpy(lower_str, str);
+  strcpy(lower_suffix, suffix);
+
+  /* 大文字は全て小文字にする */
+  for (int i=0; lower_str[i] != 0; i++) {
+    if ('A' <= lower_str[i] && lower_str[i] <= 'Z') {
+      lower_str[i] += 'a' - 'A';
+    }
+  }
+  for (int i=0; lower_suffix[i] != 0; i++) {
+    if ('A' <= lower_suffix[i] && lower_suffix[i] <= 'Z') {
+      lower_suffix[i] += 'a' - 'A';
+    }
+  }
+
+  return (strcmp(lower_str + len_str - len_suf, lower_suffix) == 0);
+}
+
+/*
+  文字列を10進数で表した時の長さを返す関数
+  ただし、0の長さは0とする
+*/
+int number_len(int n) {
+  int len = 0;
+  while(n > 0) {
+    len++;
+    n /= 10;
+  }
+
+  return len;
+}
+
+/*
+  文字が空白、タブ、CR、LFのいずれかなら1を返す関数
+*/
+int isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/*
+  パターン: 生きているセルの座標の一覧と外接する長方形
+*/
+typedef struct {
+  int count;
+  int capacity;
+  int *ys;
+  int *xs;
+  int min_y, min_x, max_y, max_x; // count = 0で長方形も無ければmin > max
+} Pattern;
+
+void pattern_init(Pattern *p) {
+
+  p->count = 0;
+  p->capacity = 0;
+  p->ys = NULL;
+  p->xs = NULL;
+  p->min_y = p->min_x = 1;
+  p->max_y = p->max_x = 0;
+}
+
+void pattern_free(Pattern *p) {
+  free(p->ys);
+  free(p->xs);
+}
+
+/*
+  外接する長方形に[y1,y2]x[x1,x2]を含める関数
+*/
+void pattern_extend(Pattern *p, int y1, int x1, int y2, int x2) {
+
+  if (p->min_y > p->max_y) {
+    p->min_y = y1;
+    p->min_x = x1;
+    p->max_y = y2;
+    p->max_x = x2;
+    return;
+  }
+  if (y1 < p->min_y) p->min_y = y1;
+  if (x1 < p->min_x) p->min_x = x1;
+  if (y2 > p->max_y) p->max_y = y2;
+  if (x2 > p->max_x) p->max_x = x2;
+}
+
+void pattern_add(Pattern *p, int y, int x) {
+
+  if (p->count == p->capacity) {
+    p->capacity = (p->capacity == 0) ? 256 : p->capacity * 2;
+    p->ys = realloc(p->ys, sizeof(int) * p->capacity);
+    p->xs = realloc(p->xs, sizeof(int) * p->capacity);
+  }
+  p->ys[p->count] = y;
+  p->xs[p->count] = x;
+  p->count++;
+  pattern_extend(p, y, x, y, x);
+}
+
+/*
+  数字の列からルールの表を作る関数
+*/
+void set_rule_table(const char digits[], int table[9]) {
+
+  for (int i=0; i<=8; i++) table[i] = 0;
+  for (int i=0; digits[i] != 0; i++) {
+    int n = digits[i] - '0';
+    if (0 <= n && n <= 8) table[n] = 1;
+  }
+}
+
+/*
+  RLEを読み込む関数(mylife3.cのloadRLE()を座標の一覧に書き込むようにしたもの)
+*/
+int loadRLE(Pattern *p, FILE *fp) {
+
+  char buffer[(int)1e4+1];
+  int y = 0, x = 0;
+  int offsetY = 0, offsetX = 0;
+  while(fgets(buffer, 1e4, fp) != NULL) {
+
+    /* オフセット指定以外のヘッダー情報は読み飛ばす(オフセットは負でもよい) */
+    if (buffer[0] == '#') {
+      if (buffer[1] == 'P' || buffer[1] == 'R') {
+        sscanf(buffer+2, "%d%d", &offsetX, &offsetY);
+        y = offsetY;
+        x = offsetX;
+      }
+      continue;
+    }
+
+    /* サイズ情報は外接する長方形に含め、ルールは反映する */
+    if (buffer[0] == 'x') {
+      int w = 0, h = 0;
+      int result = sscanf(buffer, "x = %d, y = %d, rule = B%9[^/n]/S%9s", &w, &h, rule_B, rule_S);
+      if (result >= 2 && w > 0 && h > 0) pattern_extend(p, offsetY, offsetX, offsetY + h - 1, offsetX + w - 1);
+      if (result == 4) {
+        set_rule_table(rule_B, can_born);
+        set_rule_table(rule_S, can_survive);
+      }
+      continue;
+    }
+
+    int offset = 0; // 行の何文字目を次に読むか
+    while(1) {
+      int len = 0; // ランの長さ
+      char c; // タグ('o', 'b', '$', '!'のいずれか)
+
+      // 途中に空白が入っても対応可能
+      while(isWhitespace(buffer[offset])) offset++;
+
+      // ランの長さを取得(1が省略されている場合は何も読み込まない)
+      int result = sscanf(buffer+offset, "%d", &len);
+      // 読み込んだ分だけoffsetを加算(ただし0のままの場合は読みこんでないのでそのまま)
+      offset += number_len(len);
+
+      // 長さ省略時は1
+      if (len == 0) len = 1;
+
+      // ランのタグを取得
+      result = sscanf(buffer+offset, "%c", &c);
+      offset++;
+
+      if (result <= 0 || c == '!') { // 終了
+        break;
+      } else if (c == '$') { // 改行
+        y += len;
+        x = offsetX;
+      } else if (c == 'b') { // dead
+        x += len;
+      } else if (c == 'o') { // alive
+        for (int i=0; i<len; i++) {
+          pattern_add(p, y, x);
+          x++;
+        }
+      } else {
+        fprintf(stderr,"Invalid syntax\n");
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+  Life 1.05を読み込む関数(1行目は読み込み済み)
+*/
+int loadLife105(Pattern *p, FILE *fp) {
+
+  char buffer[(int)1e4+1];
+  int y = 0, x = 0; // 今のブロックの今の行の左端
+  while(fgets(buffer, 1e4, fp) != NULL) {
+
+    if (buffer[0] == '#') {
+      if (buffer[1] == 'P') {
+        sscanf(buffer+2, "%d%d", &x, &y);
+      } else if (buffer[1] == 'N') {
+        set_rule_table("3", can_born);
+        set_rule_table("23", can_survive);
+        strcpy(rule_B, "3");
+        strcpy(rule_S, "23");
+      } else if (buffer[1] == 'R') {
+        /* Life 1.05のルールは 生存/誕生 の順 */
+        if (sscanf(buffer+2, " %9[0-8]/%9[0-8]", rule_S, rule_B) == 2) {
+          set_rule_table(rule_B, can_born);
+          set_rule_table(rule_S, can_survive);
+        }
+      }
+      continue;
+    }
+
+    for (int i=0; buffer[i] != 0 && !isWhitespace(buffer[i]); i++) {
+      if (buffer[i] == '*') {
+        pattern_add(p, y, x + i);
+      } else if (buffer[i] != '.') {
+        fprintf(stderr,"Invalid syntax\n");
+        return EXIT_FAILURE;
+      }
+    }
+    y++;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+  Life 1.06を読み込む関数(1行目は読み込み済み)
+*/
+int loadLife106(Pattern *p, FILE *fp) {
+
+  int x, y;
+  while (fscanf(fp, "%d%d", &x, &y) > 0) {
+    pattern_add(p, y, x);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ ファイルからパターンを読み込む関数
+ */
+int load_pattern(Pattern *p, const char filename[]) {
+
+  FILE *fp = fopen(filename,"r");
+  if (fp == NULL) {
+    fprintf(stderr,"cannot open file %s\n", filename);
+    return EXIT_FAILURE;
+  }
+
+  int result;
+  if (ends_with(filename, ".lif")) {
+
+    char version[255] = "";
+    fgets(version, sizeof(version), fp); // バージョン情報でLife 1.05か1.06かを判定する
+    if (strncmp(version, "#Life 1.05", 10) == 0) {
+      result = loadLife105(p, fp);
+    } else {
+      result = loadLife106(p, fp);
+    }
+
+  } else if (ends_with(filename, ".rle")) {
+
+    result = loadRLE(p, fp);
+
+  } else {
+
+    fprintf(stderr,"Supported: .lif .rle\n");
+    result = EXIT_FAILURE;
+  }
+
+  fclose(fp);
+  return result;
+}
+
+/*------------------------------------------------------------------------------------------------
+  キャッシュ
+------------------------------------------------------------------------------------------------*/
+
+#define CACHE_DIR ".lifecache"
+#define CACHE_MAGIC "LIFEPC01"
+
+typedef struct {
+  char magic[8];
+  uint64_t source_hash; // 元ファイルの内容のハッシュ
+  uint64_t source_size; // 元ファイルのバイト数
+  int32_t min_y, min_x, max_y, max_x; // 外接する長方形(空のパターンならmin > max)
+  int32_t count; // 生きているセルの数
+  char rule_B[10];
+  char rule_S[10];
+} CacheHeader;
+
+/*
+  1bit/セルに詰めたパターン
+  bitsはキャッシュをmmapした領域か、mallocした領域を指す
+*/
+typedef struct {
+  CacheHeader header;
+  const uint8_t *bits;
+  void *map;       // mmapした場合はその先頭(munmapに使う)
+  size_t map_size;
+  uint8_t *owned;  // mallocした場合はその領域
+} PackedPattern;
+
+uint64_t fnv1a(const void *data, size_t len, uint64_t h) {
+
+  const uint8_t *p = data;
+  for (size_t i=0; i<len; i++) {
+    h ^= p[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+/*
+  外接する長方形の1行のバイト数
+*/
+size_t row_bytes(const CacheHeader *h) {
+  return (h->max_x < h->min_x) ? 0 : (size_t)(h->max_x - h->min_x + 1 + 7) / 8;
+}
+
+size_t bits_size(const CacheHeader *h) {
+  return (h->max_y < h->min_y) ? 0 : row_bytes(h) * (h->max_y - h->min_y + 1);
+}
+
+/*
+  元ファイルの内容のハッシュを求める関数(mmapで読む)
+*/
+int hash_file(const char filename[], uint64_t *hash, uint64_t *size) {
+
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) return -1;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return -1;
+  }
+  *size = st.st_size;
+  *hash = 14695981039346656037ULL;
+
+  if (st.st_size > 0) {
+    void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      close(fd);
+      return -1;
+    }
+    *hash = fnv1a(p, st.st_size, *hash);
+    munmap(p, st.st_size);
+  }
+
+  close(fd);
+  return 0;
+}
+
+/*
+  元ファイルに対応するキャッシュファイルのパスを作る関数
+*/
+int cache_path(const char filename[], char path[], size_t len) {
+
+  char full[PATH_MAX];
+  if (realpath(filename, full) == NULL) return -1;
+
+  const char *dir = getenv("LIFE_CACHE_DIR");
+  if (dir == NULL || dir[0] == 0) dir = CACHE_DIR;
+  mkdir(dir, 0755); // 既にあれば何もしない
+
+  uint64_t key = fnv1a(full, strlen(full), 14695981039346656037ULL);
+  snprintf(path, len, "%s/%016llx.bin", dir, (unsigned long long)key);
+  return 0;
+}
+
+/*
+  キャッシュをmmapして、元ファイルと一致すれば使う関数(使えたら0を返す)
+*/
+int cache_open(const char path[], uint64_t source_hash, uint64_t source_size, PackedPattern *pp) {
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return -1;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(CacheHeader)) {
+    close(fd);
+    return -1;
+  }
+
+  void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) return -1;
+
+  const CacheHeader *h = p;
+  if (memcmp(h->magic, CACHE_MAGIC, 8) != 0 || h->source_hash != source_hash || h->source_size != source_size ||
+      (size_t)st.st_size != sizeof(CacheHeader) + bits_size(h)) {
+    munmap(p, st.st_size);
+    return -1;
+  }
+
+  pp->header = *h;
+  pp->bits = (const uint8_t *)p + sizeof(CacheHeader);
+  pp->map = p;
+  pp->map_size = st.st_size;
+  pp->owned = NULL;
+  return 0;
+}
+
+/*
+  座標の一覧のパターンを1bit/セルに詰める関数
+*/
+void pack_pattern(const Pattern *p, uint64_t source_hash, uint64_t source_size, PackedPattern *pp) {
+
+  CacheHeader *h = &pp->header;
+  memset(h, 0, sizeof(*h));
+  memcpy(h->magic, CACHE_MAGIC, 8);
+  h->source_hash = source_hash;
+  h->source_size = source_size;
+  h->min_y = p->min_y;
+  h->min_x = p->min_x;
+  h->max_y = p->max_y;
+  h->max_x = p->max_x;
+  h->count = p->count;
+  memcpy(h->rule_B, rule_B, sizeof(h->rule_B));
+  memcpy(h->rule_S, rule_S, sizeof(h->rule_S));
+
+  const size_t rb = row_bytes(h);
+  pp->owned = calloc(bits_size(h) + 1, 1);
+  for (int i=0; i<p->count; i++) {
+    int y = p->ys[i] - p->min_y;
+    int x = p->xs[i] - p->min_x;
+    pp->owned[y * rb + x / 8] |= 1 << (x % 8);
+  }
+  pp->bits = pp->owned;
+  pp->map = NULL;
+  pp->map_size = 0;
+}
+
+/*
+  キャッシュを書き出す関数(一時ファイルに書いてからrenameする)
+*/
+void cache_write(const char path[], const PackedPattern *pp) {
+
+  char tmp[PATH_MAX + 16];
+  snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int)getpid());
+
+  FILE *fp = fopen(tmp, "wb");
+  if (fp == NULL) return;
+
+  int ok = fwrite(&pp->header, sizeof(CacheHeader), 1, fp) == 1;
+  size_t size = bits_size(&pp->header);
+  if (size > 0) ok &= fwrite(pp->bits, 1, size, fp) == size;
+  ok &= fclose(fp) == 0;
+
+  if (!ok || rename(tmp, path) != 0) unlink(tmp);
+}
+
+void packed_pattern_free(PackedPattern *pp) {
+
+  if (pp->map != NULL) munmap(pp->map, pp->map_size);
+  free(pp->owned);
+}
+
+/*
+  パターンを読み込む関数
+  キャッシュが有効ならそれをmmapし、そうでなければload_pattern()で解析してキャッシュを書く
+*/
+int load_pattern_cached(const char filename[], int use_cache, PackedPattern *pp) {
+
+  uint64_t source_hash = 0, source_size = 0;
+  char path[PATH_MAX + 32];
+  use_cache = use_cache && hash_file(filename, &source_hash, &source_size) == 0 && cache_path(filename, path, sizeof(path)) == 0;
+
+  if (use_cache && cache_open(path, source_hash, source_size, pp) == 0) {
+    /* ルールはキャッシュから戻す */
+    memcpy(rule_B, pp->header.rule_B, sizeof(rule_B));
+    memcpy(rule_S, pp->header.rule_S, sizeof(rule_S));
+    rule_B[sizeof(rule_B) - 1] = 0;
+    rule_S[sizeof(rule_S) - 1] = 0;
+    set_rule_table(rule_B, can_born);
+    set_rule_table(rule_S, can_survive);
+    fprintf(stderr, "cache: hit %s\n", path);
+    return EXIT_SUCCESS;
+  }
+
+  Pattern pattern;
+  pattern_init(&pattern);
+  if (load_pattern(&pattern, filename) != 0) {
+    pattern_free(&pattern);
+    return EXIT_FAILURE;
+  }
+  if (pattern.min_y > pattern.max_y) pattern_extend(&pattern, 0, 0, 0, 0); // 空のパターン
+
+  pack_pattern(&pattern, source_hash, source_size, pp);
+  pattern_free(&pattern);
+
+  if (use_cache) {
+    cache_write(path, pp);
+    fprintf(stderr, "cache: miss, wrote %s\n", path);
+  }
+  return EXIT_SUCCESS;
+}
+
+/*
+ パターンを盤面に置く関数: パターンの外接する長方形の左上が(margin, margin)に来るようにずらす
+ */
+void my_init_cells(const int height, const int width, int cell[height][width], const PackedPattern *pp, int margin) {
+
+  const CacheHeader *h = &pp->header;
+  const size_t rb = row_bytes(h);
+
+  for (int y=0; y<=h->max_y - h->min_y; y++) {
+    const uint8_t *row = pp->bits + y * rb;
+    for (int x=0; x<=h->max_x - h->min_x; x++) {
+      cell[y + margin][x + margin] = (row[x / 8] >> (x % 8)) & 1;
+    }
+  }
+}
+
+/*
+ グリッドの描画: 世代情報とグリッドの配列等を受け取り、ファイルポインタに該当する出力にグリッドを描画する
+ */
+void my_print_cells(FILE *fp, int gen, const int height, const int width, int cell[height][width]) {
+
+  /* 0,1それぞれの状態のセルをカウント */
+  int count_cells[2] = {0, 0};
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      count_cells[cell[y][x]]++;
+    }
+  }
+
+  // 世代情報と存在比を表示
+  fprintf(fp, "rule: B%s/S%s, generateion = %d, alive:dead = %7d:%7d\r\n", rule_B, rule_S, gen, count_cells[1], count_cells[0]);
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  /* グリッド */
+  for (int y=0; y<height; y++) {
+    fprintf(fp, "|");
+    for (int x=0; x<width; x++) {
+      fprintf(fp, "\e[31m%c\e[0m", (cell[y][x] ? '#' : ' ')); // 赤色で表示
+    }
+    fprintf(fp, "|\r\n");
+  }
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  fflush(fp);
+}
+
+int in_cells(int y, int x, const int height, const int width) {
+
+  if (y < 0 || height <= y) return 0;
+  if (x < 0 || width <= x) return 0;
+
+  return 1;
+}
+
+/*
+ 着目するセルの周辺の生きたセルをカウントする関数
+ */
+int my_count_adjacent_cells(int y, int x, const int height, const int width, int cell[height][width]) {
+
+  /*
+    dy, dx: 相対位置
+    012
+    7.3
+    654
+  */
+  int dy[] = {-1, -1, -1, 0, 1, 1, 1, 0};
+  int dx[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+
+  int count = 0;
+  
+  for (int i=0; i<8; i++) {
+
+    int ny = y + dy[i];
+    int nx = x + dx[i];
+
+    if (in_cells(ny, nx, height, width) && cell[ny][nx]) {
+      count++;
+    }
+
+  }
+
+  return count;
+}
+
+/*
+  着目するセルの次の世代での状態を返す関数
+*/
+int next_state(int y, int x, const int height, const int width, int cell[height][width], int neighbors) {
+
+  if (cell[y][x]) { 
+    return can_survive[neighbors];
+  } else {
+    return can_born[neighbors];
+  }
+
+}
+
+/*
+ ライフゲームのルールに基づいて2次元配列の状態を更新する
+ */
+void my_update_cells(const int height, const int width, int cell[height][width]) {
+
+  int (*next_cell)[width] = malloc(sizeof(int) * height * width); // 大きな盤面ではスタックに置けない
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      int neighbors = my_count_adjacent_cells(y, x, height, width, cell);
+      next_cell[y][x] = next_state(y, x, height, width, cell, neighbors);
+    }
+  }
+
+  memcpy(cell, next_cell, sizeof(int) * height * width);
+  free(next_cell);
+}
+
+int main(int argc, char **argv)
+{
+  FILE *fp = stdout;
+  int margin = 10;
+  int use_cache = 1;
+
+  /* オプション */
+  while (argc >= 2 && argv[1][0] == '-') {
+    if (strcmp(argv[1], "-n") == 0) {
+      use_cache = 0;
+      argc--;
+      argv++;
+    } else if (strcmp(argv[1], "-m") == 0 && argc >= 3) {
+      margin = atoi(argv[2]);
+      argc -= 2;
+      argv += 2;
+    } else {
+      break;
+    }
+  }
+
+  if (argc > 2 || margin < 0) {
+    fprintf(stderr, "usage: %s [-n] [-m margin] [filename for init]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  PackedPattern pattern;
+  memset(&pattern, 0, sizeof(pattern));
+
+  int height = 40;
+  int width = 70;
+
+  /* ファイルを引数にとる場合はパターンの大きさに余白を足した盤面にする */
+  if (argc == 2) {
+    if (load_pattern_cached(argv[1], use_cache, &pattern) != 0) return EXIT_FAILURE;
+    height = pattern.header.max_y - pattern.header.min_y + 1 + 2 * margin;
+    width = pattern.header.max_x - pattern.header.min_x + 1 + 2 * margin;
+  }
+
+  int (*cell)[width] = calloc((size_t)height * width, sizeof(int));
+
+  if (argc == 2) {
+    my_init_cells(height, width, cell, &pattern, margin);
+    packed_pattern_free(&pattern);
+  } else {
+    /* ランダムに配置する */
+    srand(time(NULL));
+    for (int y=0; y<height; y++) {
+      for (int x=0; x<width; x++) {
+        cell[y][x] = (rand() % 10 == 0 ? 1 : 0);
+      }
+    }
+  }
+
+  my_print_cells(fp, 0, height, width, cell); // 表示する
+
+  /* 世代を進める*/
+  for (int gen = 1 ;; gen++) {
+    my_update_cells(height, width, cell); // セルを更新
+    my_print_cells(fp, gen, height, width, cell);  // 表示する
+    usleep(200*1000); //0.2秒休止する
+    fprintf(fp,"\e[%dA",height+3);//height+3 の分、カーソルを上に戻す(壁2、表示部1)
+  }
+
+  return EXIT_SUCCESS;
+}
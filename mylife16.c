@@ -0,0 +1,149 @@
+/*================================================================================================
+
+ライブラリ(lifelib.h)を使う例
+
+パターンファイルを読み込んでlife_load()に渡し、life_step()で世代を進める。
+表示のときだけlife_get_cells()で盤面をまとめて取り出し、mylife3.cと同じ形式で描く。
+-gで世代数を指定すると表示せずにまとめて進め、最後に統計だけを表示する。
+
+コンパイル(lifelib.hのビルドも参照)
+  gcc -O2 mylife16.c lifelib.c
+  gcc -O2 mylife16.c -L. -llife
+
+引数
+  [-g 世代数] [初期状態のファイル] [height] [width]
+
+実行例
+  ./a.out Bomber.rle
+  ./a.out -g 10000 gosperglidergun.lif 200 200
+
+================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h> // sleep()関数を使う
+#include <time.h>
+#include <string.h>
+#include "lifelib.h"
+
+/*
+  ファイルの中身を全て読み込む関数(lenにバイト数が入る)
+*/
+char *read_file(const char filename[], size_t *len) {
+
+  FILE *fp = fopen(filename, "rb");
+  if (fp == NULL) {
+    fprintf(stderr,"cannot open file %s\n", filename);
+    return NULL;
+  }
+
+  size_t cap = 4096;
+  char *text = malloc(cap);
+  *len = 0;
+  size_t n;
+  while ((n = fread(text + *len, 1, cap - *len, fp)) > 0) {
+    *len += n;
+    if (*len == cap) {
+      cap *= 2;
+      text = realloc(text, cap);
+    }
+  }
+
+  fclose(fp);
+  return text;
+}
+
+/*
+ グリッドの描画: 世代情報とグリッドの配列等を受け取り、ファイルポインタに該当する出力にグリッドを描画する
+ */
+void my_print_cells(FILE *fp, const life_stats *stats, const uint8_t cells[]) {
+
+  const int height = stats->height;
+  const int width = stats->width;
+
+  // 世代情報と存在比を表示
+  fprintf(fp, "generateion = %ld, alive:dead = %7ld:%7ld\r\n", stats->generation, stats->alive, (long)height * width - stats->alive);
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  /* グリッド */
+  for (int y=0; y<height; y++) {
+    fprintf(fp, "|");
+    for (int x=0; x<width; x++) {
+      fprintf(fp, "\e[31m%c\e[0m", (cells[y * width + x] ? '#' : ' ')); // 赤色で表示
+    }
+    fprintf(fp, "|\r\n");
+  }
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  fflush(fp);
+}
+
+int main(int argc, char **argv)
+{
+  FILE *fp = stdout;
+  long gens = -1; // -1なら表示しながら無限に進める
+
+  if (argc >= 3 && strcmp(argv[1], "-g") == 0) {
+    gens = atol(argv[2]);
+    argc -= 2;
+    argv += 2;
+  }
+
+  if (argc < 2 || argc > 4) {
+    fprintf(stderr, "usage: %s [-g generations] [filename for init] [height] [width]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const int height = (argc >= 3) ? atoi(argv[2]) : 40;
+  const int width = (argc >= 4) ? atoi(argv[3]) : 70;
+
+  life_universe *u = life_create(height, width);
+  if (u == NULL) {
+    fprintf(stderr, "invalid size %dx%d\n", height, width);
+    return EXIT_FAILURE;
+  }
+
+  size_t len;
+  char *text = read_file(argv[1], &len);
+  if (text == NULL) return EXIT_FAILURE;
+  if (life_load(u, text, len) != 0) {
+    fprintf(stderr, "cannot load %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+  free(text);
+
+  life_stats stats;
+
+  if (gens >= 0) {
+    clock_t start = clock();
+    life_step(u, gens);
+    double sec = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    life_get_stats(u, &stats);
+    printf("generation = %ld, alive = %ld, %.3f s\n", stats.generation, stats.alive, sec);
+    life_destroy(u);
+    return EXIT_SUCCESS;
+  }
+
+  uint8_t *cells = malloc((size_t)height * width);
+
+  /* 世代を進める*/
+  for (int gen = 0 ;; gen++) {
+    if (gen > 0) life_step(u, 1); // セルを更新
+    life_get_stats(u, &stats);
+    life_get_cells(u, 0, 0, height, width, cells);
+    my_print_cells(fp, &stats, cells);  // 表示する
+    usleep(200*1000); //0.2秒休止する
+    fprintf(fp,"\e[%dA",height+3);//height+3 の分、カーソルを上に戻す(壁2、表示部1)
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,264 @@
+/*================================================================================================
+
+画像・動画への書き出し
+
+my_print_cells()のANSIの文字を読み取って画像にするのは遅く、色や形も失われるので、
+盤面から直接画像を作って書き出す。盤面の計算にはlifelib.hのライブラリを使う。
+  pgm: 世代ごとにグレースケールのPGM(P5)ファイルを書く(生:白, 死:黒)
+  ppm: 世代ごとにカラーのPPM(P6)ファイルを書く(生:赤, 死:黒)
+  y4m: 1つのY4M(YUV4MPEG2)の動画に全ての世代を書き足していく(出力が「-」なら標準出力)
+       ffmpeg -i out.y4m out.mp4 のように変換できる
+
+1セルをscale x scaleの画素にする。画像の1行は、life_export_bits()で取り出したビット列を
+8セルずつ表引きで8バイトに広げて作り(scale = 1のとき)、同じ行をscale回memcpyで複製する。
+1フレームを全て作ってからまとめて1回書き出し、y4mの出力には大きなバッファを付けている。
+
+コンパイル
+  gcc -O2 mylife17.c lifelib.c
+
+引数
+  [-s 拡大率] [-e 何世代ごとに書くか] [-g 世代数] [pgm|ppm|y4m] [出力(ファイル名の先頭か、y4mのファイル)] [初期状態のファイル] [height] [width]
+
+実行例
+  ./a.out -s 4 -g 300 pgm frames/gun gosperglidergun.lif
+    frames/gun_000000.pgm, frames/gun_000001.pgm, ... ができる
+  ./a.out -s 2 -g 1000 y4m - Bomber.rle 200 200 | ffmpeg -i - bomber.mp4
+
+================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include "lifelib.h"
+
+enum { FORMAT_PGM, FORMAT_PPM, FORMAT_Y4M };
+
+/* expand[b]は、ビット列bの各ビットを0xffか0x00の1バイトに広げたもの */
+uint64_t expand[256];
+
+void make_expand_table() {
+  for (int b=0; b<256; b++) {
+    uint64_t v = 0;
+    for (int i=0; i<8; i++) {
+      if ((b >> i) & 1) v |= 0xffULL << (8 * i);
+    }
+    expand[b] = v;
+  }
+}
+
+/*
+  ファイルの中身を全て読み込む関数(lenにバイト数が入る)
+*/
+char *read_file(const char filename[], size_t *len) {
+
+  FILE *fp = fopen(filename, "rb");
+  if (fp == NULL) {
+    fprintf(stderr,"cannot open file %s\n", filename);
+    return NULL;
+  }
+
+  size_t cap = 4096;
+  char *text = malloc(cap);
+  *len = 0;
+  size_t n;
+  while ((n = fread(text + *len, 1, cap - *len, fp)) > 0) {
+    *len += n;
+    if (*len == cap) {
+      cap *= 2;
+      text = realloc(text, cap);
+    }
+  }
+
+  fclose(fp);
+  return text;
+}
+
+/*
+  盤面をグレースケールの画像(生:255, 死:0)にする関数
+  grayは(height*scale) x (width*scale)バイト
+*/
+void render_gray(const uint64_t bits[], int words, const int height, const int width, int scale, uint8_t gray[]) {
+
+  const size_t image_w = (size_t)width * scale;
+  const uint8_t *bytes = (const uint8_t *)bits; // リトルエンディアンなら、x番目のセルは(x/8)バイト目の(x%8)ビット目
+
+  for (int y=0; y<height; y++) {
+    const uint8_t *row = bytes + (size_t)y * words * sizeof(uint64_t);
+    uint8_t *out = gray + (size_t)y * scale * image_w;
+
+    if (scale == 1) {
+      /* 8セルずつ表引きで広げる */
+      int x = 0;
+      for (; x + 8 <= width; x += 8) {
+        memcpy(out + x, &expand[row[x / 8]], 8);
+      }
+      for (; x < width; x++) {
+        out[x] = ((row[x / 8] >> (x % 8)) & 1) ? 255 : 0;
+      }
+    } else {
+      for (int x=0; x<width; x++) {
+        memset(out + (size_t)x * scale, ((row[x / 8] >> (x % 8)) & 1) ? 255 : 0, scale);
+      }
+    }
+
+    /* 同じ行をscale回並べる */
+    for (int i=1; i<scale; i++) {
+      memcpy(out + i * image_w, out, image_w);
+    }
+  }
+}
+
+/*
+  グレースケールの画像を赤と黒のRGBにする関数
+*/
+void gray_to_rgb(const uint8_t gray[], size_t pixels, uint8_t rgb[]) {
+  for (size_t i=0; i<pixels; i++) {
+    rgb[3 * i] = gray[i];
+    rgb[3 * i + 1] = 0;
+    rgb[3 * i + 2] = 0;
+  }
+}
+
+int write_image(const char prefix[], int format, long gen, int image_h, int image_w, const uint8_t data[]) {
+
+  char filename[1024];
+  snprintf(filename, sizeof(filename), "%s_%06ld.%s", prefix, gen, format == FORMAT_PGM ? "pgm" : "ppm");
+
+  FILE *fp = fopen(filename, "wb");
+  if (fp == NULL) {
+    fprintf(stderr, "cannot open file %s\n", filename);
+    return -1;
+  }
+
+  size_t size = (size_t)image_h * image_w * (format == FORMAT_PGM ? 1 : 3);
+  fprintf(fp, "%s\n%d %d\n255\n", format == FORMAT_PGM ? "P5" : "P6", image_w, image_h);
+  int ok = fwrite(data, 1, size, fp) == size;
+  ok &= fclose(fp) == 0;
+  return ok ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+  int scale = 1;
+  int every = 1;
+  long gens = 100;
+
+  /* オプション */
+  while (argc >= 3 && argv[1][0] == '-' && argv[1][1] != 0) {
+    if (strcmp(argv[1], "-s") == 0) {
+      scale = atoi(argv[2]);
+    } else if (strcmp(argv[1], "-e") == 0) {
+      every = atoi(argv[2]);
+    } else if (strcmp(argv[1], "-g") == 0) {
+      gens = atol(argv[2]);
+    } else {
+      break;
+    }
+    argc -= 2;
+    argv += 2;
+  }
+
+  int format = -1;
+  if (argc >= 2) {
+    if (strcmp(argv[1], "pgm") == 0) format = FORMAT_PGM;
+    if (strcmp(argv[1], "ppm") == 0) format = FORMAT_PPM;
+    if (strcmp(argv[1], "y4m") == 0) format = FORMAT_Y4M;
+  }
+
+  if (argc < 4 || argc > 6 || format < 0 || scale < 1 || every < 1 || gens < 0) {
+    fprintf(stderr, "usage: %s [-s scale] [-e every] [-g generations] [pgm|ppm|y4m] [output] [filename for init] [height] [width]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const char *output = argv[2];
+  const int height = (argc >= 5) ? atoi(argv[4]) : 40;
+  const int width = (argc >= 6) ? atoi(argv[5]) : 70;
+
+  life_universe *u = life_create(height, width);
+  if (u == NULL) {
+    fprintf(stderr, "invalid size %dx%d\n", height, width);
+    return EXIT_FAILURE;
+  }
+
+  size_t len;
+  char *text = read_file(argv[3], &len);
+  if (text == NULL) return EXIT_FAILURE;
+  if (life_load(u, text, len) != 0) {
+    fprintf(stderr, "cannot load %s\n", argv[3]);
+    return EXIT_FAILURE;
+  }
+  free(text);
+
+  make_expand_table();
+
+  const int words = life_row_words(u);
+  const int image_h = height * scale;
+  const int image_w = width * scale;
+  const size_t pixels = (size_t)image_h * image_w;
+
+  uint64_t *bits = malloc(sizeof(uint64_t) * height * words);
+  uint8_t *gray = malloc(pixels + 8); // 8セルずつ書くので少し余分に取る
+  uint8_t *rgb = (format == FORMAT_PPM) ? malloc(pixels * 3) : NULL;
+
+  /* y4mはヘッダーを書いておき、色差(U, V)は全て128(無彩色)にする */
+  FILE *video = NULL;
+  uint8_t *chroma = NULL;
+  size_t chroma_size = 0;
+  if (format == FORMAT_Y4M) {
+    video = (strcmp(output, "-") == 0) ? stdout : fopen(output, "wb");
+    if (video == NULL) {
+      fprintf(stderr, "cannot open file %s\n", output);
+      return EXIT_FAILURE;
+    }
+    setvbuf(video, NULL, _IOFBF, 1 << 22);
+    fprintf(video, "YUV4MPEG2 W%d H%d F30:1 Ip A1:1 C420jpeg\n", image_w, image_h);
+
+    chroma_size = (size_t)((image_w + 1) / 2) * ((image_h + 1) / 2) * 2;
+    chroma = malloc(chroma_size);
+    memset(chroma, 128, chroma_size);
+  }
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  long frames = 0;
+
+  for (long gen = 0 ; gen <= gens; gen++) {
+    if (gen > 0) life_step(u, 1); // セルを更新
+    if (gen % every != 0) continue;
+
+    life_export_bits(u, bits);
+    render_gray(bits, words, height, width, scale, gray);
+
+    int result = 0;
+    if (format == FORMAT_PGM) {
+      result = write_image(output, format, gen, image_h, image_w, gray);
+    } else if (format == FORMAT_PPM) {
+      gray_to_rgb(gray, pixels, rgb);
+      result = write_image(output, format, gen, image_h, image_w, rgb);
+    } else {
+      fwrite("FRAME\n", 1, 6, video);
+      fwrite(gray, 1, pixels, video);
+      if (fwrite(chroma, 1, chroma_size, video) != chroma_size) result = -1;
+    }
+    if (result != 0) {
+      fprintf(stderr, "cannot write generation %ld\n", gen);
+      return EXIT_FAILURE;
+    }
+    frames++;
+  }
+
+  if (video != NULL && video != stdout) fclose(video);
+  if (video == stdout) fflush(stdout);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double sec = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+  fprintf(stderr, "%ld frames (%dx%d) in %.3f s (%.0f frames/s)\n", frames, image_w, image_h, sec, frames / sec);
+
+  free(bits);
+  free(gray);
+  free(rgb);
+  free(chroma);
+  life_destroy(u);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,353 @@
+/*===========================================================
+
+羊と草地のシミュレーションのパラメータ探索
+
+mylife4.cは草地と羊の割合を1組だけ受け取り、表示しながら終わりなく進める。
+ここでは(草地の割合, 羊の割合, 乱数の種)の組を格子状に全て試し、
+それぞれを表示せずに決まった世代数だけ進めて、結果を表にまとめる。
+組はスレッドが1つずつ取り出して並列に計算する。
+
+ルールはmylife4.cと同じ。
+ただしrand()は全スレッドで共有されていて結果が再現できないので、
+乱数は組ごとに種から作るxorshiftの状態(Rng)を関数に渡して使う。
+
+各組について記録するもの
+  extinct  : 羊が絶滅した世代(最後まで残れば-1)
+  period   : 羊の数の振動の周期(後半の世代の自己相関が最大になるずれ。はっきりしなければ0)
+  glass, sheep: 最後の世代の草地と羊の密度(%)
+
+コンパイル
+  gcc -O2 -pthread mylife18.c
+
+引数
+  [-j スレッド数] [-g 世代数] [草地の割合 最小:最大:刻み] [羊の割合 最小:最大:刻み] [乱数の種の数]
+
+実行例
+  ./a.out -j 4 -g 2000 10:90:10 5:30:5 3
+  ./a.out -g 500 1:1:1 20:20:1 10
+
+===========================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/*
+  組ごとの乱数(xorshift64)
+*/
+typedef struct {
+  uint64_t state;
+} Rng;
+
+void rng_seed(Rng *rng, uint64_t seed) {
+  rng->state = seed * 0x9E3779B97F4A7C15ULL + 1; // 0にならないようにする
+  if (rng->state == 0) rng->state = 1;
+}
+
+int rng_next(Rng *rng, int n) {
+  rng->state ^= rng->state << 13;
+  rng->state ^= rng->state >> 7;
+  rng->state ^= rng->state << 17;
+  return (int)(rng->state % n);
+}
+
+/*
+ ファイルによるセルの初期化: ランダムで作成
+ */
+void my_init_cells(const int height, const int width, int cell[height][width], int glass_rate, int sheep_rate, Rng *rng) {
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      int r = rng_next(rng, 100);
+      if (r < glass_rate) {
+        cell[y][x] = 1;
+      } else if (r < glass_rate + sheep_rate) {
+        cell[y][x] = 2;
+      } else {
+        cell[y][x] = 0;
+      }
+    }
+  }
+
+}
+
+int in_cells(int y, int x, const int height, const int width) {
+
+  if (y < 0 || height <= y) return 0;
+  if (x < 0 || width <= x) return 0;
+
+  return 1;
+}
+
+/*
+ 着目するセルの周辺の草地と羊をカウントする関数
+ */
+void my_count_adjacent_cells(int y, int x, const int height, const int width, int cell[height][width], int *glass, int *sheep) {
+
+  /*
+    dy, dx: 相対位置
+    012
+    7.3
+    654
+  */
+  int dy[] = {-1, -1, -1, 0, 1, 1, 1, 0};
+  int dx[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+
+  for (int i=0; i<8; i++) {
+
+    int ny = y + dy[i];
+    int nx = x + dx[i];
+
+    if (in_cells(ny, nx, height, width)) {
+      if (cell[ny][nx] == 1) {
+        (*glass)++;
+      } else if (cell[ny][nx] == 2) {
+        (*sheep)++;
+      }
+    }
+
+  }
+
+}
+
+/*
+  着目するセルの次の世代での状態を返す関数
+  仔を生む場合、childY,childXにその座標を書き込む
+*/
+int next_state(int y, int x, const int height, const int width, int cell[height][width], int glass, int sheep, int *childY, int *childX, Rng *rng) {
+
+  if (cell[y][x] == 1) {
+    return 1;
+  } else if (cell[y][x] == 2) {
+    if (glass == 0) {
+      return 0;
+    } else {
+      do {
+        *childY = y - 1 + rng_next(rng, 3);
+        *childX = x - 1 + rng_next(rng, 3);
+      } while(!in_cells(*childY, *childX, height, width) || (*childY == y && *childX == x));
+      return 2;
+    }
+  } else {
+    if (glass >= 2) return 1;
+    return (rng_next(rng, 1000) == 0 ? 1: 0);
+  }
+
+}
+
+/*
+ ルールに基づいて2次元配列の状態を更新する
+ */
+void my_update_cells(const int height, const int width, int cell[height][width], Rng *rng) {
+
+  int next_cell[height][width];
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      next_cell[y][x] = -1; // 初期状態は-1とする
+    }
+  }
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+
+      // 仔がその場所に生まれていて、既に書き換えられている場合
+      if (next_cell[y][x] != -1) continue;
+
+      int glass = 0, sheep = 0;
+      my_count_adjacent_cells(y, x, height, width, cell, &glass, &sheep);
+
+      int childY = -1, childX = -1;
+      next_cell[y][x] = next_state(y, x, height, width, cell, glass, sheep, &childY, &childX, rng);
+
+      // 既に羊がいなければ仔が生まれる
+      if (childY != -1 && cell[childY][childX] != 2) {
+          next_cell[childY][childX] = 2;
+      }
+    }
+  }
+
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      cell[y][x] = next_cell[y][x];
+    }
+  }
+
+}
+
+/*------------------------------------------------------------------------------------------------
+  探索
+------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+  int glass_rate;
+  int sheep_rate;
+  int seed;
+  /* 結果 */
+  int extinct;
+  int period;
+  double glass_density;
+  double sheep_density;
+} Run;
+
+typedef struct {
+  Run *runs;
+  int count;
+  int next; // 次に取り出す組(__sync_fetch_and_addで進める)
+  int gens;
+} Sweep;
+
+/*
+  羊の数の列の後半から振動の周期を求める関数
+  平均を引いた自己相関が最大になるずれを返す(相関が0.5未満なら0)
+*/
+int estimate_period(const int sheep[], int gens) {
+
+  const int begin = gens / 2;
+  const int n = gens - begin;
+  if (n < 8) return 0;
+
+  double mean = 0;
+  for (int i=begin; i<gens; i++) mean += sheep[i];
+  mean /= n;
+
+  double var = 0;
+  for (int i=begin; i<gens; i++) var += (sheep[i] - mean) * (sheep[i] - mean);
+  if (var == 0) return 0;
+
+  int best = 0;
+  double best_corr = 0.5;
+  for (int lag=2; lag<=n/2; lag++) {
+    double c = 0;
+    for (int i=begin; i+lag<gens; i++) c += (sheep[i] - mean) * (sheep[i + lag] - mean);
+    c /= var * (n - lag) / n;
+    if (c > best_corr) {
+      best_corr = c;
+      best = lag;
+    }
+  }
+  return best;
+}
+
+void simulate(Run *run, int gens) {
+
+  const int height = 40;
+  const int width = 70;
+  int cell[height][width];
+  int *sheep = malloc(sizeof(int) * (gens + 1));
+
+  Rng rng;
+  rng_seed(&rng, ((uint64_t)run->glass_rate << 40) ^ ((uint64_t)run->sheep_rate << 20) ^ run->seed);
+  my_init_cells(height, width, cell, run->glass_rate, run->sheep_rate, &rng);
+
+  run->extinct = -1;
+  int count_cells[3] = {0, 0, 0};
+  for (int gen = 0 ; gen <= gens; gen++) {
+    if (gen > 0) my_update_cells(height, width, cell, &rng);
+
+    count_cells[0] = count_cells[1] = count_cells[2] = 0;
+    for (int y=0; y<height; y++) {
+      for (int x=0; x<width; x++) {
+        count_cells[cell[y][x]]++;
+      }
+    }
+    sheep[gen] = count_cells[2];
+    if (count_cells[2] == 0 && run->extinct < 0) run->extinct = gen;
+  }
+
+  run->period = (run->extinct < 0) ? estimate_period(sheep, gens + 1) : 0;
+  run->glass_density = 100.0 * count_cells[1] / (height * width);
+  run->sheep_density = 100.0 * count_cells[2] / (height * width);
+  free(sheep);
+}
+
+void *worker_main(void *arg) {
+
+  Sweep *sweep = arg;
+  while (1) {
+    int i = __sync_fetch_and_add(&sweep->next, 1);
+    if (i >= sweep->count) break;
+    simulate(&sweep->runs[i], sweep->gens);
+  }
+  return NULL;
+}
+
+/*
+  "最小:最大:刻み"の形の範囲を読む関数
+*/
+int parse_range(const char str[], int *min, int *max, int *step) {
+  if (sscanf(str, "%d:%d:%d", min, max, step) != 3) return -1;
+  if (*step <= 0 || *min > *max || *min < 0 || *max > 100) return -1;
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  int threads = sysconf(_SC_NPROCESSORS_ONLN);
+  int gens = 1000;
+
+  /* オプション */
+  while (argc >= 3 && argv[1][0] == '-') {
+    if (strcmp(argv[1], "-j") == 0) {
+      threads = atoi(argv[2]);
+    } else if (strcmp(argv[1], "-g") == 0) {
+      gens = atoi(argv[2]);
+    } else {
+      break;
+    }
+    argc -= 2;
+    argv += 2;
+  }
+
+  int g_min, g_max, g_step, s_min, s_max, s_step;
+  if (argc != 4 || threads < 1 || gens < 1 ||
+      parse_range(argv[1], &g_min, &g_max, &g_step) != 0 || parse_range(argv[2], &s_min, &s_max, &s_step) != 0 || atoi(argv[3]) < 1) {
+    fprintf(stderr, "usage: %s [-j threads] [-g generations] [glass min:max:step] [sheep min:max:step] [seeds]\n", argv[0]);
+    fprintf(stderr, "example: %s -j 4 -g 2000 10:90:10 5:30:5 3\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  const int seeds = atoi(argv[3]);
+
+  /* 組を全て並べる */
+  Sweep sweep;
+  sweep.count = ((g_max - g_min) / g_step + 1) * ((s_max - s_min) / s_step + 1) * seeds;
+  sweep.runs = calloc(sweep.count, sizeof(Run));
+  sweep.next = 0;
+  sweep.gens = gens;
+
+  int n = 0;
+  for (int g=g_min; g<=g_max; g+=g_step) {
+    for (int s=s_min; s<=s_max; s+=s_step) {
+      for (int seed=0; seed<seeds; seed++) {
+        sweep.runs[n].glass_rate = g;
+        sweep.runs[n].sheep_rate = s;
+        sweep.runs[n].seed = seed;
+        n++;
+      }
+    }
+  }
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  pthread_t tids[threads];
+  for (int i=0; i<threads; i++) pthread_create(&tids[i], NULL, worker_main, &sweep);
+  for (int i=0; i<threads; i++) pthread_join(tids[i], NULL);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double sec = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+
+  /* 結果の表 */
+  printf("glass%%  sheep%%  seed  extinct  period  glass  sheep\n");
+  for (int i=0; i<sweep.count; i++) {
+    Run *r = &sweep.runs[i];
+    printf("%6d  %6d  %4d  %7d  %6d  %5.1f  %5.1f\n", r->glass_rate, r->sheep_rate, r->seed, r->extinct, r->period, r->glass_density, r->sheep_density);
+  }
+  fprintf(stderr, "%d runs x %d generations with %d threads: %.2f s\n", sweep.count, gens, threads, sec);
+
+  free(sweep.runs);
+  return EXIT_SUCCESS;
+}
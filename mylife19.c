@@ -0,0 +1,660 @@
+/*================================================================================================
+
+前の世代(predecessor)の探索とエデンの園の確認
+
+目標のパターン(h x wの範囲)が与えられたとき、1世代進めるとその範囲がちょうど目標になるような
+(h+2) x (w+2)の盤面(前の世代)を探す。見つからなければ、そのパターンはどんな盤面からも作れない
+(エデンの園, Garden of Eden)ことが確かめられる。範囲の外の目標は問わないが、-mで余白を付けると
+パターンの周りmセルも死んでいることを条件にできる。ルールはパターンのファイルのB/Sに従う。
+
+探索は行ごとの動的計画法で行う。前の世代の1行をW = w+2ビットの整数で表し、
+  S_i = 「前の世代のi行目とi+1行目の組(2Wビット)のうち、目標の0〜i-1行目と矛盾しないもの」
+をビット集合(2^(2W)ビット)で持つ。S_0は全ての組で、(b, c)がS_iに入っていれば、
+目標のi行目と一致するような次の行dを全て探して(c, d)をS_{i+1}に入れる。
+S_hが空でなければ前の世代があり、各S_iを逆にたどって実際の盤面を復元する。
+
+dの探索は左の列から1ビットずつ決めていき、3列そろった時点で目標のセルと比べて枝を刈る(先読み)。
+そのために目標の行ごと・列ごとに「b, cの3列(6ビット)に対して許されるdの3列」を
+8ビットのマスクとして前もって表にしておくので、1ビット決めるごとの判定は表を1回引くだけで済む。
+S_iのワードを複数のスレッドで分担して調べ、S_{i+1}にはアトミックなORで書き込む。
+
+パターンが横長のときは転置して、幅の狭い向きで探索する(ルールは回転・反転しても変わらない)。
+ビット集合の大きさが2^(2W)なので、短い方の辺(余白を含む)はMAX_WIDTH-2以下に限る。
+
+コンパイル
+  gcc -O2 -pthread mylife19.c
+
+引数
+  [-j スレッド数] [-m 余白] [目標のパターンのファイル]
+
+実行例
+  ./a.out Garden_of_Eden_5.rle
+  ./a.out -j 4 Pentadecathlon.rle
+
+================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h> // sleep()関数を使う
+#include <time.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/* デフォルトのルール */
+int can_survive[9] = {0, 0, 1, 1, 0};
+int can_born[9] = {0, 0, 0, 1, 0};
+char rule_S[10] = "23";
+char rule_B[10] = "3";
+
+/*
+  文字列strの最後がsuffixに一致するか判定する関数
+*/
+int ends_with(const char str[], const char suffix[]) {
+
+  int len_str = strlen(str);
+  int len_suf = strlen(suffix);
+
+  if (len_str < len_suf) return 0;
+
+  char lower_str[255];
+  char lower_suffix[255];
+  strcpy(lower_str, str);
+  strcpy(lower_suffix, suffix);
+
+  /* 大文字は全て小文字にする */
+  for (int i=0; lower_str[i] != 0; i++) {
+    if ('A' <= lower_str[i] && lower_str[i] <= 'Z') {
+      lower_str[i] += 'a' - 'A';
+    }
+  }
+  for (int i=0; lower_suffix[i] != 0; i++) {
+    if ('A' <= lower_suffix[i] && lower_suffix[i] <= 'Z') {
+      lower_suffix[i] += 'a' - 'A';
+    }
+  }
+
+  return (strcmp(lower_str + len_str - len_suf, lower_suffix) == 0);
+}
+
+/*
+  文字列を10進数で表した時の長さを返す関数
+  ただし、0の長さは0とする
+*/
+int number_len(int n) {
+  int len = 0;
+  while(n > 0) {
+    len++;
+    n /= 10;
+  }
+
+  return len;
+}
+
+/*
+  文字が空白、タブ、CR、LFのいずれかなら1を返す関数
+*/
+int isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+int loadRLE(const int height, const int width, int cell[height][width], FILE *fp) {
+
+  char buffer[(int)1e4+1]; // 1行は70文字以下だが念のため
+  int y = 0, x = 0;
+  int offsetY = 0, offsetX = 0;
+  while(fgets(buffer, 1e4, fp) != NULL) {
+
+    /* オフセット指定以外のヘッダー情報は読み飛ばす */
+    if (buffer[0] == '#') {
+      if (buffer[1] == 'P' || buffer[1] == 'R') {
+        sscanf(buffer+2, "%d%d", &offsetX, &offsetY);
+        if (offsetY < 0 || offsetX < 0) {
+          offsetY = 0;
+          offsetX = 0;
+        } else {
+          y = offsetY;
+          x = offsetX;
+        }
+      }
+      continue;
+    }
+
+    /* サイズ情報は読み飛ばし、ルールは反映する */
+    if (buffer[0] == 'x') {
+      int result = sscanf(buffer, "x = %*d, y = %*d, rule = %*[Bb]%9[^/\n]/%*[Ss]%9s", rule_B, rule_S); // 小文字のb3/s23も読む
+
+      for (int i=0; i<=8; i++) {
+        can_survive[i] = 0;
+        can_born[i] = 0;
+      }
+
+      for (int i=0; i<10; i++) {
+        int s = rule_S[i] - '0';
+        int b = rule_B[i] - '0';
+        if (0 <= s && s <= 8) can_survive[s] = 1;
+        if (0 <= b && b <= 8) can_born[b] = 1;
+      }
+
+      continue;
+    }
+
+    int offset = 0; // 行の何文字目を次に読むか
+    while(1) {
+      int len = 0; // ランの長さ
+      char c; // タグ('o', 'b', '$', '!'のいずれか)
+
+      // 途中に空白が入っても対応可能
+      while(isWhitespace(buffer[offset])) offset++;
+
+      // ランの長さを取得(1が省略されている場合は何も読み込まない)
+      int result = sscanf(buffer+offset, "%d", &len);
+      // 読み込んだ分だけoffsetを加算(ただし0のままの場合は読みこんでないのでそのまま)
+      offset += number_len(len);
+
+      // 長さ省略時は1
+      if (len == 0) len = 1;
+
+      // ランのタグを取得
+      result = sscanf(buffer+offset, "%c", &c);
+      offset++;
+
+      if (result <= 0 || c == '!') { // 終了
+        break;
+      } else if (c == '$') { // 改行
+        y += len;
+        x = offsetX;
+      } else if (c == 'b') { // dead
+        x += len;
+      } else if (c == 'o') { // alive
+        for (int i=0; i<len; i++) {
+          cell[y][x] = 1;
+          x++;
+        }
+      } else {
+        fprintf(stderr,"Invalid syntax\n");
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ ファイルによるセルの初期化: 生きているセルの座標が記述されたファイルをもとに2次元配列の状態を初期化する
+ fp = NULL のときは、関数内で適宜定められた初期状態に初期化する。関数内初期値はdefault.lif と同じもの
+ */
+int my_init_cells(const int height, const int width, int cell[height][width], char filename[]) {
+
+  if (filename[0] == 0) {
+    /* ランダムに配置する */
+    srand(time(NULL));
+
+    for (int y=0; y<height; y++) {
+      for (int x=0; x<width; x++) {
+        cell[y][x] = (rand() % 10 == 0 ? 1 : 0);
+      }
+    }
+  } else {
+
+    FILE *fp = fopen(filename,"r");
+    if (fp == NULL) {
+      fprintf(stderr,"cannot open file %s\n", filename);
+      return EXIT_FAILURE;
+    }
+
+    if (ends_with(filename, ".lif")) {
+
+      fscanf(fp, "%*[^\n]\n"); // バージョン情報は読み飛ばす
+
+      int x, y;
+      while (fscanf(fp, "%d%d", &x, &y) > 0) {
+        cell[y][x] = 1;
+      }
+
+    } else if (ends_with(filename, ".rle")) {
+
+      int result = loadRLE(height, width, cell, fp);
+      if (result != 0) return EXIT_FAILURE;
+
+    } else {
+
+      fprintf(stderr,"Supported: .lif .rle\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ グリッドの描画: 世代情報とグリッドの配列等を受け取り、ファイルポインタに該当する出力にグリッドを描画する
+ */
+void my_print_cells(FILE *fp, int gen, const int height, const int width, int cell[height][width]) {
+
+  /* 0,1それぞれの状態のセルをカウント */
+  int count_cells[2] = {0, 0};
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      count_cells[cell[y][x]]++;
+    }
+  }
+
+  // 世代情報と存在比を表示
+  fprintf(fp, "rule: B%s/S%s, generateion = %d, alive:dead = %7d:%7d\r\n", rule_B, rule_S, gen, count_cells[1], count_cells[0]);
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  /* グリッド */
+  for (int y=0; y<height; y++) {
+    fprintf(fp, "|");
+    for (int x=0; x<width; x++) {
+      fprintf(fp, "\e[31m%c\e[0m", (cell[y][x] ? '#' : ' ')); // 赤色で表示
+    }
+    fprintf(fp, "|\r\n");
+  }
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  fflush(fp);
+}
+
+int in_cells(int y, int x, const int height, const int width) {
+
+  if (y < 0 || height <= y) return 0;
+  if (x < 0 || width <= x) return 0;
+
+  return 1;
+}
+
+/*
+ 着目するセルの周辺の生きたセルをカウントする関数
+ */
+int my_count_adjacent_cells(int y, int x, const int height, const int width, int cell[height][width]) {
+
+  /*
+    dy, dx: 相対位置
+    012
+    7.3
+    654
+  */
+  int dy[] = {-1, -1, -1, 0, 1, 1, 1, 0};
+  int dx[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+
+  int count = 0;
+  
+  for (int i=0; i<8; i++) {
+
+    int ny = y + dy[i];
+    int nx = x + dx[i];
+
+    if (in_cells(ny, nx, height, width) && cell[ny][nx]) {
+      count++;
+    }
+
+  }
+
+  return count;
+}
+
+/*
+  着目するセルの次の世代での状態を返す関数
+*/
+int next_state(int y, int x, const int height, const int width, int cell[height][width], int neighbors) {
+
+  if (cell[y][x]) { 
+    return can_survive[neighbors];
+  } else {
+    return can_born[neighbors];
+  }
+
+}
+
+/*
+ ライフゲームのルールに基づいて2次元配列の状態を更新する
+ */
+void my_update_cells(const int height, const int width, int cell[height][width]) {
+
+  int next_cell[height][width];
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      next_cell[y][x] = 0;
+    }
+  }
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      int neighbors = my_count_adjacent_cells(y, x, height, width, cell);
+      next_cell[y][x] = next_state(y, x, height, width, cell, neighbors);
+    }
+  }
+
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      cell[y][x] = next_cell[y][x];
+    }
+  }
+
+}
+
+#define MAX_WIDTH 14 // 前の世代の1行のビット数の上限(ビット集合は2^(2*MAX_WIDTH)ビット)
+#define MAX_HEIGHT 64
+
+/*------------------------------------------------------------------------------------------------
+  探索の問題
+  target[i]は目標のi行目(wビット)、前の世代の行はW = w+2ビット
+------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+  int h, w, W;
+  uint32_t target[MAX_HEIGHT];
+  /* allowed[i][j][bc]: 目標のi行目j列目について、前の世代のb, cの行のj〜j+2列(bc = b3 | c3<<3)に対し、
+     dの行のj〜j+2列として許されるもの(8ビットのマスク) */
+  uint8_t allowed[MAX_HEIGHT][MAX_WIDTH][64];
+  uint64_t *layers[MAX_HEIGHT + 1]; // S_0〜S_h(S_0は全ての組なので持たない)
+  int threads;
+} Search;
+
+/*
+  3x3の窓(b, c, dの3ビットずつ)の中央のセルの次の状態を返す関数
+*/
+int window_next(int b3, int c3, int d3) {
+
+  int neighbors = __builtin_popcount(b3) + __builtin_popcount(d3) + ((c3 & 1) + ((c3 >> 2) & 1));
+  return (c3 & 2) ? can_survive[neighbors] : can_born[neighbors];
+}
+
+void make_allowed(Search *s) {
+
+  for (int i=0; i<s->h; i++) {
+    for (int j=0; j<s->w; j++) {
+      int t = (s->target[i] >> j) & 1;
+      for (int bc=0; bc<64; bc++) {
+        uint8_t mask = 0;
+        for (int d3=0; d3<8; d3++) {
+          if (window_next(bc & 7, bc >> 3, d3) == t) mask |= 1 << d3;
+        }
+        s->allowed[i][j][bc] = mask;
+      }
+    }
+  }
+}
+
+/*
+  (b, c)に続けられるdを全て探し、見つかった(c, d)をS_{row+1}に加える(深さ優先、3列そろうごとに枝刈り)
+  kは次に決めるdのビット
+*/
+typedef struct {
+  const Search *s;
+  int row;
+  uint32_t b, c;
+  uint64_t *next; // S_{row+1}
+} Extend;
+
+void extend_rec(const Extend *e, int k, uint32_t d) {
+
+  const Search *s = e->s;
+
+  if (k == s->W) {
+    uint64_t index = (uint64_t)e->c | ((uint64_t)d << s->W);
+    uint64_t bit = 1ULL << (index % 64);
+    if (!(e->next[index / 64] & bit)) __sync_fetch_and_or(&e->next[index / 64], bit);
+    return;
+  }
+
+  for (uint32_t v=0; v<=1; v++) {
+    uint32_t nd = d | (v << k);
+    if (k >= 2) {
+      int j = k - 2; // 3列そろった目標のセル
+      int bc = ((e->b >> j) & 7) | (((e->c >> j) & 7) << 3);
+      if (!((s->allowed[e->row][j][bc] >> ((nd >> j) & 7)) & 1)) continue;
+    }
+    extend_rec(e, k + 1, nd);
+  }
+}
+
+typedef struct {
+  Search *s;
+  int row;
+  int id;
+} Task;
+
+/*
+  S_row の担当部分(ワードをスレッド数で分けたもの)からS_{row+1}を作る
+*/
+void *extend_worker(void *arg) {
+
+  Task *t = arg;
+  Search *s = t->s;
+  const uint64_t pairs = 1ULL << (2 * s->W);
+  const uint64_t words = (pairs + 63) / 64;
+  const uint64_t begin = words * t->id / s->threads;
+  const uint64_t end = words * (t->id + 1) / s->threads;
+  const uint32_t row_mask = (1U << s->W) - 1;
+
+  Extend e;
+  e.s = s;
+  e.row = t->row;
+  e.next = s->layers[t->row + 1];
+
+  for (uint64_t wi=begin; wi<end; wi++) {
+    uint64_t word = (t->row == 0) ? ~0ULL : s->layers[t->row][wi];
+    while (word != 0) {
+      uint64_t index = wi * 64 + __builtin_ctzll(word);
+      word &= word - 1;
+      if (index >= pairs) break;
+      e.b = index & row_mask;
+      e.c = index >> s->W;
+      extend_rec(&e, 0, 0);
+    }
+  }
+  return NULL;
+}
+
+/*
+  行rowについて、S_rowの(b, c)とS_{row+1}の(c, d)の組が目標と一致するか
+*/
+int row_matches(const Search *s, int row, uint32_t b, uint32_t c, uint32_t d) {
+
+  for (int j=0; j<s->w; j++) {
+    int bc = ((b >> j) & 7) | (((c >> j) & 7) << 3);
+    if (!((s->allowed[row][j][bc] >> ((d >> j) & 7)) & 1)) return 0;
+  }
+  return 1;
+}
+
+int in_layer(const Search *s, int row, uint32_t b, uint32_t c) {
+
+  if (row == 0) return 1;
+  uint64_t index = (uint64_t)b | ((uint64_t)c << s->W);
+  return (s->layers[row][index / 64] >> (index % 64)) & 1;
+}
+
+/*
+  前の世代を探す関数
+  見つかればpred[0..h+1]に前の世代の行を入れて1を返す。無ければ0を返す
+*/
+int find_predecessor(Search *s, uint32_t pred[]) {
+
+  const uint64_t pairs = 1ULL << (2 * s->W);
+  const size_t bytes = (pairs + 63) / 64 * sizeof(uint64_t);
+
+  make_allowed(s);
+  s->layers[0] = NULL;
+
+  for (int row=0; row<s->h; row++) {
+    s->layers[row + 1] = calloc(bytes, 1);
+    if (s->layers[row + 1] == NULL) {
+      fprintf(stderr, "cannot allocate %zu bytes\n", bytes);
+      exit(EXIT_FAILURE);
+    }
+
+    pthread_t tids[s->threads];
+    Task tasks[s->threads];
+    for (int i=0; i<s->threads; i++) {
+      tasks[i].s = s;
+      tasks[i].row = row;
+      tasks[i].id = i;
+      pthread_create(&tids[i], NULL, extend_worker, &tasks[i]);
+    }
+    for (int i=0; i<s->threads; i++) pthread_join(tids[i], NULL);
+
+    uint64_t count = 0;
+    for (size_t i=0; i<bytes / sizeof(uint64_t); i++) count += __builtin_popcountll(s->layers[row + 1][i]);
+    fprintf(stderr, "row %2d: %llu row pairs\n", row, (unsigned long long)count);
+    if (count == 0) return 0;
+  }
+
+  /* S_hの組を1つ選び、逆にたどる */
+  const uint32_t row_mask = (1U << s->W) - 1;
+  uint64_t index = 0;
+  for (size_t i=0; i<bytes / sizeof(uint64_t); i++) {
+    if (s->layers[s->h][i] != 0) {
+      index = i * 64 + __builtin_ctzll(s->layers[s->h][i]);
+      break;
+    }
+  }
+  pred[s->h] = index & row_mask;
+  pred[s->h + 1] = index >> s->W;
+
+  for (int row=s->h-1; row>=0; row--) {
+    int found = 0;
+    for (uint32_t b=0; b<=row_mask && !found; b++) {
+      if (in_layer(s, row, b, pred[row + 1]) && row_matches(s, row, b, pred[row + 1], pred[row + 2])) {
+        pred[row] = b;
+        found = 1;
+      }
+    }
+    if (!found) return 0; // ここには来ないはず
+  }
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  const int height = 40;
+  const int width = 70;
+  int threads = sysconf(_SC_NPROCESSORS_ONLN);
+  int margin = 0;
+
+  /* オプション */
+  while (argc >= 3 && argv[1][0] == '-') {
+    if (strcmp(argv[1], "-j") == 0) {
+      threads = atoi(argv[2]);
+    } else if (strcmp(argv[1], "-m") == 0) {
+      margin = atoi(argv[2]);
+    } else {
+      break;
+    }
+    argc -= 2;
+    argv += 2;
+  }
+
+  if (argc != 2 || threads < 1 || margin < 0) {
+    fprintf(stderr, "usage: %s [-j threads] [-m margin] [filename for target]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  int cell[height][width];
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      cell[y][x] = 0;
+    }
+  }
+  int result = my_init_cells(height, width, cell, argv[1]);
+  if (result != 0) return EXIT_FAILURE;
+
+  /* 生きているセルを囲む長方形に余白を付けたものを目標の範囲にする */
+  int min_y = height, min_x = width, max_y = -1, max_x = -1;
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      if (!cell[y][x]) continue;
+      if (y < min_y) min_y = y;
+      if (x < min_x) min_x = x;
+      if (y > max_y) max_y = y;
+      if (x > max_x) max_x = x;
+    }
+  }
+  if (max_y < 0) {
+    fprintf(stderr, "empty pattern\n");
+    return EXIT_FAILURE;
+  }
+  min_y -= margin;
+  min_x -= margin;
+  max_y += margin;
+  max_x += margin;
+
+  int h = max_y - min_y + 1;
+  int w = max_x - min_x + 1;
+  int transpose = (h < w); // 幅の狭い向きで探す
+
+  Search s;
+  memset(&s, 0, sizeof(s));
+  s.h = transpose ? w : h;
+  s.w = transpose ? h : w;
+  s.W = s.w + 2;
+  s.threads = threads;
+
+  if (s.W > MAX_WIDTH || s.h > MAX_HEIGHT) {
+    fprintf(stderr, "target %dx%d is too large (shorter side must be <= %d)\n", w, h, MAX_WIDTH - 2);
+    return EXIT_FAILURE;
+  }
+
+  for (int i=0; i<s.h; i++) {
+    for (int j=0; j<s.w; j++) {
+      int y = transpose ? j : i;
+      int x = transpose ? i : j;
+      if (in_cells(min_y + y, min_x + x, height, width) && cell[min_y + y][min_x + x]) s.target[i] |= 1U << j;
+    }
+  }
+
+  fprintf(stderr, "target %dx%d, rule B%s/S%s%s\n", w, h, rule_B, rule_S, transpose ? " (transposed)" : "");
+
+  clock_t start = clock();
+  uint32_t pred[MAX_HEIGHT + 2];
+  int found = find_predecessor(&s, pred);
+  double sec = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  if (!found) {
+    printf("no predecessor: the target is a Garden of Eden (%.2f s cpu)\n", sec);
+  } else {
+    /* 前の世代を盤面に置き、my_update_cells()で1世代進めて確かめる(周りに1セルの余白を付ける) */
+    const int ph = h + 4, pw = w + 4;
+    int board[ph][pw];
+    memset(board, 0, sizeof(board));
+    for (int i=0; i<s.h+2; i++) {
+      for (int j=0; j<s.W; j++) {
+        int y = transpose ? j : i;
+        int x = transpose ? i : j;
+        board[y + 1][x + 1] = (pred[i] >> j) & 1;
+      }
+    }
+
+    printf("predecessor (%.2f s cpu):\n", sec);
+    for (int y=1; y<ph-1; y++) {
+      for (int x=1; x<pw-1; x++) putchar(board[y][x] ? 'o' : '.');
+      putchar('\n');
+    }
+
+    my_update_cells(ph, pw, board);
+    int ok = 1;
+    for (int y=0; y<h; y++) {
+      for (int x=0; x<w; x++) {
+        int t = in_cells(min_y + y, min_x + x, height, width) && cell[min_y + y][min_x + x];
+        if (board[y + 2][x + 2] != t) ok = 0;
+      }
+    }
+    printf("check with my_update_cells(): %s\n", ok ? "ok" : "MISMATCH");
+    if (!ok) return EXIT_FAILURE;
+  }
+
+  for (int i=1; i<=s.h; i++) free(s.layers[i]);
+  return EXIT_SUCCESS;
+}
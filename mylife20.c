@@ -0,0 +1,756 @@
+/*================================================================================================
+
+物体の追跡とグライダーの数え上げ
+
+グライダー銃(gosperglidergun.lif)やBomber.rleが宇宙船をいくつ出し、どこへ飛ばしているかを調べる。
+盤面の計算にはlifelib.hのライブラリを使い、世代ごとに次のことを行う。
+
+1. 連結成分のラベル付け
+   life_export_bits()で取り出したビット列から、各行の生きたセルの連続(ラン)をワード単位で取り出し、
+   上の行のランと斜めも含めて接していればunion-findでつなぐ。成分ごとに外接長方形とセルの一覧を作り、
+   左上を原点にした形からハッシュを求める。
+2. 差分だけの更新
+   前の世代の成分ごとに、1セル広げた外接長方形の中を前の世代とXORで比べ、変わっていなければそのまま引き継ぐ。
+   ラベル付けはそれ以外のセルだけで行うので、静かな部分(銃の本体や固定物)の処理はほとんど要らない。
+3. 前の世代との対応
+   成分ごとに、p = 1〜MAX_PERIOD世代前に同じ形の成分が近く(|dx|, |dy| <= p)にあるかを調べる。
+   最も小さいpで見つかったとき、ずれが0なら振動子、0でなければ速度(dx, dy)/pで動いている。
+   同じずれがCONFIRM周期続いたものを宇宙船とする(銃の中で一瞬だけ似た形ができても数えない)。
+   追跡(Track)は1つの形(位相)ごとに持ち、p世代前の同じ形・同じ速度の成分から引き継ぐ。
+   新しい形の追跡は、同じ速度で動いている宇宙船の外接長方形(その宇宙船の全ての位相・部品を合わせたもの)に
+   SHIP_PART_GAPセル以内で接していればその宇宙船の別の位相か部品とし、そうでなければ新しく放出されたものとする。
+   Turtle.rle(c/3)やBomber.rle(周期48)のように複数の成分が一緒に動く宇宙船も1つとして数え、
+   部品の周期の中で最も長いものを宇宙船の周期とする。
+   2周期以上見えなくなった宇宙船は、衝突したか盤面の外に出たものとして終わりを報告する。
+
+-fを付けると差分の更新をせず、毎世代全てのセルをラベル付けし直す(結果が同じになることと、かかる時間の比較用)。
+-qを付けると放出と消失の報告を出さず、最後のまとめだけを表示する。
+
+コンパイル
+  gcc -O2 mylife20.c lifelib.c
+
+引数
+  [-f] [-q] [-g 世代数] [初期状態のファイル] [height] [width]
+
+実行例
+  ./a.out -g 600 gosperglidergun.lif 200 200
+  ./a.out -g 2000 Bomber.rle 300 300
+  ./a.out -g 300 Turtle.rle 100 100
+
+================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include "lifelib.h"
+
+#define MAX_PERIOD 48      // 調べる周期の上限
+#define MAX_SHIP_CELLS 64  // これより大きい成分は宇宙船の候補にしない
+#define SAME_SHIP_DIST 3   // 同じ個体とみなす位置のずれ
+#define SHIP_PART_GAP 2    // 同じ速度の成分の間がこれ以下なら1つの宇宙船の部品とみなす
+#define CONFIRM 2          // 同じずれで何周期続いたら宇宙船とみなすか
+
+/* 連結成分 */
+typedef struct {
+  int cells;                      // セルの数
+  int min_y, min_x, max_y, max_x; // 外接長方形
+  uint64_t hash;                  // 左上を原点にした形のハッシュ
+  int first;                      // Frameのcell_y, cell_xの中での先頭
+  int track;                      // 対応する宇宙船の番号(-1なら無し)
+  int dx, dy, period;             // p世代前の同じ形の成分からのずれ(periodが0なら動いていない)
+  int streak;                     // 同じずれで何周期続けて見つかったか
+  int next_same;                  // 同じハッシュの表で次の成分(-1なら終わり)
+} Component;
+
+/* 1世代分の連結成分 */
+typedef struct {
+  long generation;
+  int n, cap;
+  Component *comps;
+  int ncells, cellcap;
+  int *cell_y, *cell_x;
+  int table_size;
+  int *table; // ハッシュ -> 先頭の成分
+} Frame;
+
+/* 見つけた宇宙船 */
+typedef struct {
+  int dx, dy, period;
+  int cells;
+  uint64_t hash;                    // 追跡している形
+  long first_gen, last_gen;
+  int first_y, first_x;
+  int y, x, h, w;                   // 最後に見た外接長方形
+  int active;
+  int ship;                         // 同じ宇宙船の代表の追跡の番号(自分が代表なら自分)
+  int number;                       // 代表だけ: 宇宙船の通し番号
+  int ship_dx, ship_dy, ship_period; // 代表だけ: 部品の中で最も長い周期のずれ(宇宙船全体の周期)
+} Track;
+
+/* ラン(1行の中で連続した生きたセル) */
+typedef struct {
+  int y, x0, x1;
+} Run;
+
+/*
+  ファイルの中身を全て読み込む関数(lenにバイト数が入る)
+*/
+char *read_file(const char filename[], size_t *len) {
+
+  FILE *fp = fopen(filename, "rb");
+  if (fp == NULL) {
+    fprintf(stderr,"cannot open file %s\n", filename);
+    return NULL;
+  }
+
+  size_t cap = 4096;
+  char *text = malloc(cap);
+  *len = 0;
+  size_t n;
+  while ((n = fread(text + *len, 1, cap - *len, fp)) > 0) {
+    *len += n;
+    if (*len == cap) {
+      cap *= 2;
+      text = realloc(text, cap);
+    }
+  }
+
+  fclose(fp);
+  return text;
+}
+
+/*------------------------------------------------------------------------------------------------
+  Frameの操作
+------------------------------------------------------------------------------------------------*/
+
+void frame_clear(Frame *f, long generation) {
+  f->generation = generation;
+  f->n = 0;
+  f->ncells = 0;
+}
+
+Component *frame_add(Frame *f, int cells) {
+
+  if (f->n == f->cap) {
+    f->cap = f->cap ? f->cap * 2 : 64;
+    f->comps = realloc(f->comps, sizeof(Component) * f->cap);
+  }
+  if (f->ncells + cells > f->cellcap) {
+    while (f->ncells + cells > f->cellcap) f->cellcap = f->cellcap ? f->cellcap * 2 : 1024;
+    f->cell_y = realloc(f->cell_y, sizeof(int) * f->cellcap);
+    f->cell_x = realloc(f->cell_x, sizeof(int) * f->cellcap);
+  }
+
+  Component *c = &f->comps[f->n++];
+  c->cells = cells;
+  c->first = f->ncells;
+  c->track = -1;
+  c->period = 0;
+  c->streak = 0;
+  f->ncells += cells;
+  return c;
+}
+
+int compare_component(const void *a, const void *b) {
+
+  const Component *p = a, *q = b;
+  if (p->min_y != q->min_y) return p->min_y - q->min_y;
+  if (p->min_x != q->min_x) return p->min_x - q->min_x;
+  return (p->hash > q->hash) - (p->hash < q->hash);
+}
+
+/*
+  成分を位置の順に並べ、形のハッシュの表を作る
+*/
+void frame_finish(Frame *f) {
+
+  qsort(f->comps, f->n, sizeof(Component), compare_component);
+
+  int size = 64;
+  while (size < 2 * f->n) size *= 2;
+  if (size > f->table_size) {
+    f->table = realloc(f->table, sizeof(int) * size);
+    f->table_size = size;
+  }
+  for (int i=0; i<f->table_size; i++) f->table[i] = -1;
+
+  for (int i=f->n-1; i>=0; i--) {
+    int h = f->comps[i].hash & (f->table_size - 1);
+    f->comps[i].next_same = f->table[h];
+    f->table[h] = i;
+  }
+}
+
+/* セルの一覧(ラスタ順)から形のハッシュを求める(FNV-1a) */
+uint64_t shape_hash(const Frame *f, const Component *c) {
+
+  uint64_t h = 14695981039346656037ULL;
+  int values[2];
+  for (int i=0; i<c->cells; i++) {
+    values[0] = f->cell_y[c->first + i] - c->min_y;
+    values[1] = f->cell_x[c->first + i] - c->min_x;
+    for (int k=0; k<2; k++) {
+      h ^= (uint64_t)(uint32_t)values[k];
+      h *= 1099511628211ULL;
+    }
+  }
+  return h ^ (uint64_t)c->cells;
+}
+
+/*------------------------------------------------------------------------------------------------
+  連結成分のラベル付け
+------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+  int nruns, runcap;
+  Run *runs;
+  int *parent;
+  int *row_first; // height+1個
+  int *comp_of;   // 根のラン -> 成分の番号
+} Labeler;
+
+int uf_find(int parent[], int i) {
+
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+void uf_union(int parent[], int a, int b) {
+
+  a = uf_find(parent, a);
+  b = uf_find(parent, b);
+  if (a < b) parent[b] = a;
+  else if (b < a) parent[a] = b;
+}
+
+void add_run(Labeler *l, int y, int x0, int x1) {
+
+  if (l->nruns == l->runcap) {
+    l->runcap = l->runcap ? l->runcap * 2 : 1024;
+    l->runs = realloc(l->runs, sizeof(Run) * l->runcap);
+    l->parent = realloc(l->parent, sizeof(int) * l->runcap);
+    l->comp_of = realloc(l->comp_of, sizeof(int) * l->runcap);
+  }
+  l->runs[l->nruns] = (Run){ y, x0, x1 };
+  l->parent[l->nruns] = l->nruns;
+  l->nruns++;
+}
+
+/*
+  bitsの生きたセルを連結成分に分けてfに加える
+  ランの始まりと終わりのビットをワードごとにまとめて求めるので、空のワードはすぐに飛ばせる
+*/
+void label_components(Labeler *l, Frame *f, const uint64_t *bits, int height, int words) {
+
+  l->nruns = 0;
+
+  for (int y=0; y<height; y++) {
+    const uint64_t *row = bits + (size_t)y * words;
+    l->row_first[y] = l->nruns;
+    int open = -1;
+
+    for (int i=0; i<words; i++) {
+      uint64_t v = row[i];
+      if (v == 0) continue;
+      uint64_t prev_bit = (i > 0) ? row[i - 1] >> 63 : 0;
+      uint64_t next_bit = (i + 1 < words) ? row[i + 1] & 1 : 0;
+      uint64_t starts = v & ~((v << 1) | prev_bit);
+      uint64_t ends = v & ~((v >> 1) | (next_bit << 63));
+      uint64_t marks = starts | ends;
+      while (marks != 0) {
+        int b = __builtin_ctzll(marks);
+        marks &= marks - 1;
+        int x = i * 64 + b;
+        if ((starts >> b) & 1) open = x;
+        if ((ends >> b) & 1) add_run(l, y, open, x);
+      }
+    }
+
+    /* 上の行のランで、斜めも含めて接しているものとつなぐ */
+    if (y > 0) {
+      int j = l->row_first[y - 1];
+      const int j_end = l->row_first[y];
+      for (int r=l->row_first[y]; r<l->nruns; r++) {
+        const Run *cur = &l->runs[r];
+        while (j < j_end && l->runs[j].x1 < cur->x0 - 1) j++;
+        for (int k=j; k<j_end && l->runs[k].x0 <= cur->x1 + 1; k++) uf_union(l->parent, r, k);
+      }
+    }
+  }
+  l->row_first[height] = l->nruns;
+
+  /* 根ごとに成分を作る(1回目: 大きさと外接長方形) */
+  const int base = f->n;
+  for (int r=0; r<l->nruns; r++) l->comp_of[r] = -1;
+  for (int r=0; r<l->nruns; r++) {
+    const Run *run = &l->runs[r];
+    int root = uf_find(l->parent, r);
+    if (l->comp_of[root] < 0) {
+      Component *c = frame_add(f, 0);
+      c->min_y = c->max_y = run->y;
+      c->min_x = run->x0;
+      c->max_x = run->x1;
+      l->comp_of[root] = f->n - 1;
+    }
+    Component *c = &f->comps[l->comp_of[root]];
+    c->cells += run->x1 - run->x0 + 1;
+    if (run->y > c->max_y) c->max_y = run->y;
+    if (run->x0 < c->min_x) c->min_x = run->x0;
+    if (run->x1 > c->max_x) c->max_x = run->x1;
+  }
+
+  /* セルの置き場所を割り当てる */
+  int total = 0;
+  for (int i=base; i<f->n; i++) total += f->comps[i].cells;
+  frame_add(f, total); // 場所を確保するための一時的な成分
+  f->n--;
+  int offset = f->ncells - total;
+  for (int i=base; i<f->n; i++) {
+    f->comps[i].first = offset;
+    offset += f->comps[i].cells;
+    f->comps[i].cells = 0;
+  }
+
+  /* 2回目: ランはラスタ順なので、成分ごとのセルもラスタ順に並ぶ */
+  for (int r=0; r<l->nruns; r++) {
+    const Run *run = &l->runs[r];
+    Component *c = &f->comps[l->comp_of[uf_find(l->parent, r)]];
+    for (int x=run->x0; x<=run->x1; x++) {
+      f->cell_y[c->first + c->cells] = run->y;
+      f->cell_x[c->first + c->cells] = x;
+      c->cells++;
+    }
+  }
+
+  for (int i=base; i<f->n; i++) f->comps[i].hash = shape_hash(f, &f->comps[i]);
+}
+
+/*
+  1セル広げた外接長方形の中に変化したセルがあるか
+*/
+int region_changed(const uint64_t *bits, const uint64_t *prev, int height, int width, int words, const Component *c) {
+
+  int y0 = (c->min_y > 0) ? c->min_y - 1 : 0;
+  int y1 = (c->max_y < height - 1) ? c->max_y + 1 : height - 1;
+  int x0 = (c->min_x > 0) ? c->min_x - 1 : 0;
+  int x1 = (c->max_x < width - 1) ? c->max_x + 1 : width - 1;
+
+  for (int y=y0; y<=y1; y++) {
+    const uint64_t *row = bits + (size_t)y * words;
+    const uint64_t *prev_row = prev + (size_t)y * words;
+    for (int i=x0/64; i<=x1/64; i++) {
+      uint64_t mask = ~0ULL;
+      if (i == x0 / 64) mask &= ~0ULL << (x0 % 64);
+      if (i == x1 / 64 && x1 % 64 != 63) mask &= (1ULL << (x1 % 64 + 1)) - 1;
+      if ((row[i] ^ prev_row[i]) & mask) return 1;
+    }
+  }
+  return 0;
+}
+
+/*------------------------------------------------------------------------------------------------
+  宇宙船の追跡
+------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+  int n, cap;
+  Track *tracks;
+  long emitted;
+} Tracker;
+
+int gcd(int a, int b) {
+  while (b != 0) {
+    int t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+/* 速さを"c/4"や"2c/5"のように書く */
+void format_speed(char buf[], size_t size, int dx, int dy, int period) {
+
+  int d = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
+  int g = gcd(d, period);
+  int num = d / g, den = period / g;
+  if (num == 1) snprintf(buf, size, "c/%d", den);
+  else snprintf(buf, size, "%dc/%d", num, den);
+}
+
+const char *ship_name(int dx, int dy, int period) {
+
+  if (period == 4 && abs(dx) == 1 && abs(dy) == 1) return "glider";
+  if (dx == 0 || dy == 0) return "orthogonal spaceship";
+  if (abs(dx) == abs(dy)) return "diagonal spaceship";
+  return "oblique spaceship";
+}
+
+/* (dx1, dy1)/p1と(dx2, dy2)/p2が同じ速度か */
+int same_velocity(int dx1, int dy1, int p1, int dx2, int dy2, int p2) {
+  return dx1 * p2 == dx2 * p1 && dy1 * p2 == dy2 * p1;
+}
+
+/*
+  宇宙船shipの外接長方形を求める関数(見つからなければ0を返す)
+  その宇宙船の全ての追跡(位相・部品)の最後に見た位置を、世代tまで進めたものを合わせる
+*/
+int ship_box(const Tracker *tr, int ship, long t, int box[4]) {
+
+  int found = 0;
+  for (int m=ship; m<tr->n; m++) {
+    const Track *tk = &tr->tracks[m];
+    if (tk->ship != ship || !tk->active || tk->last_gen < t - tk->period) continue;
+    int oy = (int)(tk->dy * (t - tk->last_gen) / tk->period), ox = (int)(tk->dx * (t - tk->last_gen) / tk->period);
+    int y0 = tk->y + oy, x0 = tk->x + ox, y1 = y0 + tk->h - 1, x1 = x0 + tk->w - 1;
+    if (!found || y0 < box[0]) box[0] = y0;
+    if (!found || x0 < box[1]) box[1] = x0;
+    if (!found || y1 > box[2]) box[2] = y1;
+    if (!found || x1 > box[3]) box[3] = x1;
+    found = 1;
+  }
+  return found;
+}
+
+/*
+  外接長方形box(min_y, min_x, max_y, max_x)が、同じ速度で動いている既存の宇宙船(excludeを除く)の
+  外接長方形にSHIP_PART_GAPセル以内で接していればその代表の番号を返す(無ければ-1)
+*/
+int find_ship(const Tracker *tr, const int box[4], int dx, int dy, int p, long t, int exclude) {
+
+  for (int k=0; k<tr->n; k++) {
+    const Track *rep = &tr->tracks[k];
+    if (k == exclude || rep->ship != k || !same_velocity(dx, dy, p, rep->dx, rep->dy, rep->period)) continue;
+
+    int other[4];
+    if (!ship_box(tr, k, t, other)) continue;
+    int gap_y = (box[0] > other[2]) ? box[0] - other[2] - 1 : other[0] - box[2] - 1;
+    int gap_x = (box[1] > other[3]) ? box[1] - other[3] - 1 : other[1] - box[3] - 1;
+    if (gap_y <= SHIP_PART_GAP && gap_x <= SHIP_PART_GAP) return k;
+  }
+  return -1;
+}
+
+/* 宇宙船fromの追跡を全て宇宙船toの部品にする */
+void merge_ship(Tracker *tr, int from, int to) {
+
+  Track *rep = &tr->tracks[to];
+  for (int m=from; m<tr->n; m++) {
+    Track *tk = &tr->tracks[m];
+    if (tk->ship != from) continue;
+    tk->ship = to;
+    if (tk->period > rep->ship_period) {
+      rep->ship_dx = tk->dx;
+      rep->ship_dy = tk->dy;
+      rep->ship_period = tk->period;
+    }
+  }
+}
+
+/* 宇宙船shipの部品がまだ残っているか */
+int ship_active(const Tracker *tr, int ship) {
+
+  for (int k=ship; k<tr->n; k++) {
+    if (tr->tracks[k].ship == ship && tr->tracks[k].active) return 1;
+  }
+  return 0;
+}
+
+/*
+  frame(世代t)の各成分を、p世代前の同じ形の成分と対応させる
+*/
+void match_frame(Tracker *tr, Frame *history[], Frame *f, int quiet) {
+
+  const long t = f->generation;
+
+  for (int i=0; i<f->n; i++) {
+    Component *c = &f->comps[i];
+    if (c->track >= 0 || c->cells > MAX_SHIP_CELLS) continue;
+
+    for (int p=1; p<=MAX_PERIOD && p<=t; p++) {
+      Frame *old = history[p];
+      int found = 0, dx = 0, dy = 0;
+      const Component *match = NULL;
+      for (int j=old->table[c->hash & (old->table_size - 1)]; j>=0; j=old->comps[j].next_same) {
+        const Component *o = &old->comps[j];
+        if (o->hash != c->hash || o->cells != c->cells) continue;
+        int ddx = c->min_x - o->min_x, ddy = c->min_y - o->min_y;
+        if (abs(ddx) > p || abs(ddy) > p) continue;
+        if (!found || (ddx == 0 && ddy == 0)) {
+          found = 1;
+          dx = ddx;
+          dy = ddy;
+          match = o;
+        }
+      }
+      if (!found) continue;
+      if (dx == 0 && dy == 0) break; // 振動子か固定物
+
+      /* 銃の中で一瞬だけ似た形ができることがあるので、同じずれがCONFIRM周期続くまで待つ */
+      c->dx = dx;
+      c->dy = dy;
+      c->period = p;
+      c->streak = (match->period == p && match->dx == dx && match->dy == dy) ? match->streak + 1 : 1;
+      if (c->streak < CONFIRM) break;
+      int old_track = match->track;
+
+      /* p世代前の成分が既に追跡中ならそれを続ける */
+      int id = -1;
+      if (old_track >= 0 && tr->tracks[old_track].dx == dx && tr->tracks[old_track].dy == dy && tr->tracks[old_track].period == p) {
+        id = old_track;
+      }
+      /* 同じ形・同じ速度で直前に近くにいたものを探す */
+      for (int k=0; k<tr->n && id<0; k++) {
+        const Track *tk = &tr->tracks[k];
+        if (!tk->active || tk->hash != c->hash || tk->cells != c->cells) continue;
+        if (tk->dx != dx || tk->dy != dy || tk->period != p) continue;
+        if (abs(tk->y - c->min_y) <= SAME_SHIP_DIST && abs(tk->x - c->min_x) <= SAME_SHIP_DIST && tk->last_gen >= t - p) id = k;
+      }
+      if (id < 0) {
+        int box[4] = {c->min_y, c->min_x, c->max_y, c->max_x};
+        int ship = find_ship(tr, box, dx, dy, p, t, -1);
+        if (tr->n == tr->cap) {
+          tr->cap = tr->cap ? tr->cap * 2 : 64;
+          tr->tracks = realloc(tr->tracks, sizeof(Track) * tr->cap);
+        }
+        id = tr->n++;
+        Track *tk = &tr->tracks[id];
+        tk->dx = dx;
+        tk->dy = dy;
+        tk->period = p;
+        tk->cells = c->cells;
+        tk->hash = c->hash;
+        tk->first_gen = t;
+        tk->first_y = c->min_y;
+        tk->first_x = c->min_x;
+        tk->active = 1;
+        if (ship >= 0) {
+          /* 既にある宇宙船の別の位相か部品(宇宙船全体の周期は部品の周期の中で最も長いもの) */
+          tk->ship = ship;
+          Track *rep = &tr->tracks[ship];
+          if (p > rep->ship_period) {
+            rep->ship_dx = dx;
+            rep->ship_dy = dy;
+            rep->ship_period = p;
+          }
+        } else {
+          /* 新しい宇宙船の候補(番号は下でこの世代の他の候補とまとめてから付ける) */
+          tk->ship = id;
+          tk->number = -1;
+          tk->ship_dx = dx;
+          tk->ship_dy = dy;
+          tk->ship_period = p;
+        }
+      }
+      Track *tk = &tr->tracks[id];
+      tk->y = c->min_y;
+      tk->x = c->min_x;
+      tk->h = c->max_y - c->min_y + 1;
+      tk->w = c->max_x - c->min_x + 1;
+      tk->last_gen = t;
+      c->track = id;
+      break;
+    }
+  }
+
+  /*
+    この世代に新しく見つかった宇宙船の候補のうち、他の宇宙船に接しているものはまとめる
+    (同じ世代に見つかった部品どうしは、調べた順番によらずに1つになるまで繰り返す)
+  */
+  for (int merged = 1; merged; ) {
+    merged = 0;
+    for (int k=0; k<tr->n; k++) {
+      const Track *tk = &tr->tracks[k];
+      int box[4];
+      if (tk->ship != k || tk->number >= 0 || !ship_box(tr, k, t, box)) continue;
+      int ship = find_ship(tr, box, tk->dx, tk->dy, tk->period, t, k);
+      if (ship < 0) continue;
+      /* 代表は番号の小さい方(追跡の番号は代表より後ろになるようにする) */
+      if (ship < k) merge_ship(tr, k, ship);
+      else merge_ship(tr, ship, k);
+      merged = 1;
+    }
+  }
+  for (int k=0; k<tr->n; k++) {
+    Track *tk = &tr->tracks[k];
+    if (tk->ship != k || tk->number >= 0) continue;
+    tk->number = tr->emitted++;
+    if (!quiet) {
+      char speed[16];
+      format_speed(speed, sizeof(speed), tk->ship_dx, tk->ship_dy, tk->ship_period);
+      printf("gen %6ld: #%d %s at (x, y) = (%d, %d), velocity (%+d, %+d)/%d = %s\n",
+             t, tk->number, ship_name(tk->ship_dx, tk->ship_dy, tk->ship_period), tk->x, tk->y,
+             tk->ship_dx, tk->ship_dy, tk->ship_period, speed);
+    }
+  }
+
+  /* 2周期以上見えない部品は終わりにし、宇宙船の最後の部品なら宇宙船の終わりを報告する */
+  for (int k=0; k<tr->n; k++) {
+    Track *tk = &tr->tracks[k];
+    if (!tk->active || tk->last_gen >= t - 2 * tk->period) continue;
+    tk->active = 0;
+    if (quiet || ship_active(tr, tk->ship)) continue;
+    const Track *rep = &tr->tracks[tk->ship];
+    printf("gen %6ld: #%d %s lost near (x, y) = (%d, %d) after travelling (%+d, %+d)\n",
+           t, rep->number, ship_name(rep->ship_dx, rep->ship_dy, rep->ship_period), tk->x, tk->y, tk->x - tk->first_x, tk->y - tk->first_y);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  long gens = 1000;
+  int full = 0;
+  int quiet = 0;
+
+  /* オプション */
+  while (argc >= 2 && argv[1][0] == '-') {
+    if (strcmp(argv[1], "-f") == 0) {
+      full = 1;
+      argc--;
+      argv++;
+    } else if (strcmp(argv[1], "-q") == 0) {
+      quiet = 1;
+      argc--;
+      argv++;
+    } else if (argc >= 3 && strcmp(argv[1], "-g") == 0) {
+      gens = atol(argv[2]);
+      argc -= 2;
+      argv += 2;
+    } else {
+      break;
+    }
+  }
+
+  if (argc < 2 || argc > 4) {
+    fprintf(stderr, "usage: %s [-f] [-q] [-g generations] [filename for init] [height] [width]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const int height = (argc >= 3) ? atoi(argv[2]) : 40;
+  const int width = (argc >= 4) ? atoi(argv[3]) : 70;
+
+  life_universe *u = life_create(height, width);
+  if (u == NULL) {
+    fprintf(stderr, "invalid size %dx%d\n", height, width);
+    return EXIT_FAILURE;
+  }
+
+  size_t len;
+  char *text = read_file(argv[1], &len);
+  if (text == NULL) return EXIT_FAILURE;
+  if (life_load(u, text, len) != 0) {
+    fprintf(stderr, "cannot load %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+  free(text);
+
+  const int words = life_row_words(u);
+  const size_t nwords = (size_t)height * words;
+  uint64_t *bits = calloc(nwords, sizeof(uint64_t));
+  uint64_t *prev = calloc(nwords, sizeof(uint64_t));
+  uint64_t *work = malloc(sizeof(uint64_t) * nwords);
+
+  Labeler labeler;
+  memset(&labeler, 0, sizeof(labeler));
+  labeler.row_first = malloc(sizeof(int) * (height + 1));
+
+  /* frames[(gen) % (MAX_PERIOD + 1)]が世代genの成分 */
+  Frame frames[MAX_PERIOD + 1];
+  memset(frames, 0, sizeof(frames));
+  Tracker tracker;
+  memset(&tracker, 0, sizeof(tracker));
+
+  double step_sec = 0, track_sec = 0;
+  long carried = 0, relabelled = 0;
+
+  for (long gen=0; gen<=gens; gen++) {
+    clock_t t0 = clock();
+    if (gen > 0) life_step(u, 1);
+    clock_t t1 = clock();
+
+    uint64_t *tmp = prev;
+    prev = bits;
+    bits = tmp;
+    life_export_bits(u, bits);
+
+    Frame *f = &frames[gen % (MAX_PERIOD + 1)];
+    Frame *history[MAX_PERIOD + 1];
+    for (int p=1; p<=MAX_PERIOD; p++) history[p] = &frames[(gen + MAX_PERIOD + 1 - p) % (MAX_PERIOD + 1)];
+    frame_clear(f, gen);
+
+    /* 変わっていない成分を前の世代から引き継ぎ、そのセルはラベル付けから外す */
+    memcpy(work, bits, sizeof(uint64_t) * nwords);
+    if (!full && gen > 0) {
+      const Frame *last = history[1];
+      for (int i=0; i<last->n; i++) {
+        const Component *o = &last->comps[i];
+        if (region_changed(bits, prev, height, width, words, o)) continue;
+        Component *c = frame_add(f, o->cells);
+        int first = c->first;
+        *c = *o;
+        c->first = first;
+        for (int k=0; k<o->cells; k++) {
+          int y = last->cell_y[o->first + k], x = last->cell_x[o->first + k];
+          f->cell_y[first + k] = y;
+          f->cell_x[first + k] = x;
+          work[(size_t)y * words + x / 64] &= ~(1ULL << (x % 64));
+        }
+      }
+    }
+    carried += f->n;
+    int before = f->n;
+
+    label_components(&labeler, f, work, height, words);
+    relabelled += f->n - before;
+    frame_finish(f);
+    match_frame(&tracker, history, f, quiet);
+    clock_t t2 = clock();
+
+    step_sec += (double)(t1 - t0) / CLOCKS_PER_SEC;
+    track_sec += (double)(t2 - t1) / CLOCKS_PER_SEC;
+  }
+
+  /* まとめ: 速度ごとの数(部品は代表の宇宙船にまとめて数える) */
+  printf("\n%ld generations, %ld spaceships emitted (%s)\n", gens, tracker.emitted, full ? "full relabelling" : "incremental");
+  int *counted = calloc(tracker.n + 1, sizeof(int));
+  for (int k=0; k<tracker.n; k++) {
+    const Track *tk = &tracker.tracks[k];
+    if (counted[k] || tk->ship != k) continue;
+    int count = 0, alive = 0;
+    for (int m=k; m<tracker.n; m++) {
+      const Track *tm = &tracker.tracks[m];
+      if (tm->ship == m && tm->ship_dx == tk->ship_dx && tm->ship_dy == tk->ship_dy && tm->ship_period == tk->ship_period) {
+        counted[m] = 1;
+        count++;
+        alive += ship_active(&tracker, m);
+      }
+    }
+    char speed[16];
+    format_speed(speed, sizeof(speed), tk->ship_dx, tk->ship_dy, tk->ship_period);
+    printf("  %-20s velocity (%+d, %+d)/%d = %-5s: %d emitted, %d still flying\n",
+           ship_name(tk->ship_dx, tk->ship_dy, tk->ship_period), tk->ship_dx, tk->ship_dy, tk->ship_period, speed, count, alive);
+  }
+  printf("components: %ld carried over, %ld relabelled\n", carried, relabelled);
+  printf("time: step %.3f s, tracking %.3f s\n", step_sec, track_sec);
+
+  free(counted);
+  for (int i=0; i<=MAX_PERIOD; i++) {
+    free(frames[i].comps);
+    free(frames[i].cell_y);
+    free(frames[i].cell_x);
+    free(frames[i].table);
+  }
+  free(tracker.tracks);
+  free(labeler.runs);
+  free(labeler.parent);
+  free(labeler.comp_of);
+  free(labeler.row_first);
+  free(bits);
+  free(prev);
+  free(work);
+  life_destroy(u);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,352 @@
+/*================================================================================================
+
+拡大・縮小とスクロールができる対話的な表示
+
+my_print_cells()は毎回height x widthの盤面全体を描くので、大きな盤面では表示に時間がかかる。
+ここでは端末に見えている範囲だけをlife_get_view()で取り出して描くので、
+描画にかかる時間は盤面の大きさによらず、画面の大きさ(と縮小率)だけで決まる。
+縮小しているときは、1文字がzoom x zoomセルのブロックを表し、生きたセルの割合で文字を変える。
+
+端末はrawモード(1文字ずつ、エコー無し)にして、キーが押されていなくても待たずに世代を進める。
+終了するとき(qやCtrl-C)は端末の設定を元に戻す。
+
+キー
+  矢印, h j k l   : 画面の1/4ずつスクロール   H J K L : 1画面ずつスクロール
+  + -             : 拡大・縮小(縮小率は2倍ずつ)  c o : 盤面の中央・左上へ移る
+  スペース        : 一時停止・再開               n : 1世代だけ進める
+  数字のあとEnter : その世代数だけまとめて進める
+  f s             : 速く・遅くする               q : 終了
+
+コンパイル
+  gcc -O2 mylife21.c lifelib.c
+
+引数
+  [初期状態のファイル] [height] [width]
+
+実行例
+  ./a.out gosperglidergun.lif 1000 100000
+
+================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h> // sleep()関数を使う
+#include <time.h>
+#include <string.h>
+#include <signal.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <sys/select.h>
+#include "lifelib.h"
+
+#define MAX_ZOOM 4096
+#define MIN_DELAY 1000      // 世代ごとの待ち時間の下限(マイクロ秒)
+#define MAX_DELAY 2000000
+#define RUN_SLICE 50000     // まとめて進めるときに描き直す間隔(マイクロ秒)
+
+/*
+  ファイルの中身を全て読み込む関数(lenにバイト数が入る)
+*/
+char *read_file(const char filename[], size_t *len) {
+
+  FILE *fp = fopen(filename, "rb");
+  if (fp == NULL) {
+    fprintf(stderr,"cannot open file %s\n", filename);
+    return NULL;
+  }
+
+  size_t cap = 4096;
+  char *text = malloc(cap);
+  *len = 0;
+  size_t n;
+  while ((n = fread(text + *len, 1, cap - *len, fp)) > 0) {
+    *len += n;
+    if (*len == cap) {
+      cap *= 2;
+      text = realloc(text, cap);
+    }
+  }
+
+  fclose(fp);
+  return text;
+}
+
+/*------------------------------------------------------------------------------------------------
+  端末の設定
+------------------------------------------------------------------------------------------------*/
+
+struct termios saved_termios;
+int raw_mode = 0;
+
+void restore_terminal() {
+
+  if (!raw_mode) return;
+  tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved_termios);
+  fputs("\e[0m\e[?25h\e[?1049l", stdout); // 色を戻し、カーソルを表示し、元の画面に戻る
+  fflush(stdout);
+  raw_mode = 0;
+}
+
+void on_signal(int sig) {
+
+  restore_terminal();
+  signal(sig, SIG_DFL);
+  raise(sig);
+}
+
+int enter_raw_mode() {
+
+  if (tcgetattr(STDIN_FILENO, &saved_termios) != 0) {
+    fprintf(stderr, "stdin is not a terminal\n");
+    return -1;
+  }
+
+  struct termios raw = saved_termios;
+  raw.c_lflag &= ~(ICANON | ECHO);
+  raw.c_cc[VMIN] = 0;
+  raw.c_cc[VTIME] = 0;
+  if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) != 0) return -1;
+  raw_mode = 1;
+
+  atexit(restore_terminal);
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+  signal(SIGHUP, on_signal);
+
+  fputs("\e[?1049h\e[?25l\e[2J", stdout); // 別の画面に切り替え、カーソルを隠す
+  return 0;
+}
+
+/* 端末の大きさ(取れなければ24x80) */
+void terminal_size(int *rows, int *cols) {
+
+  struct winsize ws;
+  if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0 && ws.ws_col > 0) {
+    *rows = ws.ws_row;
+    *cols = ws.ws_col;
+  } else {
+    *rows = 24;
+    *cols = 80;
+  }
+}
+
+/*
+  キーが押されるかtimeoutマイクロ秒経つまで待ち、押されたキーを返す(無ければ-1)
+  矢印キーのエスケープシーケンスは'h' 'j' 'k' 'l'に直す
+*/
+int read_key(long timeout) {
+
+  fd_set fds;
+  FD_ZERO(&fds);
+  FD_SET(STDIN_FILENO, &fds);
+  struct timeval tv = { timeout / 1000000, timeout % 1000000 };
+  if (select(STDIN_FILENO + 1, &fds, NULL, NULL, &tv) <= 0) return -1;
+
+  unsigned char c;
+  if (read(STDIN_FILENO, &c, 1) != 1) return -1;
+  if (c != '\e') return c;
+
+  unsigned char seq[2];
+  if (read(STDIN_FILENO, &seq[0], 1) != 1 || read(STDIN_FILENO, &seq[1], 1) != 1) return '\e';
+  if (seq[0] != '[') return -1;
+  switch (seq[1]) {
+  case 'A': return 'k';
+  case 'B': return 'j';
+  case 'C': return 'l';
+  case 'D': return 'h';
+  }
+  return -1;
+}
+
+/*------------------------------------------------------------------------------------------------
+  表示
+------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+  long y, x;        // 画面の左上のセル
+  int zoom;         // 1文字が表すセルの辺の長さ
+  int rows, cols;   // 盤面を描く文字数
+  long delay;       // 世代ごとの待ち時間(マイクロ秒)
+  int paused;
+  long pending;     // 入力中の世代数
+  long run;         // まとめて進める残りの世代数
+} View;
+
+/* 生きたセルの割合から文字を選ぶ */
+char density_char(uint32_t count, int zoom) {
+
+  if (count == 0) return ' ';
+  if (zoom == 1) return '#';
+  uint64_t area = (uint64_t)zoom * zoom;
+  if (count * 8 < area) return '.';
+  if (count * 4 < area) return ':';
+  if (count * 2 < area) return 'o';
+  return '#';
+}
+
+/*
+  見えている範囲だけを取り出し、1画面分を1つのバッファに作ってから1回で書き出す
+*/
+void draw(const life_universe *u, const View *v, uint32_t *counts, char *buf) {
+
+  life_stats stats;
+  life_get_stats(u, &stats);
+  life_get_view(u, v->y, v->x, v->rows, v->cols, v->zoom, counts);
+
+  char *p = buf;
+  p += sprintf(p, "\e[H\e[7m gen %ld  alive %ld  (x, y) = (%ld, %ld)  zoom 1:%d  %ld ms/gen  %s",
+               stats.generation, stats.alive, v->x, v->y, v->zoom, v->delay / 1000,
+               v->paused ? "paused" : (v->run > 0 ? "running N" : "running"));
+  if (v->pending > 0) p += sprintf(p, "  run %ld?", v->pending);
+  p += sprintf(p, "\e[K\e[0m\r\n");
+
+  for (int r=0; r<v->rows; r++) {
+    int red = 0;
+    for (int c=0; c<v->cols; c++) {
+      long cy = v->y + (long)r * v->zoom, cx = v->x + (long)c * v->zoom;
+      char ch = density_char(counts[r * v->cols + c], v->zoom);
+      if (ch == ' ' && (cy < 0 || stats.height <= cy || cx < 0 || stats.width <= cx)) ch = '~'; // 盤面の外
+      if ((ch != ' ' && ch != '~') != red) {
+        red = !red;
+        p += sprintf(p, red ? "\e[31m" : "\e[0m"); // 赤色で表示
+      }
+      *p++ = ch;
+    }
+    p += sprintf(p, "\e[0m\e[K\r\n");
+  }
+  p += sprintf(p, "\e[7m arrows/hjkl: pan  +/-: zoom  c/o: center/origin  space: pause  n: step  <N>Enter: run N  f/s: speed  q: quit\e[K\e[0m");
+
+  fwrite(buf, 1, p - buf, stdout);
+  fflush(stdout);
+}
+
+/* 画面の中心を保ったまま縮小率を変える */
+void set_zoom(View *v, int zoom) {
+
+  if (zoom < 1 || zoom > MAX_ZOOM) return;
+  long cy = v->y + (long)v->rows * v->zoom / 2;
+  long cx = v->x + (long)v->cols * v->zoom / 2;
+  v->zoom = zoom;
+  v->y = cy - (long)v->rows * zoom / 2;
+  v->x = cx - (long)v->cols * zoom / 2;
+}
+
+void center(View *v, int height, int width) {
+  v->y = height / 2 - (long)v->rows * v->zoom / 2;
+  v->x = width / 2 - (long)v->cols * v->zoom / 2;
+}
+
+/*
+  キーを処理する。終了するなら0を返す
+*/
+int handle_key(View *v, int key, int height, int width) {
+
+  long step_y = (long)v->rows * v->zoom, step_x = (long)v->cols * v->zoom;
+
+  switch (key) {
+  case 'q': return 0;
+  case 'h': v->x -= step_x / 4; break;
+  case 'l': v->x += step_x / 4; break;
+  case 'k': v->y -= step_y / 4; break;
+  case 'j': v->y += step_y / 4; break;
+  case 'H': v->x -= step_x; break;
+  case 'L': v->x += step_x; break;
+  case 'K': v->y -= step_y; break;
+  case 'J': v->y += step_y; break;
+  case '+': case '=': set_zoom(v, v->zoom / 2); break;
+  case '-': case '_': set_zoom(v, v->zoom * 2); break;
+  case 'c': center(v, height, width); break;
+  case 'o': v->y = 0; v->x = 0; break;
+  case ' ': v->paused = !v->paused; v->run = 0; break;
+  case 'f': if (v->delay / 2 >= MIN_DELAY) v->delay /= 2; break;
+  case 's': if (v->delay * 2 <= MAX_DELAY) v->delay *= 2; break;
+  case '\r': case '\n':
+    v->run = v->pending;
+    v->pending = 0;
+    break;
+  case 127: case '\b': v->pending /= 10; break;
+  default:
+    if ('0' <= key && key <= '9' && v->pending < 100000000) v->pending = v->pending * 10 + (key - '0');
+    break;
+  }
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 2 || argc > 4) {
+    fprintf(stderr, "usage: %s [filename for init] [height] [width]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const int height = (argc >= 3) ? atoi(argv[2]) : 40;
+  const int width = (argc >= 4) ? atoi(argv[3]) : 70;
+
+  life_universe *u = life_create(height, width);
+  if (u == NULL) {
+    fprintf(stderr, "invalid size %dx%d\n", height, width);
+    return EXIT_FAILURE;
+  }
+
+  size_t len;
+  char *text = read_file(argv[1], &len);
+  if (text == NULL) return EXIT_FAILURE;
+  if (life_load(u, text, len) != 0) {
+    fprintf(stderr, "cannot load %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+  free(text);
+
+  if (enter_raw_mode() != 0) return EXIT_FAILURE;
+
+  View v = { 0, 0, 1, 0, 0, 200 * 1000, 0, 0, 0 };
+  int term_rows, term_cols;
+  terminal_size(&term_rows, &term_cols);
+  v.rows = term_rows - 2;
+  v.cols = term_cols;
+  uint32_t *counts = NULL;
+  char *buf = NULL;
+  int size_changed = 1;
+
+  for (;;) {
+    /* 端末の大きさが変わったらバッファを作り直す */
+    terminal_size(&term_rows, &term_cols);
+    if (size_changed || term_rows - 2 != v.rows || term_cols != v.cols) {
+      v.rows = (term_rows > 2) ? term_rows - 2 : 1;
+      v.cols = term_cols;
+      counts = realloc(counts, sizeof(uint32_t) * v.rows * v.cols);
+      buf = realloc(buf, (size_t)(v.rows + 2) * (v.cols * 10 + 64) + 256); // 1文字ごとに色を変えても足りる大きさ
+      fputs("\e[2J", stdout);
+      size_changed = 0;
+    }
+
+    draw(u, &v, counts, buf);
+
+    /* 待っている間に押されたキーを処理する(一時停止中は押されるまで待つ) */
+    long wait = (v.run > 0) ? 0 : v.delay;
+    int key = read_key(v.paused && v.run == 0 ? 1000000 : wait);
+    if (key >= 0) {
+      if (!handle_key(&v, key, height, width)) break;
+      if (key != 'n') continue; // 操作の結果をすぐに描き直す
+    }
+
+    if (v.run > 0) {
+      /* キーの反応が遅れないように、RUN_SLICEマイクロ秒ごとに描き直してキーを見る */
+      struct timespec start, now;
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      do {
+        life_step(u, 1);
+        v.run--;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+      } while (v.run > 0 && (now.tv_sec - start.tv_sec) * 1000000L + (now.tv_nsec - start.tv_nsec) / 1000 < RUN_SLICE);
+    } else if (!v.paused || key == 'n') {
+      life_step(u, 1);
+    }
+  }
+
+  restore_terminal();
+  free(counts);
+  free(buf);
+  life_destroy(u);
+  return EXIT_SUCCESS;
+}
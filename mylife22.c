@@ -0,0 +1,671 @@
+/*================================================================================================
+
+ワークスティーリングによるタイル単位の並列更新
+
+盤面を横の帯に分けて各スレッドに固定で割り当てると(mylife13.c)、グライダー銃の出すグライダーの列のように
+動きが盤面の一部に集まっているとき、静かな帯を担当したスレッドは待っているだけになる。
+ここでは盤面をTILE_H x TILE_Wのタイルに分け、次のようにしてスレッドの仕事を均す。
+
+1. 前の世代で変化したタイルと、その周りの8つのタイルだけを計算する。
+   それ以外のタイルは2世代続けて同じなので、次の世代の配列にも既に同じ値が入っており、何もしなくてよい。
+2. 計算するタイルを、帯に分けたときの持ち主のスレッドの両端キュー(deque)に入れる。
+   前の世代で変化したタイルは後から入れて、持ち主が先に取り出すようにする(変化が続く可能性が高いため)。
+3. 各スレッドは自分のdequeの末尾から取り出して計算し、空になったら他のスレッドのdequeの先頭から盗む。
+   世代の途中でタイルが増えることはないので、全てのdequeが空になればその世代の仕事は終わり。
+
+-sを付けると盗まずに持ち主だけが計算する(比較用)。-cを付けるとmy_update_cells()の結果と毎世代比べる。
+最後にスレッドごとの計算したタイル数・盗んだ数・稼働率を表示する。
+
+コンパイル
+  gcc -O2 -pthread mylife22.c
+
+引数
+  [-t スレッド数] [-g 世代数] [-s] [-c] [初期状態のファイル(省略時はランダム)] [height] [width]
+
+実行例
+  ./a.out -t 4 gosperglidergun.lif
+  ./a.out -t 8 -g 2000 gosperglidergun.lif 2048 2048
+
+================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h> // sleep()関数を使う
+#include <time.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+/* デフォルトのルール */
+int can_survive[9] = {0, 0, 1, 1, 0};
+int can_born[9] = {0, 0, 0, 1, 0};
+char rule_S[10] = "23";
+char rule_B[10] = "3";
+
+/*
+  文字列strの最後がsuffixに一致するか判定する関数
+*/
+int ends_with(const char str[], const char suffix[]) {
+
+  int len_str = strlen(str);
+  int len_suf = strlen(suffix);
+
+  if (len_str < len_suf) return 0;
+
+  char lower_str[255];
+  char lower_suffix[255];
+  strcpy(lower_str, str);
+  strcpy(lower_suffix, suffix);
+
+  /* 大文字は全て小文字にする */
+  for (int i=0; lower_str[i] != 0; i++) {
+    if ('A' <= lower_str[i] && lower_str[i] <= 'Z') {
+      lower_str[i] += 'a' - 'A';
+    }
+  }
+  for (int i=0; lower_suffix[i] != 0; i++) {
+    if ('A' <= lower_suffix[i] && lower_suffix[i] <= 'Z') {
+      lower_suffix[i] += 'a' - 'A';
+    }
+  }
+
+  return (strcmp(lower_str + len_str - len_suf, lower_suffix) == 0);
+}
+
+/*
+  文字列を10進数で表した時の長さを返す関数
+  ただし、0の長さは0とする
+*/
+int number_len(int n) {
+  int len = 0;
+  while(n > 0) {
+    len++;
+    n /= 10;
+  }
+
+  return len;
+}
+
+/*
+  文字が空白、タブ、CR、LFのいずれかなら1を返す関数
+*/
+int isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+int loadRLE(const int height, const int width, int cell[height][width], FILE *fp) {
+
+  char buffer[(int)1e4+1]; // 1行は70文字以下だが念のため
+  int y = 0, x = 0;
+  int offsetY = 0, offsetX = 0;
+  while(fgets(buffer, 1e4, fp) != NULL) {
+
+    /* オフセット指定以外のヘッダー情報は読み飛ばす */
+    if (buffer[0] == '#') {
+      if (buffer[1] == 'P' || buffer[1] == 'R') {
+        sscanf(buffer+2, "%d%d", &offsetX, &offsetY);
+        if (offsetY < 0 || offsetX < 0) {
+          offsetY = 0;
+          offsetX = 0;
+        } else {
+          y = offsetY;
+          x = offsetX;
+        }
+      }
+      continue;
+    }
+
+    /* サイズ情報は読み飛ばし、ルールは反映する */
+    if (buffer[0] == 'x') {
+      int result = sscanf(buffer, "x = %*d, y = %*d, rule = B%9[^/n]/S%9s", rule_B, rule_S);
+
+      for (int i=0; i<=8; i++) {
+        can_survive[i] = 0;
+        can_born[i] = 0;
+      }
+
+      for (int i=0; i<10; i++) {
+        int s = rule_S[i] - '0';
+        int b = rule_B[i] - '0';
+        if (0 <= s && s <= 8) can_survive[s] = 1;
+        if (0 <= b && b <= 8) can_born[b] = 1;
+      }
+
+      continue;
+    }
+
+    int offset = 0; // 行の何文字目を次に読むか
+    while(1) {
+      int len = 0; // ランの長さ
+      char c; // タグ('o', 'b', '$', '!'のいずれか)
+
+      // 途中に空白が入っても対応可能
+      while(isWhitespace(buffer[offset])) offset++;
+
+      // ランの長さを取得(1が省略されている場合は何も読み込まない)
+      int result = sscanf(buffer+offset, "%d", &len);
+      // 読み込んだ分だけoffsetを加算(ただし0のままの場合は読みこんでないのでそのまま)
+      offset += number_len(len);
+
+      // 長さ省略時は1
+      if (len == 0) len = 1;
+
+      // ランのタグを取得
+      result = sscanf(buffer+offset, "%c", &c);
+      offset++;
+
+      if (result <= 0 || c == '!') { // 終了
+        break;
+      } else if (c == '$') { // 改行
+        y += len;
+        x = offsetX;
+      } else if (c == 'b') { // dead
+        x += len;
+      } else if (c == 'o') { // alive
+        for (int i=0; i<len; i++) {
+          if (0 <= y && y < height && 0 <= x && x < width) cell[y][x] = 1; // 盤面の外は無視する
+          x++;
+        }
+      } else {
+        fprintf(stderr,"Invalid syntax\n");
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ ファイルによるセルの初期化: 生きているセルの座標が記述されたファイルをもとに2次元配列の状態を初期化する
+ fp = NULL のときは、関数内で適宜定められた初期状態に初期化する。関数内初期値はdefault.lif と同じもの
+ */
+int my_init_cells(const int height, const int width, int cell[height][width], char filename[]) {
+
+  if (filename[0] == 0) {
+    /* ランダムに配置する */
+    srand(time(NULL));
+
+    for (int y=0; y<height; y++) {
+      for (int x=0; x<width; x++) {
+        cell[y][x] = (rand() % 10 == 0 ? 1 : 0);
+      }
+    }
+  } else {
+
+    FILE *fp = fopen(filename,"r");
+    if (fp == NULL) {
+      fprintf(stderr,"cannot open file %s\n", filename);
+      return EXIT_FAILURE;
+    }
+
+    if (ends_with(filename, ".lif")) {
+
+      fscanf(fp, "%*[^\n]\n"); // バージョン情報は読み飛ばす
+
+      int x, y;
+      while (fscanf(fp, "%d%d", &x, &y) > 0) {
+        if (0 <= y && y < height && 0 <= x && x < width) cell[y][x] = 1; // 盤面の外は無視する
+      }
+
+    } else if (ends_with(filename, ".rle")) {
+
+      int result = loadRLE(height, width, cell, fp);
+      if (result != 0) return EXIT_FAILURE;
+
+    } else {
+
+      fprintf(stderr,"Supported: .lif .rle\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ グリッドの描画: 世代情報とグリッドの配列等を受け取り、ファイルポインタに該当する出力にグリッドを描画する
+ */
+void my_print_cells(FILE *fp, int gen, const int height, const int width, int cell[height][width]) {
+
+  /* 0,1それぞれの状態のセルをカウント */
+  int count_cells[2] = {0, 0};
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      count_cells[cell[y][x]]++;
+    }
+  }
+
+  // 世代情報と存在比を表示
+  fprintf(fp, "rule: B%s/S%s, generateion = %d, alive:dead = %7d:%7d\r\n", rule_B, rule_S, gen, count_cells[1], count_cells[0]);
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  /* グリッド */
+  for (int y=0; y<height; y++) {
+    fprintf(fp, "|");
+    for (int x=0; x<width; x++) {
+      fprintf(fp, "\e[31m%c\e[0m", (cell[y][x] ? '#' : ' ')); // 赤色で表示
+    }
+    fprintf(fp, "|\r\n");
+  }
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  fflush(fp);
+}
+
+int in_cells(int y, int x, const int height, const int width) {
+
+  if (y < 0 || height <= y) return 0;
+  if (x < 0 || width <= x) return 0;
+
+  return 1;
+}
+
+/*
+ 着目するセルの周辺の生きたセルをカウントする関数
+ */
+int my_count_adjacent_cells(int y, int x, const int height, const int width, int cell[height][width]) {
+
+  /*
+    dy, dx: 相対位置
+    012
+    7.3
+    654
+  */
+  int dy[] = {-1, -1, -1, 0, 1, 1, 1, 0};
+  int dx[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+
+  int count = 0;
+  
+  for (int i=0; i<8; i++) {
+
+    int ny = y + dy[i];
+    int nx = x + dx[i];
+
+    if (in_cells(ny, nx, height, width) && cell[ny][nx]) {
+      count++;
+    }
+
+  }
+
+  return count;
+}
+
+/*
+  着目するセルの次の世代での状態を返す関数
+*/
+int next_state(int y, int x, const int height, const int width, int cell[height][width], int neighbors) {
+
+  if (cell[y][x]) { 
+    return can_survive[neighbors];
+  } else {
+    return can_born[neighbors];
+  }
+
+}
+
+/*
+ ライフゲームのルールに基づいて2次元配列の状態を更新する
+ */
+void my_update_cells(const int height, const int width, int cell[height][width]) {
+
+  int next_cell[height][width];
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      next_cell[y][x] = 0;
+    }
+  }
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      int neighbors = my_count_adjacent_cells(y, x, height, width, cell);
+      next_cell[y][x] = next_state(y, x, height, width, cell, neighbors);
+    }
+  }
+
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      cell[y][x] = next_cell[y][x];
+    }
+  }
+
+}
+
+/*------------------------------------------------------------------------------------------------
+  タイルとdeque
+------------------------------------------------------------------------------------------------*/
+
+#define TILE_H 16
+#define TILE_W 64
+
+/*
+  スレッドごとの両端キュー
+  持ち主はbottom側から、他のスレッドはtop側から取り出す。世代の途中で入れることはないので、
+  入れるのは世代の始めにmainだけが行い、取り出しだけを排他する。
+  盗む側はロックを取る前に空かどうかを見るので、top, bottomはアトミックにしておく。
+*/
+typedef struct {
+  int *tiles;
+  _Atomic int top, bottom; // [top, bottom)に入っている
+  pthread_mutex_t lock;
+} Deque;
+
+int deque_pop(Deque *d) {
+
+  int tile = -1;
+  pthread_mutex_lock(&d->lock);
+  if (d->top < d->bottom) tile = d->tiles[--d->bottom];
+  pthread_mutex_unlock(&d->lock);
+  return tile;
+}
+
+int deque_steal(Deque *d) {
+
+  /* ロックを取らずに空かどうかを見る(空なら以後増えない) */
+  if (atomic_load_explicit(&d->top, memory_order_relaxed) >= atomic_load_explicit(&d->bottom, memory_order_relaxed)) return -1;
+  int tile = -1;
+  pthread_mutex_lock(&d->lock);
+  if (d->top < d->bottom) tile = d->tiles[d->top++];
+  pthread_mutex_unlock(&d->lock);
+  return tile;
+}
+
+typedef struct {
+  long tiles;  // 計算したタイル数
+  long steals; // 盗んだタイル数
+  double busy; // タイルを計算していた時間
+} WorkerStats;
+
+typedef struct {
+  int height;
+  int width;
+  int threads;
+  int tiles_y, tiles_x;
+  int *cell;          // 今の世代
+  int *next_cell;     // 次の世代
+  char *changed;      // タイルごとに、今の世代で前の世代から変化したか
+  char *next_changed; // 次の世代で変化したか
+  Deque *deques;
+  int steal;          // 0なら盗まない
+  int done;           // 1になったらスレッドは終了する
+  pthread_barrier_t barrier;
+  WorkerStats *stats;
+} Shared;
+
+typedef struct {
+  int id;
+  Shared *shared;
+} Worker;
+
+double now_sec() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+  1つのタイルを1世代進め、変化したかを返す関数
+  盤面の端に接しないタイルは範囲の確認をせずに近傍を数える
+*/
+int update_tile(const int height, const int width, int cell[height][width], int next_cell[height][width], int tile_y, int tile_x) {
+
+  const int y0 = tile_y * TILE_H, x0 = tile_x * TILE_W;
+  const int y1 = (y0 + TILE_H < height) ? y0 + TILE_H : height;
+  const int x1 = (x0 + TILE_W < width) ? x0 + TILE_W : width;
+  const int inner = (y0 > 0 && x0 > 0 && y1 < height && x1 < width);
+  int changed = 0;
+
+  for (int y=y0; y<y1; y++) {
+    for (int x=x0; x<x1; x++) {
+      int neighbors;
+      if (inner) {
+        neighbors = cell[y-1][x-1] + cell[y-1][x] + cell[y-1][x+1]
+                  + cell[y][x-1]                  + cell[y][x+1]
+                  + cell[y+1][x-1] + cell[y+1][x] + cell[y+1][x+1];
+      } else {
+        neighbors = my_count_adjacent_cells(y, x, height, width, cell);
+      }
+      int next = next_state(y, x, height, width, cell, neighbors);
+      changed |= (next != cell[y][x]);
+      next_cell[y][x] = next;
+    }
+  }
+  return changed;
+}
+
+/*
+  世代の始めに、計算するタイルを持ち主のdequeに入れる関数(mainが呼ぶ)
+  帯に分けたときと同じく、タイルの行で持ち主を決める。変化したタイルは後から入れる
+*/
+long schedule_tiles(Shared *s) {
+
+  const int ty = s->tiles_y, tx = s->tiles_x;
+  long count = 0;
+
+  for (int i=0; i<s->threads; i++) {
+    s->deques[i].top = 0;
+    s->deques[i].bottom = 0;
+  }
+
+  for (int pass=0; pass<2; pass++) {
+    for (int y=0; y<ty; y++) {
+      Deque *d = &s->deques[(int)((long)y * s->threads / ty)];
+      for (int x=0; x<tx; x++) {
+        int self = s->changed[y * tx + x];
+        int near = 0;
+        for (int dy=-1; dy<=1 && !near; dy++) {
+          for (int dx=-1; dx<=1 && !near; dx++) {
+            int ny = y + dy, nx = x + dx;
+            if (0 <= ny && ny < ty && 0 <= nx && nx < tx && s->changed[ny * tx + nx]) near = 1;
+          }
+        }
+        /* 1回目は周りだけが変化したタイル、2回目は自分が変化したタイル */
+        if ((pass == 0 && near && !self) || (pass == 1 && self)) {
+          d->tiles[d->bottom++] = y * tx + x;
+          count++;
+        }
+        if (pass == 0) s->next_changed[y * tx + x] = 0;
+      }
+    }
+  }
+  return count;
+}
+
+void *worker_main(void *arg) {
+
+  Worker *w = arg;
+  Shared *s = w->shared;
+  const int height = s->height;
+  const int width = s->width;
+  WorkerStats *st = &s->stats[w->id];
+
+  while (1) {
+    pthread_barrier_wait(&s->barrier); // 世代の開始(またはdoneの通知)
+    if (s->done) break;
+
+    int (*cell)[width] = (int (*)[width])s->cell;
+    int (*next_cell)[width] = (int (*)[width])s->next_cell;
+    double start = now_sec();
+    int victim = w->id;
+
+    while (1) {
+      int tile = deque_pop(&s->deques[w->id]);
+      if (tile < 0 && s->steal) {
+        /* 他のスレッドを順に見て盗む(前回盗めたスレッドから始める) */
+        for (int i=0; i<s->threads && tile<0; i++) {
+          int v = (victim + i) % s->threads;
+          if (v == w->id) continue;
+          tile = deque_steal(&s->deques[v]);
+          if (tile >= 0) {
+            victim = v;
+            st->steals++;
+          }
+        }
+      }
+      if (tile < 0) break;
+
+      int changed = update_tile(height, width, cell, next_cell, tile / s->tiles_x, tile % s->tiles_x);
+      s->next_changed[tile] = changed; // タイルごとに書くスレッドは1つだけ
+      st->tiles++;
+    }
+
+    st->busy += now_sec() - start;
+    pthread_barrier_wait(&s->barrier); // 世代の終了
+  }
+
+  return NULL;
+}
+
+int main(int argc, char **argv)
+{
+  FILE *fp = stdout;
+  int threads = 1;
+  int gens = -1; // -1なら表示しながら無限に進める
+  int steal = 1;
+  int check = 0;
+
+  /* オプション */
+  while (argc >= 2 && argv[1][0] == '-') {
+    if (strcmp(argv[1], "-s") == 0) {
+      steal = 0;
+      argc--;
+      argv++;
+    } else if (strcmp(argv[1], "-c") == 0) {
+      check = 1;
+      argc--;
+      argv++;
+    } else if (argc >= 3 && strcmp(argv[1], "-t") == 0) {
+      threads = atoi(argv[2]);
+      argc -= 2;
+      argv += 2;
+    } else if (argc >= 3 && strcmp(argv[1], "-g") == 0) {
+      gens = atoi(argv[2]);
+      argc -= 2;
+      argv += 2;
+    } else {
+      break;
+    }
+  }
+
+  if (argc > 4 || threads < 1) {
+    fprintf(stderr, "usage: %s [-t threads] [-g generations] [-s] [-c] [filename for init] [height] [width]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const int height = (argc >= 3) ? atoi(argv[2]) : 40;
+  const int width = (argc >= 4) ? atoi(argv[3]) : 70;
+  if (height <= 0 || width <= 0) {
+    fprintf(stderr, "invalid size %dx%d\n", height, width);
+    return EXIT_FAILURE;
+  }
+
+  Shared shared;
+  shared.height = height;
+  shared.width = width;
+  shared.threads = threads;
+  shared.tiles_y = (height + TILE_H - 1) / TILE_H;
+  shared.tiles_x = (width + TILE_W - 1) / TILE_W;
+  const int ntiles = shared.tiles_y * shared.tiles_x;
+  shared.cell = calloc((size_t)height * width, sizeof(int));
+  shared.next_cell = calloc((size_t)height * width, sizeof(int));
+  shared.changed = malloc(ntiles);
+  shared.next_changed = malloc(ntiles);
+  shared.deques = malloc(sizeof(Deque) * threads);
+  shared.stats = calloc(threads, sizeof(WorkerStats));
+  shared.steal = steal;
+  shared.done = 0;
+  if (shared.cell == NULL || shared.next_cell == NULL) {
+    fprintf(stderr, "cannot allocate %dx%d cells\n", height, width);
+    return EXIT_FAILURE;
+  }
+  for (int i=0; i<threads; i++) {
+    shared.deques[i].tiles = malloc(sizeof(int) * ntiles);
+    pthread_mutex_init(&shared.deques[i].lock, NULL);
+  }
+  memset(shared.changed, 1, ntiles); // 最初の世代は全てのタイルを計算する
+  pthread_barrier_init(&shared.barrier, NULL, threads + 1);
+
+  /* ファイルを引数にとるか、ない場合はデフォルトの初期値を使う */
+  int result = my_init_cells(height, width, (int (*)[width])shared.cell, (argc >= 2) ? argv[1] : "");
+  if (result != 0) return EXIT_FAILURE;
+
+  int *expected = NULL;
+  if (check) {
+    expected = malloc(sizeof(int) * (size_t)height * width);
+    memcpy(expected, shared.cell, sizeof(int) * (size_t)height * width);
+  }
+
+  pthread_t tids[threads];
+  Worker workers[threads];
+  for (int i=0; i<threads; i++) {
+    workers[i].id = i;
+    workers[i].shared = &shared;
+    pthread_create(&tids[i], NULL, worker_main, &workers[i]);
+  }
+
+  double start = now_sec();
+  long scheduled = 0;
+  if (gens < 0) my_print_cells(fp, 0, height, width, (int (*)[width])shared.cell); // 表示する
+
+  /* 世代を進める*/
+  for (int gen = 1 ; gens < 0 || gen <= gens; gen++) {
+    scheduled += schedule_tiles(&shared);
+    pthread_barrier_wait(&shared.barrier); // 各スレッドがタイルを更新する
+    pthread_barrier_wait(&shared.barrier);
+
+    int *tmp = shared.cell;
+    shared.cell = shared.next_cell;
+    shared.next_cell = tmp;
+    char *tmp_changed = shared.changed;
+    shared.changed = shared.next_changed;
+    shared.next_changed = tmp_changed;
+
+    if (check) {
+      my_update_cells(height, width, (int (*)[width])expected);
+      if (memcmp(expected, shared.cell, sizeof(int) * (size_t)height * width) != 0) {
+        fprintf(stderr, "generation %d: mismatch with my_update_cells()\n", gen);
+        return EXIT_FAILURE;
+      }
+    }
+
+    if (gens < 0) {
+      my_print_cells(fp, gen, height, width, (int (*)[width])shared.cell);  // 表示する
+      usleep(200*1000); //0.2秒休止する
+      fprintf(fp,"\e[%dA",height+3);//height+3 の分、カーソルを上に戻す(壁2、表示部1)
+    }
+  }
+
+  double sec = now_sec() - start;
+  fprintf(stderr, "%d generations: %.3f s, %.1f%% of %d tiles computed per generation%s\n", gens, sec,
+          100.0 * scheduled / ((double)ntiles * gens), ntiles, check ? ", matches my_update_cells()" : "");
+  for (int i=0; i<threads; i++) {
+    const WorkerStats *st = &shared.stats[i];
+    fprintf(stderr, "  thread %2d: %8ld tiles, %7ld stolen, busy %5.1f%%\n", i, st->tiles, st->steals, 100.0 * st->busy / sec);
+  }
+
+  shared.done = 1;
+  pthread_barrier_wait(&shared.barrier);
+  for (int i=0; i<threads; i++) pthread_join(tids[i], NULL);
+  pthread_barrier_destroy(&shared.barrier);
+
+  for (int i=0; i<threads; i++) {
+    free(shared.deques[i].tiles);
+    pthread_mutex_destroy(&shared.deques[i].lock);
+  }
+  free(shared.deques);
+  free(shared.stats);
+  free(shared.changed);
+  free(shared.next_changed);
+  free(shared.cell);
+  free(shared.next_cell);
+  free(expected);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,625 @@
+/*================================================================================================
+
+圧縮されたパターンファイルの読み込み(gzip, zstd)
+
+大きなパターンは圧縮して配られていることが多く、これまではディスク上に展開してから読み込んでいた。
+ここでは.rle.gz, .lif.gz, .zstなどのファイルを展開しながらそのまま読み込む。
+
+圧縮の形式は拡張子ではなく、ファイルの先頭のマジックナンバーで判定する。
+  1f 8b       : gzip (zlibのgzread()で展開する)
+  28 b5 2f fd : zstd (zstdコマンドを子プロセスとして起動し、パイプから展開された内容を読む)
+  それ以外    : 圧縮なし
+どの場合もPatternSourceのread()でCHUNK_SIZEずつ読み出し、パーサーに少しずつ渡す(push型のパーサー)。
+パーサーは1文字ずつ状態を進めるので、ランの長さや行がチャンクの境目で切れていても正しく読める。
+ファイル全体をメモリに置くことはないので、何GBのパターンでも使うメモリは盤面とチャンク1つ分だけで済む。
+(mylife3.cのloadRLE()は1行を1万文字のバッファに読むので、長い行は途中で切れてしまっていた。)
+
+RLEかLife 1.06かは、圧縮の拡張子(.gz, .zst)を除いた拡張子で判定し、分からなければ
+展開した最初のチャンクが"#Life 1.06"で始まるかどうかで判定する。
+盤面の外に出るセルは数えるだけで書き込まない。
+
+-lを付けると読み込みだけを行い、読んだバイト数・セル数・かかった時間を表示して終わる。
+
+コンパイル
+  gcc -O2 mylife23.c -lz
+
+引数
+  [-l] [初期状態のファイル] [height] [width]
+
+実行例
+  gzip -k gosperglidergun.lif && ./a.out gosperglidergun.lif.gz
+  zstd Bomber.rle && ./a.out Bomber.rle.zst 100 100
+  ./a.out -l huge_pattern.rle.gz 100000 100000
+
+================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h> // sleep()関数を使う
+#include <time.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/wait.h>
+#include <zlib.h>
+
+/* デフォルトのルール */
+int can_survive[9] = {0, 0, 1, 1, 0};
+int can_born[9] = {0, 0, 0, 1, 0};
+char rule_S[10] = "23";
+char rule_B[10] = "3";
+
+/*
+  文字列strの最後がsuffixに一致するか判定する関数
+*/
+int ends_with(const char str[], const char suffix[]) {
+
+  int len_str = strlen(str);
+  int len_suf = strlen(suffix);
+
+  if (len_str < len_suf) return 0;
+
+  char lower_str[255];
+  char lower_suffix[255];
+  strcpy(lower_str, str);
+  strcpy(lower_suffix, suffix);
+
+  /* 大文字は全て小文字にする */
+  for (int i=0; lower_str[i] != 0; i++) {
+    if ('A' <= lower_str[i] && lower_str[i] <= 'Z') {
+      lower_str[i] += 'a' - 'A';
+    }
+  }
+  for (int i=0; lower_suffix[i] != 0; i++) {
+    if ('A' <= lower_suffix[i] && lower_suffix[i] <= 'Z') {
+      lower_suffix[i] += 'a' - 'A';
+    }
+  }
+
+  return (strcmp(lower_str + len_str - len_suf, lower_suffix) == 0);
+}
+
+/*
+  文字列を10進数で表した時の長さを返す関数
+  ただし、0の長さは0とする
+*/
+int number_len(int n) {
+  int len = 0;
+  while(n > 0) {
+    len++;
+    n /= 10;
+  }
+
+  return len;
+}
+
+/*
+  文字が空白、タブ、CR、LFのいずれかなら1を返す関数
+*/
+int isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/*------------------------------------------------------------------------------------------------
+  展開しながら読む入力
+------------------------------------------------------------------------------------------------*/
+
+#define CHUNK_SIZE (64 * 1024)
+
+enum { COMPRESS_NONE, COMPRESS_GZIP, COMPRESS_ZSTD };
+const char *compress_names[] = { "none", "gzip", "zstd" };
+
+/*
+  パターンの入力
+  read()は最大n バイトをbufに読み、読んだバイト数(終わりなら0、エラーなら-1)を返す
+*/
+typedef struct PatternSource {
+  int compress;
+  long long bytes; // 展開後に読んだバイト数
+  long (*read)(struct PatternSource *src, char *buf, size_t n);
+  int (*close)(struct PatternSource *src);
+  FILE *fp;   // 圧縮なし
+  gzFile gz;  // gzip
+  int fd;     // zstd: 子プロセスからのパイプ
+  pid_t pid;
+} PatternSource;
+
+long plain_read(PatternSource *src, char *buf, size_t n) {
+  size_t r = fread(buf, 1, n, src->fp);
+  return (r == 0 && ferror(src->fp)) ? -1 : (long)r;
+}
+
+int plain_close(PatternSource *src) {
+  return fclose(src->fp);
+}
+
+long gzip_read(PatternSource *src, char *buf, size_t n) {
+  return gzread(src->gz, buf, n);
+}
+
+int gzip_close(PatternSource *src) {
+  return (gzclose(src->gz) == Z_OK) ? 0 : -1;
+}
+
+long zstd_read(PatternSource *src, char *buf, size_t n) {
+
+  while (1) {
+    ssize_t r = read(src->fd, buf, n);
+    if (r >= 0 || errno != EINTR) return r;
+  }
+}
+
+int zstd_close(PatternSource *src) {
+
+  int status;
+  close(src->fd);
+  waitpid(src->pid, &status, 0);
+  return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : -1;
+}
+
+/*
+  ファイルの先頭のマジックナンバーを見て、展開しながら読めるように開く関数
+*/
+int open_source(PatternSource *src, const char filename[]) {
+
+  FILE *fp = fopen(filename, "rb");
+  if (fp == NULL) {
+    fprintf(stderr,"cannot open file %s\n", filename);
+    return EXIT_FAILURE;
+  }
+
+  unsigned char magic[4] = {0};
+  size_t n = fread(magic, 1, sizeof(magic), fp);
+  rewind(fp);
+
+  memset(src, 0, sizeof(*src));
+
+  if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+    fclose(fp);
+    src->gz = gzopen(filename, "rb");
+    if (src->gz == NULL) {
+      fprintf(stderr,"cannot open gzip file %s\n", filename);
+      return EXIT_FAILURE;
+    }
+    gzbuffer(src->gz, CHUNK_SIZE);
+    src->compress = COMPRESS_GZIP;
+    src->read = gzip_read;
+    src->close = gzip_close;
+
+  } else if (n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+    fclose(fp);
+    int pipefd[2];
+    if (pipe(pipefd) != 0) {
+      perror("pipe");
+      return EXIT_FAILURE;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+      perror("fork");
+      return EXIT_FAILURE;
+    }
+    if (pid == 0) {
+      /* 子プロセス: 展開した内容を標準出力(パイプ)に書く */
+      dup2(pipefd[1], STDOUT_FILENO);
+      close(pipefd[0]);
+      close(pipefd[1]);
+      execlp("zstd", "zstd", "-dcq", "--", filename, (char *)NULL);
+      fprintf(stderr, "cannot run zstd to read %s\n", filename);
+      _exit(127);
+    }
+    close(pipefd[1]);
+    src->fd = pipefd[0];
+    src->pid = pid;
+    src->compress = COMPRESS_ZSTD;
+    src->read = zstd_read;
+    src->close = zstd_close;
+
+  } else {
+    src->fp = fp;
+    src->compress = COMPRESS_NONE;
+    src->read = plain_read;
+    src->close = plain_close;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*------------------------------------------------------------------------------------------------
+  push型のパーサー
+  feed()に渡されたチャンクを1文字ずつ処理し、チャンクをまたぐ状態は全て構造体に持つ
+------------------------------------------------------------------------------------------------*/
+
+#define HEADER_LINE_MAX 256 // '#'や'x'で始まる行は、これより長い部分を無視する
+
+typedef struct {
+  int height, width;
+  int *cell;          // cell[y * width + x]
+  int error;
+  int done;           // RLEの'!'を読んだ
+  int line_start;     // 次の文字が行の先頭か
+  int in_header;      // '#'や'x'で始まる行を読んでいる途中か
+  char line[HEADER_LINE_MAX];
+  int line_len;
+  long long y, x;     // RLE: 次に書く位置
+  long long offset_x;
+  long long count;    // RLE: 読み途中のランの長さ(0なら省略)
+  long long alive;    // 盤面に置いたセル
+  long long clipped;  // 盤面の外に出たセル
+} PatternParser;
+
+void parser_init(PatternParser *p, const int height, const int width, int cell[height][width]) {
+
+  memset(p, 0, sizeof(*p));
+  p->height = height;
+  p->width = width;
+  p->cell = &cell[0][0];
+  p->line_start = 1;
+}
+
+void parser_set(PatternParser *p, long long y, long long x) {
+
+  if (0 <= y && y < p->height && 0 <= x && x < p->width) {
+    p->cell[y * p->width + x] = 1;
+    p->alive++;
+  } else {
+    p->clipped++;
+  }
+}
+
+/* RLEの'x = ..., rule = ...'の行からルールを反映する */
+void parse_rule_line(const char line[]) {
+
+  if (sscanf(line, "x = %*d, y = %*d, rule = %*[Bb]%9[^/\n]/%*[Ss]%9s", rule_B, rule_S) != 2) return;
+
+  for (int i=0; i<=8; i++) {
+    can_survive[i] = 0;
+    can_born[i] = 0;
+  }
+
+  for (int i=0; i<10; i++) {
+    int s = rule_S[i] - '0';
+    int b = rule_B[i] - '0';
+    if (0 <= s && s <= 8) can_survive[s] = 1;
+    if (0 <= b && b <= 8) can_born[b] = 1;
+  }
+}
+
+/* '#'や'x'で始まる行を1行読み終えたときの処理 */
+void rle_header_line(PatternParser *p) {
+
+  p->line[p->line_len] = 0;
+
+  if (p->line[0] == '#' && (p->line[1] == 'P' || p->line[1] == 'R')) {
+    int offsetX = 0, offsetY = 0;
+    sscanf(p->line+2, "%d%d", &offsetX, &offsetY);
+    if (offsetY >= 0 && offsetX >= 0) {
+      p->y = offsetY;
+      p->x = offsetX;
+      p->offset_x = offsetX;
+    }
+  } else if (p->line[0] == 'x') {
+    parse_rule_line(p->line);
+  }
+}
+
+void rle_feed(PatternParser *p, const char *buf, size_t n) {
+
+  for (size_t i=0; i<n && !p->done && !p->error; i++) {
+    char c = buf[i];
+
+    /* 行の先頭が'#'か'x'ならヘッダーの行 */
+    if (p->line_start && (c == '#' || c == 'x')) {
+      p->in_header = 1;
+      p->line_len = 0;
+    }
+    p->line_start = (c == '\n');
+
+    if (p->in_header) {
+      if (c == '\n') {
+        rle_header_line(p);
+        p->in_header = 0;
+      } else if (p->line_len < HEADER_LINE_MAX - 1) {
+        p->line[p->line_len++] = c;
+      }
+      continue;
+    }
+
+    if ('0' <= c && c <= '9') { // ランの長さ
+      p->count = p->count * 10 + (c - '0');
+      continue;
+    }
+    if (isWhitespace(c)) continue; // 途中に空白が入っても対応可能
+
+    long long len = (p->count == 0) ? 1 : p->count; // 長さ省略時は1
+    p->count = 0;
+
+    if (c == '!') { // 終了
+      p->done = 1;
+    } else if (c == '$') { // 改行
+      p->y += len;
+      p->x = p->offset_x;
+    } else if (c == 'b') { // dead
+      p->x += len;
+    } else if (c == 'o') { // alive
+      for (long long k=0; k<len; k++) {
+        if (p->x >= p->width || p->y >= p->height) { // 残りは全て盤面の外
+          p->clipped += len - k;
+          p->x += len - k;
+          break;
+        }
+        parser_set(p, p->y, p->x);
+        p->x++;
+      }
+    } else {
+      fprintf(stderr,"Invalid syntax\n");
+      p->error = 1;
+    }
+  }
+}
+
+/* Life 1.06の1行("x y")を読み終えたときの処理 */
+void life106_line(PatternParser *p) {
+
+  p->line[p->line_len] = 0;
+  p->line_len = 0;
+  if (p->line[0] == '#') return; // バージョン情報などは読み飛ばす
+
+  long long x, y;
+  if (sscanf(p->line, "%lld%lld", &x, &y) == 2) parser_set(p, y, x);
+}
+
+void life106_feed(PatternParser *p, const char *buf, size_t n) {
+
+  for (size_t i=0; i<n; i++) {
+    char c = buf[i];
+    if (c == '\n') {
+      life106_line(p);
+    } else if (p->line_len < HEADER_LINE_MAX - 1) {
+      p->line[p->line_len++] = c;
+    }
+  }
+}
+
+/* 圧縮の拡張子(.gz, .zst)を除いて、パターンの形式を拡張子から判定する(分からなければ0) */
+int format_from_name(const char filename[]) {
+
+  char name[255];
+  snprintf(name, sizeof(name), "%s", filename);
+  int len = strlen(name);
+  if (ends_with(name, ".gz")) name[len - 3] = 0;
+  else if (ends_with(name, ".zst")) name[len - 4] = 0;
+
+  if (ends_with(name, ".lif")) return 'l';
+  if (ends_with(name, ".rle")) return 'r';
+  return 0;
+}
+
+/*
+ ファイルによるセルの初期化: 生きているセルの座標が記述されたファイルをもとに2次元配列の状態を初期化する
+ filenameが空文字列のときは、ランダムに初期化する
+ */
+int my_init_cells(const int height, const int width, int cell[height][width], char filename[]) {
+
+  if (filename[0] == 0) {
+    /* ランダムに配置する */
+    srand(time(NULL));
+
+    for (int y=0; y<height; y++) {
+      for (int x=0; x<width; x++) {
+        cell[y][x] = (rand() % 10 == 0 ? 1 : 0);
+      }
+    }
+    return EXIT_SUCCESS;
+  }
+
+  PatternSource src;
+  if (open_source(&src, filename) != 0) return EXIT_FAILURE;
+
+  PatternParser parser;
+  parser_init(&parser, height, width, cell);
+
+  char *chunk = malloc(CHUNK_SIZE);
+  int format = format_from_name(filename);
+  long n;
+
+  while ((n = src.read(&src, chunk, CHUNK_SIZE)) > 0) {
+    if (format == 0) { // 最初のチャンクの中身で判定する
+      format = (n >= 10 && strncmp(chunk, "#Life 1.06", 10) == 0) ? 'l' : 'r';
+    }
+    src.bytes += n;
+    if (format == 'l') {
+      life106_feed(&parser, chunk, n);
+    } else {
+      rle_feed(&parser, chunk, n);
+    }
+    if (parser.error || parser.done) break;
+  }
+  if (format == 'l' && parser.line_len > 0) life106_line(&parser); // 改行で終わらない最後の行
+
+  int read_error = (n < 0);
+  int close_error = src.close(&src) != 0 && !parser.done; // '!'の後で読むのをやめた場合は展開側のエラーを無視する
+  free(chunk);
+
+  if (parser.error) return EXIT_FAILURE;
+  if (read_error || close_error) {
+    fprintf(stderr,"cannot read %s (compression: %s)\n", filename, compress_names[src.compress]);
+    return EXIT_FAILURE;
+  }
+
+  fprintf(stderr, "loaded %s: compression %s, %s, %lld bytes, %lld cells", filename, compress_names[src.compress],
+          format == 'l' ? "Life 1.06" : "RLE", src.bytes, parser.alive);
+  if (parser.clipped > 0) fprintf(stderr, " (%lld outside the board)", parser.clipped);
+  fprintf(stderr, "\n");
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ グリッドの描画: 世代情報とグリッドの配列等を受け取り、ファイルポインタに該当する出力にグリッドを描画する
+ */
+void my_print_cells(FILE *fp, int gen, const int height, const int width, int cell[height][width]) {
+
+  /* 0,1それぞれの状態のセルをカウント */
+  int count_cells[2] = {0, 0};
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      count_cells[cell[y][x]]++;
+    }
+  }
+
+  // 世代情報と存在比を表示
+  fprintf(fp, "rule: B%s/S%s, generateion = %d, alive:dead = %7d:%7d\r\n", rule_B, rule_S, gen, count_cells[1], count_cells[0]);
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  /* グリッド */
+  for (int y=0; y<height; y++) {
+    fprintf(fp, "|");
+    for (int x=0; x<width; x++) {
+      fprintf(fp, "\e[31m%c\e[0m", (cell[y][x] ? '#' : ' ')); // 赤色で表示
+    }
+    fprintf(fp, "|\r\n");
+  }
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  fflush(fp);
+}
+
+int in_cells(int y, int x, const int height, const int width) {
+
+  if (y < 0 || height <= y) return 0;
+  if (x < 0 || width <= x) return 0;
+
+  return 1;
+}
+
+/*
+ 着目するセルの周辺の生きたセルをカウントする関数
+ */
+int my_count_adjacent_cells(int y, int x, const int height, const int width, int cell[height][width]) {
+
+  /*
+    dy, dx: 相対位置
+    012
+    7.3
+    654
+  */
+  int dy[] = {-1, -1, -1, 0, 1, 1, 1, 0};
+  int dx[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+
+  int count = 0;
+  
+  for (int i=0; i<8; i++) {
+
+    int ny = y + dy[i];
+    int nx = x + dx[i];
+
+    if (in_cells(ny, nx, height, width) && cell[ny][nx]) {
+      count++;
+    }
+
+  }
+
+  return count;
+}
+
+/*
+  着目するセルの次の世代での状態を返す関数
+*/
+int next_state(int y, int x, const int height, const int width, int cell[height][width], int neighbors) {
+
+  if (cell[y][x]) { 
+    return can_survive[neighbors];
+  } else {
+    return can_born[neighbors];
+  }
+
+}
+
+/*
+ ライフゲームのルールに基づいて2次元配列の状態を更新する
+ */
+void my_update_cells(const int height, const int width, int cell[height][width]) {
+
+  int next_cell[height][width];
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      next_cell[y][x] = 0;
+    }
+  }
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      int neighbors = my_count_adjacent_cells(y, x, height, width, cell);
+      next_cell[y][x] = next_state(y, x, height, width, cell, neighbors);
+    }
+  }
+
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      cell[y][x] = next_cell[y][x];
+    }
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  FILE *fp = stdout;
+  int load_only = 0;
+
+  if (argc >= 2 && strcmp(argv[1], "-l") == 0) {
+    load_only = 1;
+    argc--;
+    argv++;
+  }
+
+  if (argc > 4) {
+    fprintf(stderr, "usage: %s [-l] [filename for init] [height] [width]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const int height = (argc >= 3) ? atoi(argv[2]) : 40;
+  const int width = (argc >= 4) ? atoi(argv[3]) : 70;
+  if (height <= 0 || width <= 0) {
+    fprintf(stderr, "invalid size %dx%d\n", height, width);
+    return EXIT_FAILURE;
+  }
+
+  /* 大きな盤面も読めるように、盤面はヒープに置く */
+  int (*cell)[width] = calloc((size_t)height * width, sizeof(int));
+  if (cell == NULL) {
+    fprintf(stderr, "cannot allocate %dx%d cells\n", height, width);
+    return EXIT_FAILURE;
+  }
+
+  /* ファイルを引数にとるか、ない場合はデフォルトの初期値を使う */
+  clock_t start = clock();
+  int result = my_init_cells(height, width, cell, (argc >= 2) ? argv[1] : "");
+  if (result != 0) return EXIT_FAILURE;
+
+  if (load_only) {
+    fprintf(stderr, "%.3f s cpu\n", (double)(clock() - start) / CLOCKS_PER_SEC);
+    free(cell);
+    return EXIT_SUCCESS;
+  }
+
+  my_print_cells(fp, 0, height, width, cell); // 表示する
+
+  /* 世代を進める*/
+  for (int gen = 1 ;; gen++) {
+    my_update_cells(height, width, cell); // セルを更新
+    my_print_cells(fp, gen, height, width, cell);  // 表示する
+    usleep(200*1000); //0.2秒休止する
+    fprintf(fp,"\e[%dA",height+3);//height+3 の分、カーソルを上に戻す(壁2、表示部1)
+  }
+
+  free(cell);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,801 @@
+/*================================================================================================
+
+メモリに乗らない大きな盤面(メモリマップしたファイルのタイルをページングする)
+
+盤面がメモリより大きいときのために、盤面をローカルディスクのファイルに置き、mmapして更新する。
+ファイルの中では、盤面を1bit/セルに詰めたTILE_ROWS行 x TILE_WORDSワード(1024セル)のタイルに分け、
+上のタイル行から順に、1つのタイル行の中では左のタイルから順に並べる。
+更新もこの順(タイル行ごと)に行うので、ファイルは先頭から末尾へ順に読み書きされる。
+
+更新はmylife7.cと同じくその場で行う。タイル行を1つメモリ上のバッファに取り出し、
+1つ上のタイル行の最後の行(更新前)と、1つ下のタイル行の最初の行(まだ更新していない)を使って計算し、書き戻す。
+  - 次のタイル行はmadvise(MADV_WILLNEED)で先読みしておく
+  - 書き終えたタイル行はsync_file_range()で書き出しを始め、madvise(MADV_DONTNEED)でプロセスから外す
+  - さらに前のタイル行は書き出しが済んでいるので、posix_fadvise(POSIX_FADV_DONTNEED)でページキャッシュからも捨てる
+こうしてメモリに残るのは、前後数個のタイル行だけになる。
+
+ファイルの先頭(4096バイト)には大きさ・世代数・ルールを書いておき、-kで続きから計算できる。
+ランダムな初期状態は、3つの乱数のANDを取って約1/8のセルを生きたセルにする(1ワードずつ作る)。
+パターンファイルを読むときは、左上のPATTERN_MAX x PATTERN_MAXの範囲にmy_init_cells()で読み込んでから書き込む(範囲の外のセルは無視する)。
+-cを付けると毎世代my_update_cells()の結果と比べる(小さい盤面で確かめる用)。
+
+コンパイル
+  gcc -O2 mylife24.c
+
+引数
+  [-g 世代数] [-o 盤面のファイル] [-k] [-c] [初期状態のファイル(省略時はランダム)] [height] [width]
+
+実行例
+  ./a.out -g 100 -o /data/big.grid "" 400000 400000
+    160Gセル(20GB)の盤面をランダムに作り100世代進める
+  ./a.out -g 100 -o /data/big.grid -k
+    続きから100世代進める
+  ./a.out -c -g 200 -o /tmp/gun.grid gosperglidergun.lif 300 3000
+
+================================================================================================*/
+
+#define _GNU_SOURCE // sync_file_range()を使う
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h> // sleep()関数を使う
+#include <time.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* デフォルトのルール */
+int can_survive[9] = {0, 0, 1, 1, 0};
+int can_born[9] = {0, 0, 0, 1, 0};
+char rule_S[10] = "23";
+char rule_B[10] = "3";
+
+/*
+  文字列strの最後がsuffixに一致するか判定する関数
+*/
+int ends_with(const char str[], const char suffix[]) {
+
+  int len_str = strlen(str);
+  int len_suf = strlen(suffix);
+
+  if (len_str < len_suf) return 0;
+
+  char lower_str[255];
+  char lower_suffix[255];
+  strcpy(lower_str, str);
+  strcpy(lower_suffix, suffix);
+
+  /* 大文字は全て小文字にする */
+  for (int i=0; lower_str[i] != 0; i++) {
+    if ('A' <= lower_str[i] && lower_str[i] <= 'Z') {
+      lower_str[i] += 'a' - 'A';
+    }
+  }
+  for (int i=0; lower_suffix[i] != 0; i++) {
+    if ('A' <= lower_suffix[i] && lower_suffix[i] <= 'Z') {
+      lower_suffix[i] += 'a' - 'A';
+    }
+  }
+
+  return (strcmp(lower_str + len_str - len_suf, lower_suffix) == 0);
+}
+
+/*
+  文字列を10進数で表した時の長さを返す関数
+  ただし、0の長さは0とする
+*/
+int number_len(int n) {
+  int len = 0;
+  while(n > 0) {
+    len++;
+    n /= 10;
+  }
+
+  return len;
+}
+
+/*
+  文字が空白、タブ、CR、LFのいずれかなら1を返す関数
+*/
+int isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+int loadRLE(const int height, const int width, int cell[height][width], FILE *fp) {
+
+  char buffer[(int)1e4+1]; // 1行は70文字以下だが念のため
+  int y = 0, x = 0;
+  int offsetY = 0, offsetX = 0;
+  while(fgets(buffer, 1e4, fp) != NULL) {
+
+    /* オフセット指定以外のヘッダー情報は読み飛ばす */
+    if (buffer[0] == '#') {
+      if (buffer[1] == 'P' || buffer[1] == 'R') {
+        sscanf(buffer+2, "%d%d", &offsetX, &offsetY);
+        if (offsetY < 0 || offsetX < 0) {
+          offsetY = 0;
+          offsetX = 0;
+        } else {
+          y = offsetY;
+          x = offsetX;
+        }
+      }
+      continue;
+    }
+
+    /* サイズ情報は読み飛ばし、ルールは反映する */
+    if (buffer[0] == 'x') {
+      int result = sscanf(buffer, "x = %*d, y = %*d, rule = B%9[^/n]/S%9s", rule_B, rule_S);
+
+      for (int i=0; i<=8; i++) {
+        can_survive[i] = 0;
+        can_born[i] = 0;
+      }
+
+      for (int i=0; i<10; i++) {
+        int s = rule_S[i] - '0';
+        int b = rule_B[i] - '0';
+        if (0 <= s && s <= 8) can_survive[s] = 1;
+        if (0 <= b && b <= 8) can_born[b] = 1;
+      }
+
+      continue;
+    }
+
+    int offset = 0; // 行の何文字目を次に読むか
+    while(1) {
+      int len = 0; // ランの長さ
+      char c; // タグ('o', 'b', '$', '!'のいずれか)
+
+      // 途中に空白が入っても対応可能
+      while(isWhitespace(buffer[offset])) offset++;
+
+      // ランの長さを取得(1が省略されている場合は何も読み込まない)
+      int result = sscanf(buffer+offset, "%d", &len);
+      // 読み込んだ分だけoffsetを加算(ただし0のままの場合は読みこんでないのでそのまま)
+      offset += number_len(len);
+
+      // 長さ省略時は1
+      if (len == 0) len = 1;
+
+      // ランのタグを取得
+      result = sscanf(buffer+offset, "%c", &c);
+      offset++;
+
+      if (result <= 0 || c == '!') { // 終了
+        break;
+      } else if (c == '$') { // 改行
+        y += len;
+        x = offsetX;
+      } else if (c == 'b') { // dead
+        x += len;
+      } else if (c == 'o') { // alive
+        for (int i=0; i<len; i++) {
+          if (0 <= y && y < height && 0 <= x && x < width) cell[y][x] = 1; // 盤面の外は無視する
+          x++;
+        }
+      } else {
+        fprintf(stderr,"Invalid syntax\n");
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ ファイルによるセルの初期化: 生きているセルの座標が記述されたファイルをもとに2次元配列の状態を初期化する
+ fp = NULL のときは、関数内で適宜定められた初期状態に初期化する。関数内初期値はdefault.lif と同じもの
+ */
+int my_init_cells(const int height, const int width, int cell[height][width], char filename[]) {
+
+  if (filename[0] == 0) {
+    /* ランダムに配置する */
+    srand(time(NULL));
+
+    for (int y=0; y<height; y++) {
+      for (int x=0; x<width; x++) {
+        cell[y][x] = (rand() % 10 == 0 ? 1 : 0);
+      }
+    }
+  } else {
+
+    FILE *fp = fopen(filename,"r");
+    if (fp == NULL) {
+      fprintf(stderr,"cannot open file %s\n", filename);
+      return EXIT_FAILURE;
+    }
+
+    if (ends_with(filename, ".lif")) {
+
+      fscanf(fp, "%*[^\n]\n"); // バージョン情報は読み飛ばす
+
+      int x, y;
+      while (fscanf(fp, "%d%d", &x, &y) > 0) {
+        if (0 <= y && y < height && 0 <= x && x < width) cell[y][x] = 1; // 盤面の外は無視する
+      }
+
+    } else if (ends_with(filename, ".rle")) {
+
+      int result = loadRLE(height, width, cell, fp);
+      if (result != 0) return EXIT_FAILURE;
+
+    } else {
+
+      fprintf(stderr,"Supported: .lif .rle\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ グリッドの描画: 世代情報とグリッドの配列等を受け取り、ファイルポインタに該当する出力にグリッドを描画する
+ */
+void my_print_cells(FILE *fp, int gen, const int height, const int width, int cell[height][width]) {
+
+  /* 0,1それぞれの状態のセルをカウント */
+  int count_cells[2] = {0, 0};
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      count_cells[cell[y][x]]++;
+    }
+  }
+
+  // 世代情報と存在比を表示
+  fprintf(fp, "rule: B%s/S%s, generateion = %d, alive:dead = %7d:%7d\r\n", rule_B, rule_S, gen, count_cells[1], count_cells[0]);
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  /* グリッド */
+  for (int y=0; y<height; y++) {
+    fprintf(fp, "|");
+    for (int x=0; x<width; x++) {
+      fprintf(fp, "\e[31m%c\e[0m", (cell[y][x] ? '#' : ' ')); // 赤色で表示
+    }
+    fprintf(fp, "|\r\n");
+  }
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  fflush(fp);
+}
+
+int in_cells(int y, int x, const int height, const int width) {
+
+  if (y < 0 || height <= y) return 0;
+  if (x < 0 || width <= x) return 0;
+
+  return 1;
+}
+
+/*
+ 着目するセルの周辺の生きたセルをカウントする関数
+ */
+int my_count_adjacent_cells(int y, int x, const int height, const int width, int cell[height][width]) {
+
+  /*
+    dy, dx: 相対位置
+    012
+    7.3
+    654
+  */
+  int dy[] = {-1, -1, -1, 0, 1, 1, 1, 0};
+  int dx[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+
+  int count = 0;
+  
+  for (int i=0; i<8; i++) {
+
+    int ny = y + dy[i];
+    int nx = x + dx[i];
+
+    if (in_cells(ny, nx, height, width) && cell[ny][nx]) {
+      count++;
+    }
+
+  }
+
+  return count;
+}
+
+/*
+  着目するセルの次の世代での状態を返す関数
+*/
+int next_state(int y, int x, const int height, const int width, int cell[height][width], int neighbors) {
+
+  if (cell[y][x]) { 
+    return can_survive[neighbors];
+  } else {
+    return can_born[neighbors];
+  }
+
+}
+
+/*
+ ライフゲームのルールに基づいて2次元配列の状態を更新する
+ */
+void my_update_cells(const int height, const int width, int cell[height][width]) {
+
+  int next_cell[height][width];
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      next_cell[y][x] = 0;
+    }
+  }
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      int neighbors = my_count_adjacent_cells(y, x, height, width, cell);
+      next_cell[y][x] = next_state(y, x, height, width, cell, neighbors);
+    }
+  }
+
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      cell[y][x] = next_cell[y][x];
+    }
+  }
+
+}
+
+/*------------------------------------------------------------------------------------------------
+  盤面のファイル
+------------------------------------------------------------------------------------------------*/
+
+#define TILE_ROWS 64
+#define TILE_WORDS 16       // 64 x 1024セル = 8KBのタイル
+#define HEADER_SIZE 4096
+#define PATTERN_MAX 4096
+#define GRID_MAGIC "LIFEOOC1"
+
+typedef struct {
+  char magic[8];
+  int64_t height, width;
+  int64_t generation;
+  char rule_B[10];
+  char rule_S[10];
+} GridHeader;
+
+typedef struct {
+  long height, width;
+  long words;           // 1行のワード数(TILE_WORDSの倍数)
+  long tiles_y, tiles_x;
+  size_t band_words;    // 1つのタイル行のワード数
+  int fd;
+  size_t map_size;
+  char *map;
+  GridHeader *header;
+  uint64_t *data;       // タイルの並び
+} Grid;
+
+void grid_set_layout(Grid *g, long height, long width) {
+
+  g->height = height;
+  g->width = width;
+  g->tiles_y = (height + TILE_ROWS - 1) / TILE_ROWS;
+  g->tiles_x = (width + 64 * TILE_WORDS - 1) / (64 * TILE_WORDS);
+  g->words = g->tiles_x * TILE_WORDS;
+  g->band_words = (size_t)TILE_ROWS * g->words;
+  g->map_size = HEADER_SIZE + sizeof(uint64_t) * g->band_words * g->tiles_y;
+}
+
+/*
+  盤面のファイルを開いてmmapする関数
+  createが1なら新しく作り(中身は全て死んだセル)、0なら既存のファイルの大きさとルールを使う
+*/
+int grid_open(Grid *g, const char path[], int create, long height, long width) {
+
+  g->fd = open(path, create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0644);
+  if (g->fd < 0) {
+    perror(path);
+    return EXIT_FAILURE;
+  }
+
+  GridHeader header;
+  if (create) {
+    grid_set_layout(g, height, width);
+    if (ftruncate(g->fd, g->map_size) != 0) { // 穴の空いたファイルになるので、0を書く必要はない
+      perror("ftruncate");
+      return EXIT_FAILURE;
+    }
+  } else {
+    if (pread(g->fd, &header, sizeof(header), 0) != sizeof(header) || memcmp(header.magic, GRID_MAGIC, 8) != 0) {
+      fprintf(stderr, "%s is not a grid file\n", path);
+      return EXIT_FAILURE;
+    }
+    if (header.height <= 0 || header.width <= 0 || header.height > INT32_MAX || header.width > INT32_MAX) {
+      fprintf(stderr, "%s: invalid size %ldx%ld\n", path, (long)header.height, (long)header.width);
+      return EXIT_FAILURE;
+    }
+    grid_set_layout(g, header.height, header.width);
+
+    /* 途中までしかコピーされていないファイルをmmapすると、足りない部分に触れたときにSIGBUSになる */
+    struct stat st;
+    if (fstat(g->fd, &st) != 0 || (size_t)st.st_size < g->map_size) {
+      fprintf(stderr, "%s is truncated (%ld bytes, %zu expected)\n", path, (long)st.st_size, g->map_size);
+      return EXIT_FAILURE;
+    }
+  }
+
+  g->map = mmap(NULL, g->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, g->fd, 0);
+  if (g->map == MAP_FAILED) {
+    perror("mmap");
+    return EXIT_FAILURE;
+  }
+  madvise(g->map, g->map_size, MADV_SEQUENTIAL);
+  g->header = (GridHeader *)g->map;
+  g->data = (uint64_t *)(g->map + HEADER_SIZE);
+
+  if (create) {
+    memcpy(g->header->magic, GRID_MAGIC, 8);
+    g->header->height = height;
+    g->header->width = width;
+    g->header->generation = 0;
+    snprintf(g->header->rule_B, sizeof(g->header->rule_B), "%s", rule_B);
+    snprintf(g->header->rule_S, sizeof(g->header->rule_S), "%s", rule_S);
+  } else {
+    /* ルールを戻す */
+    snprintf(rule_B, sizeof(rule_B), "%.9s", g->header->rule_B); // ファイルの中身は0終端とは限らない
+    snprintf(rule_S, sizeof(rule_S), "%.9s", g->header->rule_S);
+    for (int i=0; i<=8; i++) {
+      can_survive[i] = 0;
+      can_born[i] = 0;
+    }
+    for (int i=0; rule_S[i] != 0; i++) if ('0' <= rule_S[i] && rule_S[i] <= '8') can_survive[rule_S[i] - '0'] = 1;
+    for (int i=0; rule_B[i] != 0; i++) if ('0' <= rule_B[i] && rule_B[i] <= '8') can_born[rule_B[i] - '0'] = 1;
+  }
+  return EXIT_SUCCESS;
+}
+
+void grid_close(Grid *g) {
+  msync(g->map, g->map_size, MS_SYNC);
+  munmap(g->map, g->map_size);
+  close(g->fd);
+}
+
+/* タイル行bandの先頭 */
+uint64_t *band_ptr(const Grid *g, long band) {
+  return g->data + (size_t)band * g->band_words;
+}
+
+/* タイル行bandのr行目、tx番目のタイルの部分 */
+uint64_t *tile_row_ptr(const Grid *g, long band, int r, long tx) {
+  return band_ptr(g, band) + ((size_t)tx * TILE_ROWS + r) * TILE_WORDS;
+}
+
+/* タイル行を、1行がwordsワードの普通の並びに直してbufに取り出す */
+void band_load(const Grid *g, long band, uint64_t *buf) {
+
+  for (int r=0; r<TILE_ROWS; r++) {
+    for (long tx=0; tx<g->tiles_x; tx++) {
+      memcpy(buf + (size_t)r * g->words + tx * TILE_WORDS, tile_row_ptr(g, band, r, tx), sizeof(uint64_t) * TILE_WORDS);
+    }
+  }
+}
+
+void band_store(const Grid *g, long band, const uint64_t *buf) {
+
+  for (int r=0; r<TILE_ROWS; r++) {
+    for (long tx=0; tx<g->tiles_x; tx++) {
+      memcpy(tile_row_ptr(g, band, r, tx), buf + (size_t)r * g->words + tx * TILE_WORDS, sizeof(uint64_t) * TILE_WORDS);
+    }
+  }
+}
+
+/* タイル行bandのr行目を1行取り出す */
+void row_load(const Grid *g, long band, int r, uint64_t *row) {
+
+  for (long tx=0; tx<g->tiles_x; tx++) {
+    memcpy(row + tx * TILE_WORDS, tile_row_ptr(g, band, r, tx), sizeof(uint64_t) * TILE_WORDS);
+  }
+}
+
+int grid_get(const Grid *g, long y, long x) {
+  return (tile_row_ptr(g, y / TILE_ROWS, y % TILE_ROWS, x / (64 * TILE_WORDS))[(x / 64) % TILE_WORDS] >> (x % 64)) & 1;
+}
+
+void grid_set(Grid *g, long y, long x) {
+  tile_row_ptr(g, y / TILE_ROWS, y % TILE_ROWS, x / (64 * TILE_WORDS))[(x / 64) % TILE_WORDS] |= 1ULL << (x % 64);
+}
+
+/* 行の中で盤面の幅を超えた部分のビットを0にする */
+void mask_row(const Grid *g, uint64_t *row) {
+
+  long last = (g->width - 1) / 64;
+  int rest = g->width % 64;
+  if (rest != 0) row[last] &= (1ULL << rest) - 1;
+  for (long k=last+1; k<g->words; k++) row[k] = 0;
+}
+
+/*------------------------------------------------------------------------------------------------
+  更新
+------------------------------------------------------------------------------------------------*/
+
+/*
+  上・今・下の行(NULLなら死んだ行)から次の世代の行を作る関数
+  64セル分の隣接数を4bitの加算器で求める(lifelib.cと同じ)
+*/
+void update_row(const uint64_t *above, const uint64_t *cur, const uint64_t *below, uint64_t *out, long words,
+                const uint64_t born_mask[], const uint64_t survive_mask[]) {
+
+  const uint64_t *rows[3] = { above, cur, below };
+
+  for (long k=0; k<words; k++) {
+    uint64_t a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+
+    for (int r=0; r<3; r++) {
+      if (rows[r] == NULL) continue;
+      uint64_t c = rows[r][k];
+      uint64_t prev = (k > 0) ? rows[r][k - 1] : 0;
+      uint64_t next = (k < words - 1) ? rows[r][k + 1] : 0;
+
+      uint64_t in[3];
+      in[0] = (c << 1) | (prev >> 63); // 左隣(x-1)
+      in[1] = (c >> 1) | (next << 63); // 右隣(x+1)
+      in[2] = (r != 1) ? c : 0;        // 真上と真下
+
+      for (int i=0; i<3; i++) {
+        uint64_t c0 = a0 & in[i];
+        a0 ^= in[i];
+        uint64_t c1 = a1 & c0;
+        a1 ^= c0;
+        uint64_t c2 = a2 & c1;
+        a2 ^= c1;
+        a3 |= c2;
+      }
+    }
+
+    uint64_t alive = cur[k];
+    uint64_t result = 0;
+    for (int n=0; n<=8; n++) {
+      if ((born_mask[n] | survive_mask[n]) == 0) continue;
+      uint64_t eq = ((n & 1) ? a0 : ~a0) & ((n & 2) ? a1 : ~a1) & ((n & 4) ? a2 : ~a2) & ((n & 8) ? a3 : ~a3);
+      result |= eq & ((~alive & born_mask[n]) | (alive & survive_mask[n]));
+    }
+    out[k] = result;
+  }
+}
+
+/* タイル行bandのファイル上の位置とバイト数 */
+off_t band_offset(const Grid *g, long band) {
+  return HEADER_SIZE + (off_t)sizeof(uint64_t) * g->band_words * band;
+}
+
+/*
+  盤面全体をその場で1世代進め、生きたセルの数を返す関数
+  メモリ上に持つのは、今のタイル行(更新前と更新後)と、その上下の1行ずつ
+*/
+long grid_step(Grid *g, uint64_t *band, uint64_t *out, uint64_t *above, uint64_t *below) {
+
+  const long words = g->words;
+  const size_t band_bytes = sizeof(uint64_t) * g->band_words;
+  uint64_t born_mask[9], survive_mask[9];
+  for (int n=0; n<=8; n++) {
+    born_mask[n] = can_born[n] ? ~0ULL : 0;
+    survive_mask[n] = can_survive[n] ? ~0ULL : 0;
+  }
+
+  long alive = 0;
+  int has_above = 0;
+
+  for (long b=0; b<g->tiles_y; b++) {
+    /* 次のタイル行を先読みする */
+    if (b + 1 < g->tiles_y) madvise(band_ptr(g, b + 1), band_bytes, MADV_WILLNEED);
+
+    band_load(g, b, band);
+    int has_below = (b + 1 < g->tiles_y);
+    if (has_below) row_load(g, b + 1, 0, below);
+
+    long rows = g->height - b * TILE_ROWS;
+    if (rows > TILE_ROWS) rows = TILE_ROWS;
+    for (int r=0; r<TILE_ROWS; r++) {
+      uint64_t *o = out + (size_t)r * words;
+      if (r >= rows) { // 盤面の下の余り
+        memset(o, 0, sizeof(uint64_t) * words);
+        continue;
+      }
+      const uint64_t *up = (r > 0) ? band + (size_t)(r - 1) * words : (has_above ? above : NULL);
+      const uint64_t *down = (r < rows - 1) ? band + (size_t)(r + 1) * words : ((r == TILE_ROWS - 1 && has_below) ? below : NULL);
+      update_row(up, band + (size_t)r * words, down, o, words, born_mask, survive_mask);
+      mask_row(g, o);
+      for (long k=0; k<words; k++) alive += __builtin_popcountll(o[k]);
+    }
+
+    band_store(g, b, out);
+    memcpy(above, band + (size_t)(TILE_ROWS - 1) * words, sizeof(uint64_t) * words); // 更新前の最後の行
+    has_above = 1;
+
+    /* 書き終えたタイル行は書き出しを始めてプロセスから外し、2つ前はページキャッシュからも捨てる */
+    sync_file_range(g->fd, band_offset(g, b), band_bytes, SYNC_FILE_RANGE_WRITE);
+    madvise(band_ptr(g, b), band_bytes, MADV_DONTNEED);
+    if (b >= 2) {
+      sync_file_range(g->fd, band_offset(g, b - 2), band_bytes, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+      posix_fadvise(g->fd, band_offset(g, b - 2), band_bytes, POSIX_FADV_DONTNEED);
+    }
+  }
+
+  g->header->generation++;
+  return alive;
+}
+
+/*------------------------------------------------------------------------------------------------
+  初期化
+------------------------------------------------------------------------------------------------*/
+
+uint64_t xorshift64(uint64_t *state) {
+  uint64_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+/* 約1/8のセルを生きたセルにする(タイル行ごとに作って書き込む) */
+void grid_randomize(Grid *g, uint64_t *band) {
+
+  uint64_t state = (uint64_t)time(NULL) * 0x9e3779b97f4a7c15ULL | 1;
+
+  for (long b=0; b<g->tiles_y; b++) {
+    memset(band, 0, sizeof(uint64_t) * g->band_words);
+    for (int r=0; r<TILE_ROWS && b * TILE_ROWS + r < g->height; r++) {
+      uint64_t *row = band + (size_t)r * g->words;
+      for (long k=0; k<g->words; k++) row[k] = xorshift64(&state) & xorshift64(&state) & xorshift64(&state);
+      mask_row(g, row);
+    }
+    band_store(g, b, band);
+    madvise(band_ptr(g, b), sizeof(uint64_t) * g->band_words, MADV_DONTNEED);
+  }
+}
+
+/* 盤面全体をint配列(cell[height][width])に取り出す(-cの確認用) */
+void grid_to_cells(const Grid *g, const int height, const int width, int cell[height][width]) {
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      cell[y][x] = grid_get(g, y, x);
+    }
+  }
+}
+
+double now_sec() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+  long gens = 10;
+  const char *path = "universe.grid";
+  int resume = 0;
+  int check = 0;
+
+  /* オプション */
+  while (argc >= 2 && argv[1][0] == '-') {
+    if (strcmp(argv[1], "-k") == 0) {
+      resume = 1;
+      argc--;
+      argv++;
+    } else if (strcmp(argv[1], "-c") == 0) {
+      check = 1;
+      argc--;
+      argv++;
+    } else if (argc >= 3 && strcmp(argv[1], "-g") == 0) {
+      gens = atol(argv[2]);
+      argc -= 2;
+      argv += 2;
+    } else if (argc >= 3 && strcmp(argv[1], "-o") == 0) {
+      path = argv[2];
+      argc -= 2;
+      argv += 2;
+    } else {
+      break;
+    }
+  }
+
+  if (argc > 4 || (resume && argc > 1)) {
+    fprintf(stderr, "usage: %s [-g generations] [-o grid file] [-k] [-c] [filename for init] [height] [width]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  Grid g;
+  uint64_t *band = NULL;
+
+  if (resume) {
+    if (grid_open(&g, path, 0, 0, 0) != 0) return EXIT_FAILURE;
+    band = malloc(sizeof(uint64_t) * g.band_words);
+  } else {
+    const long height = (argc >= 3) ? atol(argv[2]) : 40;
+    const long width = (argc >= 4) ? atol(argv[3]) : 70;
+    if (height <= 0 || width <= 0) {
+      fprintf(stderr, "invalid size %ldx%ld\n", height, width);
+      return EXIT_FAILURE;
+    }
+
+    const char *filename = (argc >= 2) ? argv[1] : "";
+    const int ph = (height < PATTERN_MAX) ? height : PATTERN_MAX;
+    const int pw = (width < PATTERN_MAX) ? width : PATTERN_MAX;
+    int (*pattern)[pw] = NULL;
+    if (filename[0] != 0) {
+      /* パターンは左上の範囲に読み込む(ファイルのルールもここで反映される) */
+      pattern = calloc((size_t)ph * pw, sizeof(int));
+      if (my_init_cells(ph, pw, pattern, (char *)filename) != 0) return EXIT_FAILURE;
+    }
+
+    if (grid_open(&g, path, 1, height, width) != 0) return EXIT_FAILURE;
+    band = malloc(sizeof(uint64_t) * g.band_words);
+
+    if (pattern == NULL) {
+      grid_randomize(&g, band);
+    } else {
+      for (int y=0; y<ph; y++) {
+        for (int x=0; x<pw; x++) {
+          if (pattern[y][x]) grid_set(&g, y, x);
+        }
+      }
+      free(pattern);
+    }
+  }
+
+  const size_t row_bytes = sizeof(uint64_t) * g.words;
+  uint64_t *out = malloc(sizeof(uint64_t) * g.band_words);
+  uint64_t *above = malloc(row_bytes);
+  uint64_t *below = malloc(row_bytes);
+  if (band == NULL || out == NULL || above == NULL || below == NULL) {
+    fprintf(stderr, "cannot allocate band buffers\n");
+    return EXIT_FAILURE;
+  }
+
+  fprintf(stderr, "grid %s: %ldx%ld cells, %.2f GB on disk, %ld tile rows of %.1f MB, rule B%s/S%s, generation %ld\n",
+          path, g.height, g.width, g.map_size / 1e9, g.tiles_y, sizeof(uint64_t) * g.band_words / 1e6,
+          rule_B, rule_S, (long)g.header->generation);
+
+  /* -c: int配列でmy_update_cells()を並行して動かし、毎世代比べる */
+  int (*expected)[g.width] = NULL;
+  int (*actual)[g.width] = NULL;
+  if (check) {
+    expected = malloc(sizeof(int) * g.height * g.width);
+    actual = malloc(sizeof(int) * g.height * g.width);
+    grid_to_cells(&g, g.height, g.width, expected);
+  }
+
+  double start = now_sec();
+  for (long i=0; i<gens; i++) {
+    double t = now_sec();
+    long alive = grid_step(&g, band, out, above, below);
+    double sec = now_sec() - t;
+    printf("generation %ld: alive %ld, %.3f s (%.2f ns/cell)\n", (long)g.header->generation, alive, sec,
+           sec * 1e9 / ((double)g.height * g.width));
+    fflush(stdout);
+
+    if (check) {
+      my_update_cells(g.height, g.width, expected);
+      grid_to_cells(&g, g.height, g.width, actual);
+      if (memcmp(expected, actual, sizeof(int) * g.height * g.width) != 0) {
+        fprintf(stderr, "generation %ld: mismatch with my_update_cells()\n", (long)g.header->generation);
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  double sec = now_sec() - start;
+  fprintf(stderr, "%ld generations: %.3f s%s\n", gens, sec, check ? ", matches my_update_cells()" : "");
+
+  grid_close(&g);
+  free(band);
+  free(out);
+  free(above);
+  free(below);
+  free(expected);
+  free(actual);
+  return EXIT_SUCCESS;
+}
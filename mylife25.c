@@ -0,0 +1,780 @@
+/*================================================================================================
+
+領域ごとに疎と密を切り替えるセルの表現
+
+rand() % 10で作ったランダムな初期状態は最初は密で、しばらくすると疎な物体がいくつか残るだけになる。
+Pulsar.rleのようなパターンは最初から疎である。int cell[height][width]の1つの表現では、どちらかに無駄が出る。
+ここでは盤面をREGION x REGIONの領域に分け、領域ごとに次のどちらかで持つ。
+  疎: 生きたセルの領域内の位置(y * REGION + x)を昇順に並べた配列(生きたセルが無ければメモリを使わない)
+  密: REGION x REGIONのビット配列(1行がuint64_t 1つ)
+
+1世代進めるときは、領域とその周りの1セル分(8つの隣の領域の端)にある生きたセルを列挙し、
+  疎の領域: 生きたセルごとに周りの8セルの隣接数を足す(足したセルだけを覚えておき、そこだけを調べて戻す)
+  密の領域: 周りの1セルを含めた行をビット列にし、64セルずつ隣接数を4bitの加算器で数える
+のどちらかで次の状態を求める。自分も隣も空の領域は何もしない。
+ただしB0のルールでは生きたセルの無いところからも誕生するので、全ての領域を密の方法で計算する。
+表現は生きたセルの割合で決めるが、行ったり来たりしないように、
+疎から密へはDENSE_ABOVEより多くなったとき、密から疎へはSPARSE_BELOWより少なくなったときだけ切り替える(ヒステリシス)。
+
+-gで世代数を指定すると表示せずに進め、10世代ごとに疎・密・空の領域の数と使っているメモリを表示する。
+-cを付けるとmy_update_cells()の結果と毎世代比べる。
+
+コンパイル
+  gcc -O2 mylife25.c
+
+引数
+  [-g 世代数] [-c] [初期状態のファイル(省略時はランダム)] [height] [width]
+
+実行例
+  ./a.out Pulsar.rle
+  ./a.out -g 2000 "" 1024 1024
+
+================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h> // sleep()関数を使う
+#include <time.h>
+#include <string.h>
+#include <stdint.h>
+
+/* デフォルトのルール */
+int can_survive[9] = {0, 0, 1, 1, 0};
+int can_born[9] = {0, 0, 0, 1, 0};
+char rule_S[10] = "23";
+char rule_B[10] = "3";
+
+/*
+  文字列strの最後がsuffixに一致するか判定する関数
+*/
+int ends_with(const char str[], const char suffix[]) {
+
+  int len_str = strlen(str);
+  int len_suf = strlen(suffix);
+
+  if (len_str < len_suf) return 0;
+
+  char lower_str[255];
+  char lower_suffix[255];
+  strcpy(lower_str, str);
+  strcpy(lower_suffix, suffix);
+
+  /* 大文字は全て小文字にする */
+  for (int i=0; lower_str[i] != 0; i++) {
+    if ('A' <= lower_str[i] && lower_str[i] <= 'Z') {
+      lower_str[i] += 'a' - 'A';
+    }
+  }
+  for (int i=0; lower_suffix[i] != 0; i++) {
+    if ('A' <= lower_suffix[i] && lower_suffix[i] <= 'Z') {
+      lower_suffix[i] += 'a' - 'A';
+    }
+  }
+
+  return (strcmp(lower_str + len_str - len_suf, lower_suffix) == 0);
+}
+
+/*
+  文字列を10進数で表した時の長さを返す関数
+  ただし、0の長さは0とする
+*/
+int number_len(int n) {
+  int len = 0;
+  while(n > 0) {
+    len++;
+    n /= 10;
+  }
+
+  return len;
+}
+
+/*
+  文字が空白、タブ、CR、LFのいずれかなら1を返す関数
+*/
+int isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+int loadRLE(const int height, const int width, int cell[height][width], FILE *fp) {
+
+  char buffer[(int)1e4+1]; // 1行は70文字以下だが念のため
+  int y = 0, x = 0;
+  int offsetY = 0, offsetX = 0;
+  while(fgets(buffer, 1e4, fp) != NULL) {
+
+    /* オフセット指定以外のヘッダー情報は読み飛ばす */
+    if (buffer[0] == '#') {
+      if (buffer[1] == 'P' || buffer[1] == 'R') {
+        sscanf(buffer+2, "%d%d", &offsetX, &offsetY);
+        if (offsetY < 0 || offsetX < 0) {
+          offsetY = 0;
+          offsetX = 0;
+        } else {
+          y = offsetY;
+          x = offsetX;
+        }
+      }
+      continue;
+    }
+
+    /* サイズ情報は読み飛ばし、ルールは反映する */
+    if (buffer[0] == 'x') {
+      int result = sscanf(buffer, "x = %*d, y = %*d, rule = B%9[^/n]/S%9s", rule_B, rule_S);
+
+      for (int i=0; i<=8; i++) {
+        can_survive[i] = 0;
+        can_born[i] = 0;
+      }
+
+      for (int i=0; i<10; i++) {
+        int s = rule_S[i] - '0';
+        int b = rule_B[i] - '0';
+        if (0 <= s && s <= 8) can_survive[s] = 1;
+        if (0 <= b && b <= 8) can_born[b] = 1;
+      }
+
+      continue;
+    }
+
+    int offset = 0; // 行の何文字目を次に読むか
+    while(1) {
+      int len = 0; // ランの長さ
+      char c; // タグ('o', 'b', '$', '!'のいずれか)
+
+      // 途中に空白が入っても対応可能
+      while(isWhitespace(buffer[offset])) offset++;
+
+      // ランの長さを取得(1が省略されている場合は何も読み込まない)
+      int result = sscanf(buffer+offset, "%d", &len);
+      // 読み込んだ分だけoffsetを加算(ただし0のままの場合は読みこんでないのでそのまま)
+      offset += number_len(len);
+
+      // 長さ省略時は1
+      if (len == 0) len = 1;
+
+      // ランのタグを取得
+      result = sscanf(buffer+offset, "%c", &c);
+      offset++;
+
+      if (result <= 0 || c == '!') { // 終了
+        break;
+      } else if (c == '$') { // 改行
+        y += len;
+        x = offsetX;
+      } else if (c == 'b') { // dead
+        x += len;
+      } else if (c == 'o') { // alive
+        for (int i=0; i<len; i++) {
+          if (0 <= y && y < height && 0 <= x && x < width) cell[y][x] = 1; // 盤面の外は無視する
+          x++;
+        }
+      } else {
+        fprintf(stderr,"Invalid syntax\n");
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ ファイルによるセルの初期化: 生きているセルの座標が記述されたファイルをもとに2次元配列の状態を初期化する
+ fp = NULL のときは、関数内で適宜定められた初期状態に初期化する。関数内初期値はdefault.lif と同じもの
+ */
+int my_init_cells(const int height, const int width, int cell[height][width], char filename[]) {
+
+  if (filename[0] == 0) {
+    /* ランダムに配置する */
+    srand(time(NULL));
+
+    for (int y=0; y<height; y++) {
+      for (int x=0; x<width; x++) {
+        cell[y][x] = (rand() % 10 == 0 ? 1 : 0);
+      }
+    }
+  } else {
+
+    FILE *fp = fopen(filename,"r");
+    if (fp == NULL) {
+      fprintf(stderr,"cannot open file %s\n", filename);
+      return EXIT_FAILURE;
+    }
+
+    if (ends_with(filename, ".lif")) {
+
+      fscanf(fp, "%*[^\n]\n"); // バージョン情報は読み飛ばす
+
+      int x, y;
+      while (fscanf(fp, "%d%d", &x, &y) > 0) {
+        if (0 <= y && y < height && 0 <= x && x < width) cell[y][x] = 1; // 盤面の外は無視する
+      }
+
+    } else if (ends_with(filename, ".rle")) {
+
+      int result = loadRLE(height, width, cell, fp);
+      if (result != 0) return EXIT_FAILURE;
+
+    } else {
+
+      fprintf(stderr,"Supported: .lif .rle\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ グリッドの描画: 世代情報とグリッドの配列等を受け取り、ファイルポインタに該当する出力にグリッドを描画する
+ */
+void my_print_cells(FILE *fp, int gen, const int height, const int width, int cell[height][width]) {
+
+  /* 0,1それぞれの状態のセルをカウント */
+  int count_cells[2] = {0, 0};
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      count_cells[cell[y][x]]++;
+    }
+  }
+
+  // 世代情報と存在比を表示
+  fprintf(fp, "rule: B%s/S%s, generateion = %d, alive:dead = %7d:%7d\r\n", rule_B, rule_S, gen, count_cells[1], count_cells[0]);
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  /* グリッド */
+  for (int y=0; y<height; y++) {
+    fprintf(fp, "|");
+    for (int x=0; x<width; x++) {
+      fprintf(fp, "\e[31m%c\e[0m", (cell[y][x] ? '#' : ' ')); // 赤色で表示
+    }
+    fprintf(fp, "|\r\n");
+  }
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  fflush(fp);
+}
+
+int in_cells(int y, int x, const int height, const int width) {
+
+  if (y < 0 || height <= y) return 0;
+  if (x < 0 || width <= x) return 0;
+
+  return 1;
+}
+
+/*
+ 着目するセルの周辺の生きたセルをカウントする関数
+ */
+int my_count_adjacent_cells(int y, int x, const int height, const int width, int cell[height][width]) {
+
+  /*
+    dy, dx: 相対位置
+    012
+    7.3
+    654
+  */
+  int dy[] = {-1, -1, -1, 0, 1, 1, 1, 0};
+  int dx[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+
+  int count = 0;
+  
+  for (int i=0; i<8; i++) {
+
+    int ny = y + dy[i];
+    int nx = x + dx[i];
+
+    if (in_cells(ny, nx, height, width) && cell[ny][nx]) {
+      count++;
+    }
+
+  }
+
+  return count;
+}
+
+/*
+  着目するセルの次の世代での状態を返す関数
+*/
+int next_state(int y, int x, const int height, const int width, int cell[height][width], int neighbors) {
+
+  if (cell[y][x]) { 
+    return can_survive[neighbors];
+  } else {
+    return can_born[neighbors];
+  }
+
+}
+
+/*
+ ライフゲームのルールに基づいて2次元配列の状態を更新する
+ */
+void my_update_cells(const int height, const int width, int cell[height][width]) {
+
+  int next_cell[height][width];
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      next_cell[y][x] = 0;
+    }
+  }
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      int neighbors = my_count_adjacent_cells(y, x, height, width, cell);
+      next_cell[y][x] = next_state(y, x, height, width, cell, neighbors);
+    }
+  }
+
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      cell[y][x] = next_cell[y][x];
+    }
+  }
+
+}
+
+/*------------------------------------------------------------------------------------------------
+  領域
+------------------------------------------------------------------------------------------------*/
+
+#define REGION 64                          // 密の領域の1行がuint64_t 1つになる
+#define REGION_CELLS (REGION * REGION)
+#define WINDOW (REGION + 2)                // 周りの1セルを含めた幅
+#define DENSE_ABOVE (REGION_CELLS / 16)    // 疎 -> 密に切り替える生きたセルの数(メモリの損益分岐点)
+#define SPARSE_BELOW (REGION_CELLS / 32)   // 密 -> 疎に切り替える生きたセルの数
+
+typedef struct {
+  int dense;        // 1ならgrid、0ならcellsを使う
+  int count;        // 生きたセルの数
+  int cap;          // cellsの大きさ
+  uint16_t *cells;  // 疎: 生きたセルの位置の昇順
+  uint64_t *grid;   // 密: REGION行(x番目のセルはx番目のビット)
+} Region;
+
+typedef struct {
+  int height, width;
+  int rows, cols;   // 領域の数
+  Region *regions;
+  Region *next;     // 次の世代
+  long switches;    // 表現を切り替えた回数
+} Board;
+
+/* 作業用の配列(全ての領域で使い回す) */
+typedef struct {
+  uint16_t window[WINDOW * WINDOW]; // 周りを含めた範囲の生きたセル(位置はwy * WINDOW + wx)
+  int nwindow;
+  uint8_t count[REGION_CELLS];      // 疎: 隣接数(touchedの位置以外は常に0)
+  uint8_t alive[REGION_CELLS];      // 疎: 今生きているか(同上)
+  uint16_t touched[REGION_CELLS];
+  uint16_t list[REGION_CELLS];      // 次の状態(疎)
+  uint64_t grid[REGION];            // 次の状態(密)
+  uint64_t born_mask[9], survive_mask[9];
+} Scratch;
+
+Region *board_region(const Board *b, Region *regions, int ry, int rx) {
+  if (ry < 0 || b->rows <= ry || rx < 0 || b->cols <= rx) return NULL;
+  return &regions[ry * b->cols + rx];
+}
+
+/*
+  領域の次の状態を設定する関数
+  生きたセルの数とヒステリシスで表現を決め、要らなくなったメモリは返す
+  grid(密の結果)かlist(疎の結果)のどちらかを渡す
+*/
+void region_store(Board *b, Region *r, int was_dense, const uint64_t *grid, const uint16_t *list, int n) {
+
+  int dense = was_dense ? (n >= SPARSE_BELOW) : (n > DENSE_ABOVE);
+  if (dense != was_dense) b->switches++;
+  r->dense = dense;
+  r->count = n;
+
+  if (dense) {
+    if (r->grid == NULL) r->grid = malloc(sizeof(uint64_t) * REGION);
+    if (grid != NULL) {
+      memcpy(r->grid, grid, sizeof(uint64_t) * REGION);
+    } else {
+      memset(r->grid, 0, sizeof(uint64_t) * REGION);
+      for (int i=0; i<n; i++) r->grid[list[i] / REGION] |= 1ULL << (list[i] % REGION);
+    }
+    free(r->cells);
+    r->cells = NULL;
+    r->cap = 0;
+    return;
+  }
+
+  free(r->grid);
+  r->grid = NULL;
+
+  /* 配列は足りなければ広げ、大きすぎれば縮める */
+  if (n > r->cap || r->cap > 4 * n + 16) {
+    free(r->cells);
+    r->cap = (n == 0) ? 0 : n + n / 2 + 8;
+    r->cells = (r->cap == 0) ? NULL : malloc(sizeof(uint16_t) * r->cap);
+  }
+  if (grid != NULL) {
+    int k = 0;
+    for (int y=0; y<REGION; y++) {
+      for (uint64_t bits=grid[y]; bits!=0; bits&=bits-1) r->cells[k++] = y * REGION + __builtin_ctzll(bits);
+    }
+  } else if (n > 0) {
+    memcpy(r->cells, list, sizeof(uint16_t) * n);
+  }
+}
+
+/*
+  領域(ry, rx)の周りの1セル分(include_selfが1なら領域自身も)の生きたセルを、
+  周りを含めた範囲での位置としてs->windowに並べる関数
+  密の隣の領域は、範囲に入る端の行・列のビットだけを調べる
+*/
+void gather_window(const Board *b, int ry, int rx, Scratch *s, int include_self) {
+
+  s->nwindow = 0;
+
+  for (int dy=-1; dy<=1; dy++) {
+    for (int dx=-1; dx<=1; dx++) {
+      if (dy == 0 && dx == 0 && !include_self) continue;
+      const Region *q = board_region(b, b->regions, ry + dy, rx + dx);
+      if (q == NULL || q->count == 0) continue;
+
+      /* 領域qの中で範囲に入る部分 */
+      int y0 = (dy < 0) ? REGION - 1 : 0, y1 = (dy > 0) ? 0 : REGION - 1;
+      int x0 = (dx < 0) ? REGION - 1 : 0, x1 = (dx > 0) ? 0 : REGION - 1;
+      int oy = dy * REGION + 1, ox = dx * REGION + 1; // qの位置 -> 範囲での位置
+
+      if (q->dense) {
+        uint64_t mask = (x1 - x0 == REGION - 1) ? ~0ULL : (1ULL << x0);
+        for (int y=y0; y<=y1; y++) {
+          for (uint64_t bits=q->grid[y]&mask; bits!=0; bits&=bits-1) {
+            s->window[s->nwindow++] = (y + oy) * WINDOW + (__builtin_ctzll(bits) + ox);
+          }
+        }
+      } else {
+        for (int i=0; i<q->count; i++) {
+          int y = q->cells[i] / REGION, x = q->cells[i] % REGION;
+          if (y0 <= y && y <= y1 && x0 <= x && x <= x1) s->window[s->nwindow++] = (y + oy) * WINDOW + (x + ox);
+        }
+      }
+    }
+  }
+}
+
+int compare_u16(const void *a, const void *b) {
+  return *(const uint16_t *)a - *(const uint16_t *)b;
+}
+
+/*
+  疎の領域の更新: 生きたセルの周りにだけ隣接数を足し、足したセルだけを調べる
+*/
+int update_sparse(const Board *b, int ry, int rx, Scratch *s) {
+
+  int ntouched = 0;
+
+  for (int i=0; i<s->nwindow; i++) {
+    int wy = s->window[i] / WINDOW, wx = s->window[i] % WINDOW;
+    if (1 <= wy && wy <= REGION && 1 <= wx && wx <= REGION) {
+      int p = (wy - 1) * REGION + (wx - 1);
+      if (s->count[p] == 0 && !s->alive[p]) s->touched[ntouched++] = p;
+      s->alive[p] = 1;
+    }
+    for (int ny=wy-1; ny<=wy+1; ny++) {
+      if (ny < 1 || REGION < ny) continue;
+      for (int nx=wx-1; nx<=wx+1; nx++) {
+        if (nx < 1 || REGION < nx || (ny == wy && nx == wx)) continue;
+        int p = (ny - 1) * REGION + (nx - 1);
+        if (s->count[p] == 0 && !s->alive[p]) s->touched[ntouched++] = p;
+        s->count[p]++;
+      }
+    }
+  }
+
+  int n = 0;
+  for (int i=0; i<ntouched; i++) {
+    int p = s->touched[i];
+    int y = ry * REGION + p / REGION, x = rx * REGION + p % REGION;
+    int next = s->alive[p] ? can_survive[s->count[p]] : can_born[s->count[p]];
+    if (next && y < b->height && x < b->width) s->list[n++] = p;
+    s->count[p] = 0;
+    s->alive[p] = 0;
+  }
+
+  qsort(s->list, n, sizeof(uint16_t), compare_u16);
+  return n;
+}
+
+/*
+  密の領域の更新: 周りの1セルを含めた行をビット列で作り、64セルずつ隣接数を4bitの加算器で求める
+  (lifelib.cと同じ方法)
+  疎の領域に使うときは、領域自身のセルもgather_window()でs->windowに入れておく
+*/
+int update_dense(const Board *b, const Region *r, int ry, int rx, Scratch *s) {
+
+  uint64_t mid[WINDOW] = {0};   // 範囲の各行の、領域の中の64セル
+  uint64_t left[WINDOW] = {0};  // 左隣の領域の端のセル(0か1)
+  uint64_t right[WINDOW] = {0}; // 右隣の領域の端のセル(0か1)
+
+  if (r->dense) {
+    for (int y=0; y<REGION; y++) mid[y + 1] = r->grid[y];
+  }
+  for (int i=0; i<s->nwindow; i++) {
+    int wy = s->window[i] / WINDOW, wx = s->window[i] % WINDOW;
+    if (wx == 0) left[wy] = 1;
+    else if (wx == WINDOW - 1) right[wy] = 1;
+    else mid[wy] |= 1ULL << (wx - 1);
+  }
+
+  /* 盤面の外に出る部分 */
+  int valid_x = b->width - rx * REGION;
+  uint64_t col_mask = (valid_x >= REGION) ? ~0ULL : (1ULL << valid_x) - 1;
+  int valid_y = b->height - ry * REGION;
+
+  int n = 0;
+  for (int y=0; y<REGION; y++) {
+    if (y >= valid_y) {
+      s->grid[y] = 0;
+      continue;
+    }
+
+    uint64_t a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+    for (int k=0; k<3; k++) {
+      uint64_t c = mid[y + k];
+      uint64_t in[3];
+      in[0] = (c << 1) | left[y + k];          // 左隣(x-1)
+      in[1] = (c >> 1) | (right[y + k] << 63); // 右隣(x+1)
+      in[2] = (k != 1) ? c : 0;                // 真上と真下
+
+      for (int i=0; i<3; i++) {
+        uint64_t c0 = a0 & in[i];
+        a0 ^= in[i];
+        uint64_t c1 = a1 & c0;
+        a1 ^= c0;
+        uint64_t c2 = a2 & c1;
+        a2 ^= c1;
+        a3 |= c2;
+      }
+    }
+
+    uint64_t alive = mid[y + 1];
+    uint64_t result = 0;
+    for (int m=0; m<=8; m++) {
+      if ((s->born_mask[m] | s->survive_mask[m]) == 0) continue;
+      uint64_t eq = ((m & 1) ? a0 : ~a0) & ((m & 2) ? a1 : ~a1) & ((m & 4) ? a2 : ~a2) & ((m & 8) ? a3 : ~a3);
+      result |= eq & ((~alive & s->born_mask[m]) | (alive & s->survive_mask[m]));
+    }
+    s->grid[y] = result & col_mask;
+    n += __builtin_popcountll(s->grid[y]);
+  }
+  return n;
+}
+
+/*
+  盤面全体を1世代進める関数
+*/
+void board_update(Board *b, Scratch *s) {
+
+  for (int m=0; m<=8; m++) {
+    s->born_mask[m] = can_born[m] ? ~0ULL : 0;
+    s->survive_mask[m] = can_survive[m] ? ~0ULL : 0;
+  }
+
+  for (int ry=0; ry<b->rows; ry++) {
+    for (int rx=0; rx<b->cols; rx++) {
+      const Region *r = board_region(b, b->regions, ry, rx);
+      Region *next = board_region(b, b->next, ry, rx);
+
+      if (r->dense || can_born[0]) {
+        /* B0では空の領域でも誕生するので、疎の領域も全てのセルを調べる */
+        gather_window(b, ry, rx, s, !r->dense);
+        int n = update_dense(b, r, ry, rx, s);
+        region_store(b, next, r->dense, s->grid, NULL, n);
+      } else {
+        gather_window(b, ry, rx, s, 1);
+        int n = (s->nwindow == 0) ? 0 : update_sparse(b, ry, rx, s); // 自分も周りも空なら何もしない
+        region_store(b, next, 0, NULL, s->list, n);
+      }
+    }
+  }
+
+  Region *tmp = b->regions;
+  b->regions = b->next;
+  b->next = tmp;
+}
+
+Board *board_create(const int height, const int width, int cell[height][width]) {
+
+  Board *b = calloc(1, sizeof(Board));
+  b->height = height;
+  b->width = width;
+  b->rows = (height + REGION - 1) / REGION;
+  b->cols = (width + REGION - 1) / REGION;
+  b->regions = calloc((size_t)b->rows * b->cols, sizeof(Region));
+  b->next = calloc((size_t)b->rows * b->cols, sizeof(Region));
+
+  uint16_t list[REGION_CELLS];
+  for (int ry=0; ry<b->rows; ry++) {
+    for (int rx=0; rx<b->cols; rx++) {
+      int n = 0;
+      for (int y=0; y<REGION; y++) {
+        for (int x=0; x<REGION; x++) {
+          int cy = ry * REGION + y, cx = rx * REGION + x;
+          if (cy < height && cx < width && cell[cy][cx]) list[n++] = y * REGION + x;
+        }
+      }
+      region_store(b, board_region(b, b->regions, ry, rx), 0, NULL, list, n);
+    }
+  }
+  b->switches = 0;
+  return b;
+}
+
+void board_free(Board *b) {
+
+  for (int i=0; i<b->rows * b->cols; i++) {
+    free(b->regions[i].cells);
+    free(b->regions[i].grid);
+    free(b->next[i].cells);
+    free(b->next[i].grid);
+  }
+  free(b->regions);
+  free(b->next);
+  free(b);
+}
+
+void board_to_cells(const Board *b, const int height, const int width, int cell[height][width]) {
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      cell[y][x] = 0;
+    }
+  }
+  for (int ry=0; ry<b->rows; ry++) {
+    for (int rx=0; rx<b->cols; rx++) {
+      const Region *r = board_region(b, b->regions, ry, rx);
+      if (r->dense) {
+        for (int y=0; y<REGION; y++) {
+          for (uint64_t bits=r->grid[y]; bits!=0; bits&=bits-1) cell[ry * REGION + y][rx * REGION + __builtin_ctzll(bits)] = 1;
+        }
+      } else {
+        for (int i=0; i<r->count; i++) cell[ry * REGION + r->cells[i] / REGION][rx * REGION + r->cells[i] % REGION] = 1;
+      }
+    }
+  }
+}
+
+/* 疎・密・空の領域の数と、セルの表現に使っているメモリ(バイト)を表示する */
+void print_board_stats(FILE *fp, const Board *b, int gen) {
+
+  long alive = 0, memory = 0;
+  int sparse = 0, dense = 0, empty = 0;
+  for (int i=0; i<b->rows * b->cols; i++) {
+    const Region *r = &b->regions[i];
+    alive += r->count;
+    if (r->dense) {
+      dense++;
+      memory += sizeof(uint64_t) * REGION;
+    } else {
+      if (r->count == 0) empty++;
+      else sparse++;
+      memory += sizeof(uint16_t) * r->cap;
+    }
+  }
+  fprintf(fp, "generation %5d: alive %8ld, regions dense %5d / sparse %5d / empty %5d, %8ld bytes (int array: %ld), switches %ld\r\n",
+          gen, alive, dense, sparse, empty, memory, (long)sizeof(int) * b->height * b->width, b->switches);
+  fflush(fp);
+}
+
+int main(int argc, char **argv)
+{
+  FILE *fp = stdout;
+  int gens = -1; // -1なら表示しながら無限に進める
+  int check = 0;
+
+  /* オプション */
+  while (argc >= 2 && argv[1][0] == '-') {
+    if (strcmp(argv[1], "-c") == 0) {
+      check = 1;
+      argc--;
+      argv++;
+    } else if (argc >= 3 && strcmp(argv[1], "-g") == 0) {
+      gens = atoi(argv[2]);
+      argc -= 2;
+      argv += 2;
+    } else {
+      break;
+    }
+  }
+
+  if (argc > 4) {
+    fprintf(stderr, "usage: %s [-g generations] [-c] [filename for init] [height] [width]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const int height = (argc >= 3) ? atoi(argv[2]) : 40;
+  const int width = (argc >= 4) ? atoi(argv[3]) : 70;
+  if (height <= 0 || width <= 0) {
+    fprintf(stderr, "invalid size %dx%d\n", height, width);
+    return EXIT_FAILURE;
+  }
+
+  /* ファイルを引数にとるか、ない場合はデフォルトの初期値を使う(読み込みと表示・確認にだけint配列を使う) */
+  int (*cell)[width] = calloc((size_t)height * width, sizeof(int));
+  int result = my_init_cells(height, width, cell, (argc >= 2) ? argv[1] : "");
+  if (result != 0) return EXIT_FAILURE;
+
+  Board *board = board_create(height, width, cell);
+  if (gens >= 0 && !check) {
+    /* 表示も確認もしなければ、メモリは生きたセルの数に応じた分だけにする */
+    free(cell);
+    cell = NULL;
+  }
+  Scratch *scratch = calloc(1, sizeof(Scratch));
+  int (*actual)[width] = check ? malloc(sizeof(int) * height * width) : NULL;
+
+  clock_t start = clock();
+  if (gens < 0) {
+    my_print_cells(fp, 0, height, width, cell); // 表示する
+    print_board_stats(fp, board, 0);
+  } else {
+    print_board_stats(fp, board, 0);
+  }
+
+  /* 世代を進める*/
+  for (int gen = 1 ; gens < 0 || gen <= gens; gen++) {
+    board_update(board, scratch); // セルを更新
+
+    if (check) {
+      my_update_cells(height, width, cell);
+      board_to_cells(board, height, width, actual);
+      if (memcmp(cell, actual, sizeof(int) * height * width) != 0) {
+        fprintf(stderr, "generation %d: mismatch with my_update_cells()\n", gen);
+        return EXIT_FAILURE;
+      }
+    }
+
+    if (gens < 0) {
+      usleep(200*1000); //0.2秒休止する
+      fprintf(fp,"\e[%dA",height+4);//height+4 の分、カーソルを上に戻す(壁2、表示部1、統計1)
+      board_to_cells(board, height, width, cell);
+      my_print_cells(fp, gen, height, width, cell);  // 表示する
+      print_board_stats(fp, board, gen);
+    } else if (gen % 10 == 0 || gen == gens) {
+      print_board_stats(fp, board, gen);
+    }
+  }
+
+  fprintf(stderr, "%d generations: %.3f s cpu%s\n", gens, (double)(clock() - start) / CLOCKS_PER_SEC,
+          check ? ", matches my_update_cells()" : "");
+
+  board_free(board);
+  free(scratch);
+  free(cell);
+  free(actual);
+  return EXIT_SUCCESS;
+}
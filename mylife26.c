@@ -0,0 +1,910 @@
+/*================================================================================================
+
+コピーオンライトで枝分かれするスナップショット
+
+ある世代で実行を枝分かれさせ、いくつかのセルを反転したりルールを変えたりして結果を比べたいことがよくある。
+これまではファイルから毎回やり直すしかなかったので、メモリ上で安く枝分かれできるようにした。
+
+盤面はTILE x TILEセル(1行がuint64_t 1つ)のタイルに分け、枝(Branch)はタイルへのポインタの配列として持つ。
+タイルには参照カウントがあり、枝分かれはポインタの配列をコピーして参照カウントを増やすだけで済む。
+  - セルを書き換えるときは、タイルが他の枝と共有されていればコピーしてから書き換える(コピーオンライト)
+  - 1世代進めるとき、次の状態が今と同じタイルは新しく作らずに同じタイルを指し続ける
+    (静かな部分は進めた後も共有されたまま)
+  - 進めて新しくできたタイルは中身のハッシュ表で引き、同じ中身のタイルが既にあればそれを共有する
+    (振動子のように毎世代変わる部分も、枝どうしで同じ結果になっていれば1つで済む)
+  - 全て死んだタイルはNULLで表し、メモリを使わない
+なので大きな盤面を何十本に枝分かれさせても、違いのあるタイルの分しかメモリは増えない。
+
+コマンドは標準入力から1行ずつ読む。最初の枝の名前はmain。
+  branch 新しい枝 元の枝        : 枝分かれする
+  step 枝 世代数                : 枝を進める
+  flip 枝 y x                   : セルを反転する
+  rule 枝 B36/S23               : 枝のルールを変える
+  diff 枝1 枝2                  : 違うセルの数と範囲、共有しているタイルの数を表示する
+  show 枝 [y x height width]    : 枝の盤面(または一部)を表示する
+  drop 枝                       : 枝を捨てる
+  list                          : 全ての枝と、タイルのメモリ(共有しない場合との比較)を表示する
+  quit
+
+コンパイル
+  gcc -O2 mylife26.c
+
+引数
+  [初期状態のファイル(省略時はランダム)] [height] [width]
+
+実行例
+  ./a.out gosperglidergun.lif 1024 1024 < commands.txt
+  printf 'step main 100\nbranch b main\nflip b 5 5\nstep main 50\nstep b 50\ndiff main b\n' | ./a.out Bomber.rle
+
+================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h> // sleep()関数を使う
+#include <time.h>
+#include <string.h>
+#include <stdint.h>
+
+/* デフォルトのルール */
+int can_survive[9] = {0, 0, 1, 1, 0};
+int can_born[9] = {0, 0, 0, 1, 0};
+char rule_S[10] = "23";
+char rule_B[10] = "3";
+
+/*
+  文字列strの最後がsuffixに一致するか判定する関数
+*/
+int ends_with(const char str[], const char suffix[]) {
+
+  int len_str = strlen(str);
+  int len_suf = strlen(suffix);
+
+  if (len_str < len_suf) return 0;
+
+  char lower_str[255];
+  char lower_suffix[255];
+  strcpy(lower_str, str);
+  strcpy(lower_suffix, suffix);
+
+  /* 大文字は全て小文字にする */
+  for (int i=0; lower_str[i] != 0; i++) {
+    if ('A' <= lower_str[i] && lower_str[i] <= 'Z') {
+      lower_str[i] += 'a' - 'A';
+    }
+  }
+  for (int i=0; lower_suffix[i] != 0; i++) {
+    if ('A' <= lower_suffix[i] && lower_suffix[i] <= 'Z') {
+      lower_suffix[i] += 'a' - 'A';
+    }
+  }
+
+  return (strcmp(lower_str + len_str - len_suf, lower_suffix) == 0);
+}
+
+/*
+  文字列を10進数で表した時の長さを返す関数
+  ただし、0の長さは0とする
+*/
+int number_len(int n) {
+  int len = 0;
+  while(n > 0) {
+    len++;
+    n /= 10;
+  }
+
+  return len;
+}
+
+/*
+  文字が空白、タブ、CR、LFのいずれかなら1を返す関数
+*/
+int isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+int loadRLE(const int height, const int width, int cell[height][width], FILE *fp) {
+
+  char buffer[(int)1e4+1]; // 1行は70文字以下だが念のため
+  int y = 0, x = 0;
+  int offsetY = 0, offsetX = 0;
+  while(fgets(buffer, 1e4, fp) != NULL) {
+
+    /* オフセット指定以外のヘッダー情報は読み飛ばす */
+    if (buffer[0] == '#') {
+      if (buffer[1] == 'P' || buffer[1] == 'R') {
+        sscanf(buffer+2, "%d%d", &offsetX, &offsetY);
+        if (offsetY < 0 || offsetX < 0) {
+          offsetY = 0;
+          offsetX = 0;
+        } else {
+          y = offsetY;
+          x = offsetX;
+        }
+      }
+      continue;
+    }
+
+    /* サイズ情報は読み飛ばし、ルールは反映する */
+    if (buffer[0] == 'x') {
+      int result = sscanf(buffer, "x = %*d, y = %*d, rule = B%9[^/n]/S%9s", rule_B, rule_S);
+
+      for (int i=0; i<=8; i++) {
+        can_survive[i] = 0;
+        can_born[i] = 0;
+      }
+
+      for (int i=0; i<10; i++) {
+        int s = rule_S[i] - '0';
+        int b = rule_B[i] - '0';
+        if (0 <= s && s <= 8) can_survive[s] = 1;
+        if (0 <= b && b <= 8) can_born[b] = 1;
+      }
+
+      continue;
+    }
+
+    int offset = 0; // 行の何文字目を次に読むか
+    while(1) {
+      int len = 0; // ランの長さ
+      char c; // タグ('o', 'b', '$', '!'のいずれか)
+
+      // 途中に空白が入っても対応可能
+      while(isWhitespace(buffer[offset])) offset++;
+
+      // ランの長さを取得(1が省略されている場合は何も読み込まない)
+      int result = sscanf(buffer+offset, "%d", &len);
+      // 読み込んだ分だけoffsetを加算(ただし0のままの場合は読みこんでないのでそのまま)
+      offset += number_len(len);
+
+      // 長さ省略時は1
+      if (len == 0) len = 1;
+
+      // ランのタグを取得
+      result = sscanf(buffer+offset, "%c", &c);
+      offset++;
+
+      if (result <= 0 || c == '!') { // 終了
+        break;
+      } else if (c == '$') { // 改行
+        y += len;
+        x = offsetX;
+      } else if (c == 'b') { // dead
+        x += len;
+      } else if (c == 'o') { // alive
+        for (int i=0; i<len; i++) {
+          if (0 <= y && y < height && 0 <= x && x < width) cell[y][x] = 1; // 盤面の外は無視する
+          x++;
+        }
+      } else {
+        fprintf(stderr,"Invalid syntax\n");
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ ファイルによるセルの初期化: 生きているセルの座標が記述されたファイルをもとに2次元配列の状態を初期化する
+ fp = NULL のときは、関数内で適宜定められた初期状態に初期化する。関数内初期値はdefault.lif と同じもの
+ */
+int my_init_cells(const int height, const int width, int cell[height][width], char filename[]) {
+
+  if (filename[0] == 0) {
+    /* ランダムに配置する */
+    srand(time(NULL));
+
+    for (int y=0; y<height; y++) {
+      for (int x=0; x<width; x++) {
+        cell[y][x] = (rand() % 10 == 0 ? 1 : 0);
+      }
+    }
+  } else {
+
+    FILE *fp = fopen(filename,"r");
+    if (fp == NULL) {
+      fprintf(stderr,"cannot open file %s\n", filename);
+      return EXIT_FAILURE;
+    }
+
+    if (ends_with(filename, ".lif")) {
+
+      fscanf(fp, "%*[^\n]\n"); // バージョン情報は読み飛ばす
+
+      int x, y;
+      while (fscanf(fp, "%d%d", &x, &y) > 0) {
+        if (0 <= y && y < height && 0 <= x && x < width) cell[y][x] = 1; // 盤面の外は無視する
+      }
+
+    } else if (ends_with(filename, ".rle")) {
+
+      int result = loadRLE(height, width, cell, fp);
+      if (result != 0) return EXIT_FAILURE;
+
+    } else {
+
+      fprintf(stderr,"Supported: .lif .rle\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ グリッドの描画: 世代情報とグリッドの配列等を受け取り、ファイルポインタに該当する出力にグリッドを描画する
+ */
+void my_print_cells(FILE *fp, int gen, const int height, const int width, int cell[height][width]) {
+
+  /* 0,1それぞれの状態のセルをカウント */
+  int count_cells[2] = {0, 0};
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      count_cells[cell[y][x]]++;
+    }
+  }
+
+  // 世代情報と存在比を表示
+  fprintf(fp, "rule: B%s/S%s, generateion = %d, alive:dead = %7d:%7d\r\n", rule_B, rule_S, gen, count_cells[1], count_cells[0]);
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  /* グリッド */
+  for (int y=0; y<height; y++) {
+    fprintf(fp, "|");
+    for (int x=0; x<width; x++) {
+      fprintf(fp, "\e[31m%c\e[0m", (cell[y][x] ? '#' : ' ')); // 赤色で表示
+    }
+    fprintf(fp, "|\r\n");
+  }
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  fflush(fp);
+}
+
+int in_cells(int y, int x, const int height, const int width) {
+
+  if (y < 0 || height <= y) return 0;
+  if (x < 0 || width <= x) return 0;
+
+  return 1;
+}
+
+/*
+ 着目するセルの周辺の生きたセルをカウントする関数
+ */
+int my_count_adjacent_cells(int y, int x, const int height, const int width, int cell[height][width]) {
+
+  /*
+    dy, dx: 相対位置
+    012
+    7.3
+    654
+  */
+  int dy[] = {-1, -1, -1, 0, 1, 1, 1, 0};
+  int dx[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+
+  int count = 0;
+  
+  for (int i=0; i<8; i++) {
+
+    int ny = y + dy[i];
+    int nx = x + dx[i];
+
+    if (in_cells(ny, nx, height, width) && cell[ny][nx]) {
+      count++;
+    }
+
+  }
+
+  return count;
+}
+
+/*
+  着目するセルの次の世代での状態を返す関数
+*/
+int next_state(int y, int x, const int height, const int width, int cell[height][width], int neighbors) {
+
+  if (cell[y][x]) { 
+    return can_survive[neighbors];
+  } else {
+    return can_born[neighbors];
+  }
+
+}
+
+/*
+ ライフゲームのルールに基づいて2次元配列の状態を更新する
+ */
+void my_update_cells(const int height, const int width, int cell[height][width]) {
+
+  int next_cell[height][width];
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      next_cell[y][x] = 0;
+    }
+  }
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      int neighbors = my_count_adjacent_cells(y, x, height, width, cell);
+      next_cell[y][x] = next_state(y, x, height, width, cell, neighbors);
+    }
+  }
+
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      cell[y][x] = next_cell[y][x];
+    }
+  }
+
+}
+
+/*------------------------------------------------------------------------------------------------
+  参照カウント付きのタイル
+------------------------------------------------------------------------------------------------*/
+
+#define TILE 64
+#define MAX_BRANCHES 64
+#define NAME_LEN 32
+
+typedef struct Tile {
+  int refs;
+  int interned;           // 1なら中身で引ける表(intern_table)に入っている
+  uint64_t hash;          // 中身のハッシュ(表に入っているときだけ使う)
+  struct Tile *next_same; // 表の同じバケツの次のタイル
+  uint64_t rows[TILE];    // x番目のセルはx番目のビット
+} Tile;
+
+long live_tiles = 0; // 確保しているタイルの数(全ての枝の合計)
+
+/*
+  世代を進めて作ったタイルは中身のハッシュで表に入れておき、同じ中身のタイルがあればそれを共有する。
+  枝ごとに同じ部分を進めても(振動子のように毎世代変わる部分でも)、結果のタイルは1つで済む。
+*/
+Tile **intern_table = NULL;
+size_t intern_buckets = 0; // 2のべき乗
+size_t intern_count = 0;
+
+Tile *tile_new() {
+  Tile *t = calloc(1, sizeof(Tile));
+  t->refs = 1;
+  live_tiles++;
+  return t;
+}
+
+Tile *tile_ref(Tile *t) {
+  if (t != NULL) t->refs++;
+  return t;
+}
+
+uint64_t rows_hash(const uint64_t rows[]) {
+
+  uint64_t h = 14695981039346656037ULL; // FNV-1aを64bitずつ
+  for (int y=0; y<TILE; y++) {
+    h ^= rows[y];
+    h *= 1099511628211ULL;
+    h ^= h >> 29;
+  }
+  return h;
+}
+
+/* 表から外す(これ以降は中身を書き換えてよい) */
+void tile_unintern(Tile *t) {
+
+  if (!t->interned) return;
+  Tile **p = &intern_table[t->hash & (intern_buckets - 1)];
+  while (*p != t) p = &(*p)->next_same;
+  *p = t->next_same;
+  t->interned = 0;
+  intern_count--;
+}
+
+void tile_unref(Tile *t) {
+  if (t != NULL && --t->refs == 0) {
+    tile_unintern(t);
+    free(t);
+    live_tiles--;
+  }
+}
+
+/* 中身がrowsのタイルを返す。表に同じ中身のタイルがあればそれを共有し、無ければ作って表に入れる */
+Tile *tile_intern(const uint64_t rows[]) {
+
+  uint64_t h = rows_hash(rows);
+  for (Tile *t = (intern_buckets == 0) ? NULL : intern_table[h & (intern_buckets - 1)]; t != NULL; t = t->next_same) {
+    if (t->hash == h && memcmp(t->rows, rows, sizeof(t->rows)) == 0) return tile_ref(t);
+  }
+
+  /* 表が埋まってきたら2倍に広げる */
+  if (intern_count >= intern_buckets) {
+    size_t buckets = (intern_buckets == 0) ? 1024 : intern_buckets * 2;
+    Tile **table = calloc(buckets, sizeof(Tile *));
+    for (size_t i=0; i<intern_buckets; i++) {
+      for (Tile *t = intern_table[i], *next; t != NULL; t = next) {
+        next = t->next_same;
+        t->next_same = table[t->hash & (buckets - 1)];
+        table[t->hash & (buckets - 1)] = t;
+      }
+    }
+    free(intern_table);
+    intern_table = table;
+    intern_buckets = buckets;
+  }
+
+  Tile *t = tile_new();
+  memcpy(t->rows, rows, sizeof(t->rows));
+  t->hash = h;
+  t->interned = 1;
+  t->next_same = intern_table[h & (intern_buckets - 1)];
+  intern_table[h & (intern_buckets - 1)] = t;
+  intern_count++;
+  return t;
+}
+
+/*------------------------------------------------------------------------------------------------
+  枝
+------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+  char name[NAME_LEN];
+  long generation;
+  char rule[24];
+  int can_born[9], can_survive[9];
+  Tile **tiles; // tiles_y * tiles_x個(NULLは全て死んだタイル)
+} Branch;
+
+typedef struct {
+  int height, width;
+  int tiles_y, tiles_x;
+  Branch *branches[MAX_BRANCHES];
+} Universe;
+
+Branch *find_branch(Universe *u, const char name[]) {
+
+  for (int i=0; i<MAX_BRANCHES; i++) {
+    if (u->branches[i] != NULL && strcmp(u->branches[i]->name, name) == 0) return u->branches[i];
+  }
+  return NULL;
+}
+
+/* "B36/S23"のようなルールを枝に設定する(失敗したら-1) */
+int branch_set_rule(Branch *b, const char rule[]) {
+
+  int born[9] = {0}, survive[9] = {0};
+  int *target = NULL;
+
+  for (int i=0; rule[i] != 0; i++) {
+    char c = rule[i];
+    if (c == 'B' || c == 'b') {
+      target = born;
+    } else if (c == 'S' || c == 's') {
+      target = survive;
+    } else if ('0' <= c && c <= '8' && target != NULL) {
+      target[c - '0'] = 1;
+    } else if (c != '/') {
+      return -1;
+    }
+  }
+
+  memcpy(b->can_born, born, sizeof(born));
+  memcpy(b->can_survive, survive, sizeof(survive));
+  snprintf(b->rule, sizeof(b->rule), "%s", rule);
+  return 0;
+}
+
+/*
+  枝を作る関数(fromがNULLなら全て死んだ盤面、そうでなければfromのスナップショット)
+*/
+Branch *branch_create(Universe *u, const char name[], const Branch *from) {
+
+  if (find_branch(u, name) != NULL) {
+    fprintf(stderr, "branch %s already exists\n", name);
+    return NULL;
+  }
+  int slot = 0;
+  while (slot < MAX_BRANCHES && u->branches[slot] != NULL) slot++;
+  if (slot == MAX_BRANCHES) {
+    fprintf(stderr, "too many branches (max %d)\n", MAX_BRANCHES);
+    return NULL;
+  }
+
+  const int n = u->tiles_y * u->tiles_x;
+  Branch *b = calloc(1, sizeof(Branch));
+  snprintf(b->name, sizeof(b->name), "%s", name);
+  b->tiles = calloc(n, sizeof(Tile *));
+
+  if (from != NULL) {
+    /* タイルは参照カウントを増やして共有する */
+    for (int i=0; i<n; i++) b->tiles[i] = tile_ref(from->tiles[i]);
+    b->generation = from->generation;
+    memcpy(b->can_born, from->can_born, sizeof(b->can_born));
+    memcpy(b->can_survive, from->can_survive, sizeof(b->can_survive));
+    snprintf(b->rule, sizeof(b->rule), "%s", from->rule);
+  }
+
+  u->branches[slot] = b;
+  return b;
+}
+
+void branch_drop(Universe *u, Branch *b) {
+
+  for (int i=0; i<u->tiles_y * u->tiles_x; i++) tile_unref(b->tiles[i]);
+  for (int i=0; i<MAX_BRANCHES; i++) {
+    if (u->branches[i] == b) u->branches[i] = NULL;
+  }
+  free(b->tiles);
+  free(b);
+}
+
+int branch_get(const Universe *u, const Branch *b, int y, int x) {
+
+  const Tile *t = b->tiles[(y / TILE) * u->tiles_x + x / TILE];
+  return (t != NULL) && ((t->rows[y % TILE] >> (x % TILE)) & 1);
+}
+
+/*
+  セルを書き換える関数
+  タイルが他の枝と共有されていれば、この枝の分だけコピーしてから書き換える
+*/
+void branch_set(const Universe *u, Branch *b, int y, int x, int alive) {
+
+  Tile **slot = &b->tiles[(y / TILE) * u->tiles_x + x / TILE];
+  if (*slot == NULL) {
+    if (!alive) return;
+    *slot = tile_new();
+  } else if ((*slot)->refs > 1) {
+    Tile *copy = tile_new();
+    memcpy(copy->rows, (*slot)->rows, sizeof(copy->rows));
+    tile_unref(*slot);
+    *slot = copy;
+  } else {
+    tile_unintern(*slot); // この枝だけが使っているタイルはそのまま書き換える(中身が変わるので表からは外す)
+  }
+
+  uint64_t bit = 1ULL << (x % TILE);
+  if (alive) {
+    (*slot)->rows[y % TILE] |= bit;
+  } else {
+    (*slot)->rows[y % TILE] &= ~bit;
+  }
+}
+
+/* タイル(ty, tx)のy行目(範囲外やNULLなら0) */
+uint64_t tile_row(const Universe *u, Tile *const *tiles, int ty, int tx, int y) {
+
+  if (y < 0) {
+    ty--;
+    y += TILE;
+  } else if (y >= TILE) {
+    ty++;
+    y -= TILE;
+  }
+  if (ty < 0 || u->tiles_y <= ty || tx < 0 || u->tiles_x <= tx) return 0;
+  const Tile *t = tiles[ty * u->tiles_x + tx];
+  return (t == NULL) ? 0 : t->rows[y];
+}
+
+/*
+  1つのタイルの次の状態をrowsに求める関数(64セルずつ隣接数を4bitの加算器で求める)
+*/
+void step_tile(const Universe *u, Tile *const *tiles, int ty, int tx, const uint64_t born_mask[], const uint64_t survive_mask[], uint64_t rows[]) {
+
+  const int valid_x = u->width - tx * TILE;
+  const uint64_t col_mask = (valid_x >= TILE) ? ~0ULL : (1ULL << valid_x) - 1;
+  const int valid_y = u->height - ty * TILE;
+
+  for (int y=0; y<TILE; y++) {
+    if (y >= valid_y) {
+      rows[y] = 0;
+      continue;
+    }
+
+    uint64_t a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+    for (int k=0; k<3; k++) {
+      uint64_t c = tile_row(u, tiles, ty, tx, y + k - 1);
+      uint64_t l = tile_row(u, tiles, ty, tx - 1, y + k - 1);
+      uint64_t r = tile_row(u, tiles, ty, tx + 1, y + k - 1);
+      uint64_t in[3];
+      in[0] = (c << 1) | (l >> 63); // 左隣(x-1)
+      in[1] = (c >> 1) | (r << 63); // 右隣(x+1)
+      in[2] = (k != 1) ? c : 0;     // 真上と真下
+
+      for (int i=0; i<3; i++) {
+        uint64_t c0 = a0 & in[i];
+        a0 ^= in[i];
+        uint64_t c1 = a1 & c0;
+        a1 ^= c0;
+        uint64_t c2 = a2 & c1;
+        a2 ^= c1;
+        a3 |= c2;
+      }
+    }
+
+    uint64_t alive = tile_row(u, tiles, ty, tx, y);
+    uint64_t result = 0;
+    for (int n=0; n<=8; n++) {
+      if ((born_mask[n] | survive_mask[n]) == 0) continue;
+      uint64_t eq = ((n & 1) ? a0 : ~a0) & ((n & 2) ? a1 : ~a1) & ((n & 4) ? a2 : ~a2) & ((n & 8) ? a3 : ~a3);
+      result |= eq & ((~alive & born_mask[n]) | (alive & survive_mask[n]));
+    }
+    rows[y] = result & col_mask;
+  }
+}
+
+/*
+  枝を1世代進める関数
+  次の状態が今と同じタイルは同じタイルを指したままにするので、静かな部分は他の枝と共有され続ける
+*/
+void branch_step(const Universe *u, Branch *b) {
+
+  const int n = u->tiles_y * u->tiles_x;
+  Tile **next = calloc(n, sizeof(Tile *));
+  uint64_t born_mask[9], survive_mask[9];
+  for (int i=0; i<=8; i++) {
+    born_mask[i] = b->can_born[i] ? ~0ULL : 0;
+    survive_mask[i] = b->can_survive[i] ? ~0ULL : 0;
+  }
+
+  uint64_t rows[TILE];
+  for (int ty=0; ty<u->tiles_y; ty++) {
+    for (int tx=0; tx<u->tiles_x; tx++) {
+      /* 自分も周りも全て死んでいれば(B0でない限り)次も全て死んでいる */
+      int empty = !b->can_born[0];
+      for (int dy=-1; dy<=1 && empty; dy++) {
+        for (int dx=-1; dx<=1 && empty; dx++) {
+          int ny = ty + dy, nx = tx + dx;
+          if (0 <= ny && ny < u->tiles_y && 0 <= nx && nx < u->tiles_x && b->tiles[ny * u->tiles_x + nx] != NULL) empty = 0;
+        }
+      }
+      if (empty) continue;
+
+      step_tile(u, b->tiles, ty, tx, born_mask, survive_mask, rows);
+
+      Tile *cur = b->tiles[ty * u->tiles_x + tx];
+      uint64_t any = 0;
+      for (int y=0; y<TILE; y++) any |= rows[y];
+      if (any == 0) continue; // NULLのまま
+      if (cur != NULL && memcmp(cur->rows, rows, sizeof(rows)) == 0) {
+        next[ty * u->tiles_x + tx] = tile_ref(cur); // 変わらないタイルはそのまま共有する
+      } else {
+        next[ty * u->tiles_x + tx] = tile_intern(rows); // 他の枝で同じ結果になったタイルがあれば共有する
+      }
+    }
+  }
+
+  for (int i=0; i<n; i++) tile_unref(b->tiles[i]);
+  free(b->tiles);
+  b->tiles = next;
+  b->generation++;
+}
+
+long branch_alive(const Universe *u, const Branch *b) {
+
+  long alive = 0;
+  for (int i=0; i<u->tiles_y * u->tiles_x; i++) {
+    if (b->tiles[i] == NULL) continue;
+    for (int y=0; y<TILE; y++) alive += __builtin_popcountll(b->tiles[i]->rows[y]);
+  }
+  return alive;
+}
+
+/*------------------------------------------------------------------------------------------------
+  コマンド
+------------------------------------------------------------------------------------------------*/
+
+/* 2つの枝の違うセルを数える。同じタイルを指していれば中身を比べずに済む */
+void command_diff(const Universe *u, const Branch *a, const Branch *b) {
+
+  long cells = 0;
+  int shared = 0, differ = 0;
+  int min_y = u->height, min_x = u->width, max_y = -1, max_x = -1;
+
+  for (int ty=0; ty<u->tiles_y; ty++) {
+    for (int tx=0; tx<u->tiles_x; tx++) {
+      const Tile *p = a->tiles[ty * u->tiles_x + tx], *q = b->tiles[ty * u->tiles_x + tx];
+      if (p == q) {
+        if (p != NULL) shared++;
+        continue;
+      }
+      int any = 0;
+      for (int y=0; y<TILE; y++) {
+        uint64_t d = (p ? p->rows[y] : 0) ^ (q ? q->rows[y] : 0);
+        if (d == 0) continue;
+        any = 1;
+        cells += __builtin_popcountll(d);
+        int gy = ty * TILE + y;
+        int gx0 = tx * TILE + __builtin_ctzll(d), gx1 = tx * TILE + 63 - __builtin_clzll(d);
+        if (gy < min_y) min_y = gy;
+        if (gy > max_y) max_y = gy;
+        if (gx0 < min_x) min_x = gx0;
+        if (gx1 > max_x) max_x = gx1;
+      }
+      differ += any;
+    }
+  }
+
+  printf("diff %s (gen %ld) %s (gen %ld): %ld cells differ", a->name, a->generation, b->name, b->generation, cells);
+  if (cells > 0) printf(" in y = %d..%d, x = %d..%d", min_y, max_y, min_x, max_x);
+  printf(", %d tiles differ, %d tiles shared\n", differ, shared);
+}
+
+void command_list(const Universe *u) {
+
+  long referenced = 0;
+  for (int i=0; i<MAX_BRANCHES; i++) {
+    const Branch *b = u->branches[i];
+    if (b == NULL) continue;
+    int tiles = 0;
+    for (int k=0; k<u->tiles_y * u->tiles_x; k++) tiles += (b->tiles[k] != NULL);
+    referenced += tiles;
+    printf("%-16s gen %8ld  rule %-10s alive %9ld  tiles %6d\n", b->name, b->generation, b->rule, branch_alive(u, b), tiles);
+  }
+  printf("tiles allocated: %ld (%.1f KB), without sharing: %ld (%.1f KB)\n",
+         live_tiles, live_tiles * sizeof(Tile) / 1024.0, referenced, referenced * sizeof(Tile) / 1024.0);
+}
+
+/* 枝の盤面の一部をmy_print_cells()と同じ形で表示する */
+void command_show(const Universe *u, const Branch *b, int y0, int x0, int h, int w) {
+
+  printf("%s: rule: %s, generation = %ld\r\n", b->name, b->rule, b->generation);
+  printf("+");
+  for (int x=0; x<w; x++) printf("-");
+  printf("+\r\n");
+  for (int y=y0; y<y0+h; y++) {
+    printf("|");
+    for (int x=x0; x<x0+w; x++) {
+      printf("\e[31m%c\e[0m", branch_get(u, b, y, x) ? '#' : ' '); // 赤色で表示
+    }
+    printf("|\r\n");
+  }
+  printf("+");
+  for (int x=0; x<w; x++) printf("-");
+  printf("+\r\n");
+}
+
+/*
+  1行のコマンドを実行する関数。quitなら0を返す
+*/
+int run_command(Universe *u, char line[]) {
+
+  char cmd[16], a[NAME_LEN], c[NAME_LEN];
+  long n1, n2, n3, n4;
+  int args = sscanf(line, "%15s", cmd);
+  if (args <= 0 || cmd[0] == '#') return 1; // 空行とコメント
+
+  if (strcmp(cmd, "quit") == 0) return 0;
+
+  if (strcmp(cmd, "list") == 0) {
+    command_list(u);
+    return 1;
+  }
+
+  if (sscanf(line, "%*s %31s", a) != 1) {
+    fprintf(stderr, "missing branch name: %s", line);
+    return 1;
+  }
+  Branch *b = find_branch(u, a);
+
+  if (strcmp(cmd, "branch") == 0) {
+    if (sscanf(line, "%*s %*s %31s", c) != 1) {
+      fprintf(stderr, "usage: branch new_branch from_branch\n");
+      return 1;
+    }
+    const Branch *from = find_branch(u, c);
+    if (from == NULL) {
+      fprintf(stderr, "no branch %s\n", c);
+      return 1;
+    }
+    if (branch_create(u, a, from) != NULL) printf("branch %s from %s at gen %ld\n", a, c, from->generation);
+    return 1;
+  }
+
+  if (b == NULL) {
+    fprintf(stderr, "no branch %s\n", a);
+    return 1;
+  }
+
+  if (strcmp(cmd, "step") == 0 && sscanf(line, "%*s %*s %ld", &n1) == 1) {
+    clock_t start = clock();
+    for (long i=0; i<n1; i++) branch_step(u, b);
+    printf("%s: gen %ld, alive %ld (%.3f s)\n", b->name, b->generation, branch_alive(u, b), (double)(clock() - start) / CLOCKS_PER_SEC);
+  } else if (strcmp(cmd, "flip") == 0 && sscanf(line, "%*s %*s %ld %ld", &n1, &n2) == 2) {
+    if (!in_cells(n1, n2, u->height, u->width)) {
+      fprintf(stderr, "(%ld, %ld) is outside the board\n", n1, n2);
+      return 1;
+    }
+    branch_set(u, b, n1, n2, !branch_get(u, b, n1, n2));
+  } else if (strcmp(cmd, "rule") == 0 && sscanf(line, "%*s %*s %31s", c) == 1) {
+    if (branch_set_rule(b, c) != 0) fprintf(stderr, "invalid rule %s\n", c);
+  } else if (strcmp(cmd, "diff") == 0 && sscanf(line, "%*s %*s %31s", c) == 1) {
+    const Branch *other = find_branch(u, c);
+    if (other == NULL) {
+      fprintf(stderr, "no branch %s\n", c);
+      return 1;
+    }
+    command_diff(u, b, other);
+  } else if (strcmp(cmd, "show") == 0) {
+    if (sscanf(line, "%*s %*s %ld %ld %ld %ld", &n1, &n2, &n3, &n4) != 4) {
+      n1 = 0;
+      n2 = 0;
+      n3 = u->height;
+      n4 = u->width;
+    }
+    if (n1 < 0 || n2 < 0 || n3 < 0 || n4 < 0 || n1 + n3 > u->height || n2 + n4 > u->width) {
+      fprintf(stderr, "the range is outside the board\n");
+      return 1;
+    }
+    command_show(u, b, n1, n2, n3, n4);
+  } else if (strcmp(cmd, "drop") == 0) {
+    branch_drop(u, b);
+  } else {
+    fprintf(stderr, "unknown command: %s", line);
+  }
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc > 4) {
+    fprintf(stderr, "usage: %s [filename for init] [height] [width]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const int height = (argc >= 3) ? atoi(argv[2]) : 40;
+  const int width = (argc >= 4) ? atoi(argv[3]) : 70;
+  if (height <= 0 || width <= 0) {
+    fprintf(stderr, "invalid size %dx%d\n", height, width);
+    return EXIT_FAILURE;
+  }
+
+  /* ファイルを引数にとるか、ない場合はデフォルトの初期値を使う(読み込みにだけint配列を使う) */
+  int (*cell)[width] = calloc((size_t)height * width, sizeof(int));
+  int result = my_init_cells(height, width, cell, (argc >= 2) ? argv[1] : "");
+  if (result != 0) return EXIT_FAILURE;
+
+  Universe u;
+  memset(&u, 0, sizeof(u));
+  u.height = height;
+  u.width = width;
+  u.tiles_y = (height + TILE - 1) / TILE;
+  u.tiles_x = (width + TILE - 1) / TILE;
+
+  Branch *main_branch = branch_create(&u, "main", NULL);
+  char rule[24];
+  snprintf(rule, sizeof(rule), "B%s/S%s", rule_B, rule_S); // ファイルのルール
+  branch_set_rule(main_branch, rule);
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      if (cell[y][x]) branch_set(&u, main_branch, y, x, 1);
+    }
+  }
+  free(cell);
+
+  /* コマンドを1行ずつ実行する */
+  int interactive = isatty(STDIN_FILENO);
+  char line[256];
+  while (1) {
+    if (interactive) {
+      printf("> ");
+      fflush(stdout);
+    }
+    if (fgets(line, sizeof(line), stdin) == NULL) break;
+    if (!run_command(&u, line)) break;
+    fflush(stdout);
+  }
+
+  for (int i=0; i<MAX_BRANCHES; i++) {
+    if (u.branches[i] != NULL) branch_drop(&u, u.branches[i]);
+  }
+  free(intern_table);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,743 @@
+/*================================================================================================
+
+更新カーネルのベンチマーク
+
+mylife3.cのmy_update_cells()(参照実装)と、高速化した更新カーネルを同じ条件で走らせて、
+1セルあたりの時間(ns/cell)とメモリ帯域(GB/s)を表示する。
+
+カーネル
+  ref    : mylife3.cのmy_update_cells()をそのまま使ったもの(int配列, in_cells()で境界判定)
+  int    : 同じint配列のまま、境界判定を内側から追い出し、ルールを表引きにしたもの
+  packed : 1行をuint64_tの配列に詰め(1bit/セル)、64セルを加算器の論理演算でまとめて数えるもの
+
+GB/sは「読むセル + 書くセル」のバイト数から計算している(int: 8byte/セル, packed: 2bit/セル)。
+キャッシュに乗る小さい盤面では実際のメモリ帯域ではなく、単に処理量の目安になる。
+
+計測の前に必ず正しさを確認する。同梱パターン(*.lif, *.rle)をmylife3.cと同じ40x70の盤面に読み込み、
+VERIFY_GENS世代進めた後の盤面のハッシュが参照実装と一致しなければ計測せずに終了する。
+ランダムな初期状態でも各ルールについて同じ確認をする。
+
+参照実装はmy_update_cells()がnext_cellをスタックに確保するので、REF_MAX_SIZEより大きい盤面では計測しない。
+intカーネルも盤面全体をintで持つため、INT_MAX_SIZEより大きい盤面では計測しない。
+
+引数
+  arg[1] 計測する盤面の一辺の最大値(省略時は16384)
+
+実行例
+  ./a.out
+  ./a.out 1024
+
+================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <string.h>
+
+/* デフォルトのルール */
+int can_survive[9] = {0, 0, 1, 1, 0};
+int can_born[9] = {0, 0, 0, 1, 0};
+char rule_S[10] = "23";
+char rule_B[10] = "3";
+
+/*
+  文字列strの最後がsuffixに一致するか判定する関数
+*/
+int ends_with(const char str[], const char suffix[]) {
+
+  int len_str = strlen(str);
+  int len_suf = strlen(suffix);
+
+  if (len_str < len_suf) return 0;
+
+  char lower_str[255];
+  char lower_suffix[255];
+  strcpy(lower_str, str);
+  strcpy(lower_suffix, suffix);
+
+  /* 大文字は全て小文字にする */
+  for (int i=0; lower_str[i] != 0; i++) {
+    if ('A' <= lower_str[i] && lower_str[i] <= 'Z') {
+      lower_str[i] += 'a' - 'A';
+    }
+  }
+  for (int i=0; lower_suffix[i] != 0; i++) {
+    if ('A' <= lower_suffix[i] && lower_suffix[i] <= 'Z') {
+      lower_suffix[i] += 'a' - 'A';
+    }
+  }
+
+  return (strcmp(lower_str + len_str - len_suf, lower_suffix) == 0);
+}
+
+/*
+  文字列を10進数で表した時の長さを返す関数
+  ただし、0の長さは0とする
+*/
+int number_len(int n) {
+  int len = 0;
+  while(n > 0) {
+    len++;
+    n /= 10;
+  }
+
+  return len;
+}
+
+/*
+  文字が空白、タブ、CR、LFのいずれかなら1を返す関数
+*/
+int isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+int loadRLE(const int height, const int width, int cell[height][width], FILE *fp) {
+
+  char buffer[(int)1e4+1]; // 1行は70文字以下だが念のため
+  int y = 0, x = 0;
+  int offsetY = 0, offsetX = 0;
+  while(fgets(buffer, 1e4, fp) != NULL) {
+
+    /* オフセット指定以外のヘッダー情報は読み飛ばす */
+    if (buffer[0] == '#') {
+      if (buffer[1] == 'P' || buffer[1] == 'R') {
+        sscanf(buffer+2, "%d%d", &offsetX, &offsetY);
+        if (offsetY < 0 || offsetX < 0) {
+          offsetY = 0;
+          offsetX = 0;
+        } else {
+          y = offsetY;
+          x = offsetX;
+        }
+      }
+      continue;
+    }
+
+    /* サイズ情報は読み飛ばし、ルールは反映する */
+    if (buffer[0] == 'x') {
+      int result = sscanf(buffer, "x = %*d, y = %*d, rule = B%9[^/n]/S%9s", rule_B, rule_S);
+
+      for (int i=0; i<=8; i++) {
+        can_survive[i] = 0;
+        can_born[i] = 0;
+      }
+
+      for (int i=0; i<10; i++) {
+        int s = rule_S[i] - '0';
+        int b = rule_B[i] - '0';
+        if (0 <= s && s <= 8) can_survive[s] = 1;
+        if (0 <= b && b <= 8) can_born[b] = 1;
+      }
+
+      continue;
+    }
+
+    int offset = 0; // 行の何文字目を次に読むか
+    while(1) {
+      int len = 0; // ランの長さ
+      char c; // タグ('o', 'b', '$', '!'のいずれか)
+
+      // 途中に空白が入っても対応可能
+      while(isWhitespace(buffer[offset])) offset++;
+
+      // ランの長さを取得(1が省略されている場合は何も読み込まない)
+      int result = sscanf(buffer+offset, "%d", &len);
+      // 読み込んだ分だけoffsetを加算(ただし0のままの場合は読みこんでないのでそのまま)
+      offset += number_len(len);
+
+      // 長さ省略時は1
+      if (len == 0) len = 1;
+
+      // ランのタグを取得
+      result = sscanf(buffer+offset, "%c", &c);
+      offset++;
+
+      if (result <= 0 || c == '!') { // 終了
+        break;
+      } else if (c == '$') { // 改行
+        y += len;
+        x = offsetX;
+      } else if (c == 'b') { // dead
+        x += len;
+      } else if (c == 'o') { // alive
+        for (int i=0; i<len; i++) {
+          cell[y][x] = 1;
+          x++;
+        }
+      } else {
+        fprintf(stderr,"Invalid syntax\n");
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ ファイルによるセルの初期化: 生きているセルの座標が記述されたファイルをもとに2次元配列の状態を初期化する
+ fp = NULL のときは、関数内で適宜定められた初期状態に初期化する。関数内初期値はdefault.lif と同じもの
+ */
+int my_init_cells(const int height, const int width, int cell[height][width], char filename[]) {
+
+  if (filename[0] == 0) {
+    /* ランダムに配置する */
+    srand(time(NULL));
+
+    for (int y=0; y<height; y++) {
+      for (int x=0; x<width; x++) {
+        cell[y][x] = (rand() % 10 == 0 ? 1 : 0);
+      }
+    }
+  } else {
+
+    FILE *fp = fopen(filename,"r");
+    if (fp == NULL) {
+      fprintf(stderr,"cannot open file %s\n", filename);
+      return EXIT_FAILURE;
+    }
+
+    if (ends_with(filename, ".lif")) {
+
+      fscanf(fp, "%*[^\n]\n"); // バージョン情報は読み飛ばす
+
+      int x, y;
+      while (fscanf(fp, "%d%d", &x, &y) > 0) {
+        cell[y][x] = 1;
+      }
+
+    } else if (ends_with(filename, ".rle")) {
+
+      int result = loadRLE(height, width, cell, fp);
+      if (result != 0) return EXIT_FAILURE;
+
+    } else {
+
+      fprintf(stderr,"Supported: .lif .rle\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int in_cells(int y, int x, const int height, const int width) {
+
+  if (y < 0 || height <= y) return 0;
+  if (x < 0 || width <= x) return 0;
+
+  return 1;
+}
+
+/*
+ 着目するセルの周辺の生きたセルをカウントする関数
+ */
+int my_count_adjacent_cells(int y, int x, const int height, const int width, int cell[height][width]) {
+
+  /*
+    dy, dx: 相対位置
+    012
+    7.3
+    654
+  */
+  int dy[] = {-1, -1, -1, 0, 1, 1, 1, 0};
+  int dx[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+
+  int count = 0;
+  
+  for (int i=0; i<8; i++) {
+
+    int ny = y + dy[i];
+    int nx = x + dx[i];
+
+    if (in_cells(ny, nx, height, width) && cell[ny][nx]) {
+      count++;
+    }
+
+  }
+
+  return count;
+}
+
+/*
+  着目するセルの次の世代での状態を返す関数
+*/
+int next_state(int y, int x, const int height, const int width, int cell[height][width], int neighbors) {
+
+  if (cell[y][x]) { 
+    return can_survive[neighbors];
+  } else {
+    return can_born[neighbors];
+  }
+
+}
+
+/*
+ ライフゲームのルールに基づいて2次元配列の状態を更新する
+ */
+void my_update_cells(const int height, const int width, int cell[height][width]) {
+
+  int next_cell[height][width];
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      next_cell[y][x] = 0;
+    }
+  }
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      int neighbors = my_count_adjacent_cells(y, x, height, width, cell);
+      next_cell[y][x] = next_state(y, x, height, width, cell, neighbors);
+    }
+  }
+
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      cell[y][x] = next_cell[y][x];
+    }
+  }
+
+}
+
+#define VERIFY_GENS 200 // 正しさの確認で進める世代数
+#define REF_MAX_SIZE 1024 // 参照実装を計測する盤面の最大サイズ
+#define INT_MAX_SIZE 4096 // intカーネルを計測する盤面の最大サイズ
+#define TARGET_CELLS 2e8 // 1回の計測で更新するセル数の目安
+
+/* 同梱パターン */
+const char *patterns[] = {
+  "default.lif", "gosperglidergun.lif", "Bomber.rle", "Garden_of_Eden_5.rle",
+  "Pentadecathlon.rle", "Pulsar.rle", "Turtle.rle",
+};
+
+/* 計測するルール(B/Sの順) */
+const char *rules[][2] = {
+  {"3", "23"},   // Conway
+  {"36", "23"},  // HighLife
+  {"3678", "34678"}, // Day & Night
+};
+
+/* 計測する初期密度(%) */
+const int densities[] = {10, 35, 50};
+
+/*
+  ルール文字列("36", "23"など)からcan_born, can_surviveを設定する関数
+*/
+void set_rule(const char b[], const char s[]) {
+
+  strcpy(rule_B, b);
+  strcpy(rule_S, s);
+
+  for (int i=0; i<=8; i++) {
+    can_survive[i] = 0;
+    can_born[i] = 0;
+  }
+  for (int i=0; b[i] != 0; i++) {
+    if ('0' <= b[i] && b[i] <= '8') can_born[b[i] - '0'] = 1;
+  }
+  for (int i=0; s[i] != 0; i++) {
+    if ('0' <= s[i] && s[i] <= '8') can_survive[s[i] - '0'] = 1;
+  }
+}
+
+/*
+  再現性のある乱数(xorshift64)
+  rand()は処理系によって結果が変わるので、カーネル同士の比較にはこちらを使う
+*/
+uint64_t rng_state = 88172645463325252ULL;
+
+uint64_t next_rand() {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return rng_state;
+}
+
+/*
+  密度density(%)のランダムな初期状態を作る関数
+*/
+void random_cells(const int height, const int width, int cell[height][width], int density, uint64_t seed) {
+
+  rng_state = seed;
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      cell[y][x] = (int)(next_rand() % 100) < density;
+    }
+  }
+}
+
+/*
+  盤面のハッシュ(FNV-1a)を返す関数
+  各セルの状態(0か1)を1バイトとして順に混ぜるので、表現が違っても同じ盤面なら同じ値になる
+*/
+uint64_t hash_cells(const int height, const int width, int cell[height][width]) {
+
+  uint64_t h = 14695981039346656037ULL;
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      h ^= (uint64_t)(cell[y][x] != 0);
+      h *= 1099511628211ULL;
+    }
+  }
+  return h;
+}
+
+/*------------------------------------------------------------------------------------------------
+  intカーネル
+  rule_table[状態][隣接数]を引くだけにして、盤面の内側ではin_cells()を呼ばない。
+  隣接数は上下の行を足した列和を横に3つ足して求める(中央のセルは後で引く)。
+------------------------------------------------------------------------------------------------*/
+
+int rule_table[2][9];
+
+void make_rule_table() {
+  for (int i=0; i<=8; i++) {
+    rule_table[0][i] = can_born[i];
+    rule_table[1][i] = can_survive[i];
+  }
+}
+
+void int_update_cells(const int height, const int width, int cell[height][width], int next_cell[height][width]) {
+
+  int colsum[width + 2]; // 両端に0を置いた列和
+
+  colsum[0] = 0;
+  colsum[width + 1] = 0;
+
+  for (int y=0; y<height; y++) {
+    const int *up = (y > 0) ? cell[y-1] : NULL;
+    const int *down = (y < height - 1) ? cell[y+1] : NULL;
+
+    for (int x=0; x<width; x++) {
+      int s = cell[y][x];
+      if (up != NULL) s += up[x];
+      if (down != NULL) s += down[x];
+      colsum[x + 1] = s;
+    }
+
+    for (int x=0; x<width; x++) {
+      int alive = cell[y][x];
+      int neighbors = colsum[x] + colsum[x + 1] + colsum[x + 2] - alive;
+      next_cell[y][x] = rule_table[alive][neighbors];
+    }
+  }
+}
+
+/*------------------------------------------------------------------------------------------------
+  packedカーネル
+  1行をwords個のuint64_tに詰める。x番目のセルは(x/64)番目のワードの(x%64)ビット目。
+  幅が64の倍数でないときは、最後のワードの余りのビットを常に0にしておく。
+------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+  int height;
+  int width;
+  int words; // 1行あたりのワード数
+  uint64_t *bits;
+  uint64_t *next_bits;
+} Packed;
+
+Packed packed_new(int height, int width) {
+
+  Packed p;
+  p.height = height;
+  p.width = width;
+  p.words = (width + 63) / 64;
+  p.bits = calloc((size_t)height * p.words, sizeof(uint64_t));
+  p.next_bits = calloc((size_t)height * p.words, sizeof(uint64_t));
+  return p;
+}
+
+void packed_free(Packed *p) {
+  free(p->bits);
+  free(p->next_bits);
+}
+
+void packed_from_cells(Packed *p, int cell[p->height][p->width]) {
+
+  for (int y=0; y<p->height; y++) {
+    uint64_t *row = p->bits + (size_t)y * p->words;
+    for (int k=0; k<p->words; k++) row[k] = 0;
+    for (int x=0; x<p->width; x++) {
+      if (cell[y][x]) row[x / 64] |= 1ULL << (x % 64);
+    }
+  }
+}
+
+void packed_to_cells(const Packed *p, int cell[p->height][p->width]) {
+
+  for (int y=0; y<p->height; y++) {
+    const uint64_t *row = p->bits + (size_t)y * p->words;
+    for (int x=0; x<p->width; x++) {
+      cell[y][x] = (row[x / 64] >> (x % 64)) & 1;
+    }
+  }
+}
+
+/*
+  8つのビット列を足して、隣接数の2進表現(s3 s2 s1 s0)を64セル分まとめて求める関数
+*/
+void add_neighbors(const uint64_t in[8], uint64_t *s0, uint64_t *s1, uint64_t *s2, uint64_t *s3) {
+
+  uint64_t a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+  for (int i=0; i<8; i++) {
+    uint64_t c0 = a0 & in[i];
+    a0 ^= in[i];
+    uint64_t c1 = a1 & c0;
+    a1 ^= c0;
+    uint64_t c2 = a2 & c1;
+    a2 ^= c1;
+    a3 |= c2; // 隣接数は最大8なので、これより上の桁は無い
+  }
+  *s0 = a0;
+  *s1 = a1;
+  *s2 = a2;
+  *s3 = a3;
+}
+
+/*
+  隣接数が64セル分のビット列で与えられたとき、ルールに従って次の状態を求める関数
+*/
+uint64_t apply_rule(uint64_t alive, uint64_t s0, uint64_t s1, uint64_t s2, uint64_t s3) {
+
+  uint64_t result = 0;
+  for (int n=0; n<=8; n++) {
+    if (!can_born[n] && !can_survive[n]) continue;
+
+    uint64_t eq = ((n & 1) ? s0 : ~s0) & ((n & 2) ? s1 : ~s1) & ((n & 4) ? s2 : ~s2) & ((n & 8) ? s3 : ~s3);
+    uint64_t target = (can_born[n] ? ~alive : 0) | (can_survive[n] ? alive : 0);
+    result |= eq & target;
+  }
+  return result;
+}
+
+void packed_update_cells(Packed *p) {
+
+  const int words = p->words;
+  const int rest = p->width % 64;
+  const uint64_t last_mask = (rest == 0) ? ~0ULL : ((1ULL << rest) - 1);
+
+  for (int y=0; y<p->height; y++) {
+    const uint64_t *rows[3];
+    rows[0] = (y > 0) ? p->bits + (size_t)(y - 1) * words : NULL;
+    rows[1] = p->bits + (size_t)y * words;
+    rows[2] = (y < p->height - 1) ? p->bits + (size_t)(y + 1) * words : NULL;
+    uint64_t *out = p->next_bits + (size_t)y * words;
+
+    for (int k=0; k<words; k++) {
+      uint64_t in[8];
+      int n = 0;
+
+      for (int r=0; r<3; r++) {
+        uint64_t cur = 0, prev = 0, next = 0;
+        if (rows[r] != NULL) {
+          cur = rows[r][k];
+          if (k > 0) prev = rows[r][k - 1];
+          if (k < words - 1) next = rows[r][k + 1];
+        }
+        in[n++] = (cur << 1) | (prev >> 63); // 左隣(x-1)
+        in[n++] = (cur >> 1) | (next << 63); // 右隣(x+1)
+        if (r != 1) in[n++] = cur; // 真上と真下
+      }
+
+      uint64_t s0, s1, s2, s3;
+      add_neighbors(in, &s0, &s1, &s2, &s3);
+      out[k] = apply_rule(rows[1][k], s0, s1, s2, s3);
+    }
+    out[words - 1] &= last_mask;
+  }
+
+  uint64_t *tmp = p->bits;
+  p->bits = p->next_bits;
+  p->next_bits = tmp;
+}
+
+/*------------------------------------------------------------------------------------------------
+  正しさの確認
+------------------------------------------------------------------------------------------------*/
+
+/*
+  cellの状態からgens世代進めたときの、3つのカーネルのハッシュを比べる関数
+  一致すれば1を返す
+*/
+int verify_kernels(const char name[], const int height, const int width, int cell[height][width], int gens) {
+
+  int (*ref)[width] = malloc(sizeof(int) * height * width);
+  int (*a)[width] = malloc(sizeof(int) * height * width);
+  int (*b)[width] = malloc(sizeof(int) * height * width);
+  memcpy(ref, cell, sizeof(int) * height * width);
+  memcpy(a, cell, sizeof(int) * height * width);
+
+  Packed p = packed_new(height, width);
+  packed_from_cells(&p, cell);
+  make_rule_table();
+
+  for (int gen=0; gen<gens; gen++) {
+    my_update_cells(height, width, ref);
+    int_update_cells(height, width, a, b);
+    int (*tmp)[width] = a;
+    a = b;
+    b = tmp;
+    packed_update_cells(&p);
+  }
+
+  int (*unpacked)[width] = b; // もう使わないので展開先に使う
+  packed_to_cells(&p, unpacked);
+
+  uint64_t h_ref = hash_cells(height, width, ref);
+  uint64_t h_int = hash_cells(height, width, a);
+  uint64_t h_packed = hash_cells(height, width, unpacked);
+  int ok = (h_ref == h_int && h_ref == h_packed);
+
+  printf("  %-24s B%s/S%s ref=%016llx int=%016llx packed=%016llx %s\n", name, rule_B, rule_S,
+         (unsigned long long)h_ref, (unsigned long long)h_int, (unsigned long long)h_packed, ok ? "ok" : "MISMATCH");
+
+  packed_free(&p);
+  free(ref);
+  free(a);
+  free(b);
+  return ok;
+}
+
+int verify_all() {
+
+  const int height = 40;
+  const int width = 70;
+  int cell[height][width];
+  int ok = 1;
+
+  printf("verify (%d generations)\n", VERIFY_GENS);
+
+  /* 同梱パターン */
+  for (int i=0; i<(int)(sizeof(patterns) / sizeof(patterns[0])); i++) {
+    for (int y=0; y<height; y++) {
+      for (int x=0; x<width; x++) {
+        cell[y][x] = 0;
+      }
+    }
+    set_rule("3", "23"); // .lifはルールを持たないのでデフォルトに戻しておく
+    char filename[255];
+    strcpy(filename, patterns[i]);
+    if (my_init_cells(height, width, cell, filename) != 0) return 0;
+    ok &= verify_kernels(patterns[i], height, width, cell, VERIFY_GENS);
+  }
+
+  /* ランダムな初期状態(幅が64の倍数でない場合も確認する) */
+  for (int r=0; r<(int)(sizeof(rules) / sizeof(rules[0])); r++) {
+    set_rule(rules[r][0], rules[r][1]);
+    int (*soup)[100] = malloc(sizeof(int) * 100 * 100);
+    random_cells(100, 100, soup, 35, 12345 + r);
+    ok &= verify_kernels("random 100x100", 100, 100, soup, VERIFY_GENS);
+    free(soup);
+  }
+
+  return ok;
+}
+
+/*------------------------------------------------------------------------------------------------
+  計測
+------------------------------------------------------------------------------------------------*/
+
+double now_sec() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+  1回の計測結果を表示する関数
+  bytes_per_cellは1セルの更新で読み書きするバイト数
+*/
+void report(const char kernel[], int size, int density, double sec, int gens, double bytes_per_cell) {
+
+  double cells = (double)size * size * gens;
+  printf("%-7s %6dx%-6d B%-5s/S%-6s %3d%% %6d gens %9.3f ns/cell %8.2f GB/s\n",
+         kernel, size, size, rule_B, rule_S, density, gens, sec * 1e9 / cells, cells * bytes_per_cell / sec / 1e9);
+  fflush(stdout);
+}
+
+void bench(int size, int density) {
+
+  int gens = (int)(TARGET_CELLS / ((double)size * size));
+  if (gens < 1) gens = 1;
+
+  int (*cell)[size] = NULL;
+  int (*next_cell)[size] = NULL;
+
+  if (size <= INT_MAX_SIZE) {
+    cell = malloc(sizeof(int) * size * size);
+    next_cell = malloc(sizeof(int) * size * size);
+  }
+
+  /* ref */
+  if (size <= REF_MAX_SIZE) {
+    random_cells(size, size, cell, density, 1);
+    int ref_gens = gens / 10 + 1; // 遅いので世代数を減らす
+    double start = now_sec();
+    for (int gen=0; gen<ref_gens; gen++) my_update_cells(size, size, cell);
+    report("ref", size, density, now_sec() - start, ref_gens, 2 * sizeof(int));
+  }
+
+  /* int */
+  if (size <= INT_MAX_SIZE) {
+    random_cells(size, size, cell, density, 1);
+    make_rule_table();
+    double start = now_sec();
+    for (int gen=0; gen<gens; gen++) {
+      int_update_cells(size, size, cell, next_cell);
+      int (*tmp)[size] = cell;
+      cell = next_cell;
+      next_cell = tmp;
+    }
+    report("int", size, density, now_sec() - start, gens, 2 * sizeof(int));
+  }
+
+  /* packed */
+  {
+    Packed p = packed_new(size, size);
+    rng_state = 1;
+    for (int y=0; y<size; y++) {
+      for (int x=0; x<size; x++) {
+        if ((int)(next_rand() % 100) < density) p.bits[(size_t)y * p.words + x / 64] |= 1ULL << (x % 64);
+      }
+    }
+    double start = now_sec();
+    for (int gen=0; gen<gens; gen++) packed_update_cells(&p);
+    report("packed", size, density, now_sec() - start, gens, 2.0 / 8);
+    packed_free(&p);
+  }
+
+  free(cell);
+  free(next_cell);
+}
+
+int main(int argc, char **argv)
+{
+  int max_size = 16384;
+
+  if (argc > 2) {
+    fprintf(stderr, "usage: %s [max size]\n", argv[0]);
+    return EXIT_FAILURE;
+  } else if (argc == 2) {
+    max_size = atoi(argv[1]);
+  }
+
+  /* 高速なカーネルが参照実装と同じ結果を出さなければ計測しない */
+  if (!verify_all()) {
+    fprintf(stderr, "kernel mismatch\n");
+    return EXIT_FAILURE;
+  }
+
+  printf("\nbenchmark\n");
+  for (int size=64; size<=max_size; size*=4) {
+    for (int r=0; r<(int)(sizeof(rules) / sizeof(rules[0])); r++) {
+      set_rule(rules[r][0], rules[r][1]);
+      for (int d=0; d<(int)(sizeof(densities) / sizeof(densities[0])); d++) {
+        bench(size, densities[d]);
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,636 @@
+/*================================================================================================
+
+実行の記録と再生
+
+recordモードでは、パターンを読み込んで指定した世代数だけ進め、各世代をファイルに記録する。
+全世代の盤面をそのまま保存すると大きくなるので、
+  キーフレーム: KEYFRAME_INTERVAL世代ごとに盤面全体(1bit/セルに詰めた行)
+  差分      : それ以外の世代は、前の世代とのXOR(変化したセルだけ1になる)
+を保存する。どちらも0のバイトが続きやすいので、0の連続をまとめる簡単な圧縮をかけている。
+ファイルの最後にはキーフレームの位置の索引を置く。
+
+replayモードでは、索引から開始世代以前で最も近いキーフレームを探し、そこから差分を当てて開始世代を復元する。
+そのためシークにかかる時間はキーフレーム間隔に比例し、シミュレーションをやり直す必要はない。
+あとはmy_print_cells()で表示しながら差分を当てていくだけ。
+
+ファイル形式(整数は実行環境のバイト順のまま書き出す)
+  ヘッダー : "LIFELOG1", height, width, キーフレーム間隔, rule_B[10], rule_S[10]
+  フレーム : 世代(uint32), 種類('K'か'D'), 圧縮後の長さ(uint32), 圧縮データ
+  索引     : キーフレーム数(uint32), (世代(uint32), ファイル内の位置(uint64)) x キーフレーム数
+  末尾     : 索引の位置(uint64), "LIFEIDX1"
+
+引数
+  record [パターンファイル(""ならランダム)] [出力ファイル] [世代数] [キーフレーム間隔(省略時は64)]
+  replay [記録ファイル] [開始世代(省略時は0)] [1世代あたりの表示時間ms(省略時は200)]
+
+実行例
+  ./a.out record gosperglidergun.lif gun.log 1000
+  ./a.out replay gun.log 500 50
+
+================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h> // sleep()関数を使う
+#include <time.h>
+#include <string.h>
+#include <stdint.h>
+
+/* デフォルトのルール */
+int can_survive[9] = {0, 0, 1, 1, 0};
+int can_born[9] = {0, 0, 0, 1, 0};
+char rule_S[10] = "23";
+char rule_B[10] = "3";
+
+/*
+  文字列strの最後がsuffixに一致するか判定する関数
+*/
+int ends_with(const char str[], const char suffix[]) {
+
+  int len_str = strlen(str);
+  int len_suf = strlen(suffix);
+
+  if (len_str < len_suf) return 0;
+
+  char lower_str[255];
+  char lower_suffix[255];
+  strcpy(lower_str, str);
+  strcpy(lower_suffix, suffix);
+
+  /* 大文字は全て小文字にする */
+  for (int i=0; lower_str[i] != 0; i++) {
+    if ('A' <= lower_str[i] && lower_str[i] <= 'Z') {
+      lower_str[i] += 'a' - 'A';
+    }
+  }
+  for (int i=0; lower_suffix[i] != 0; i++) {
+    if ('A' <= lower_suffix[i] && lower_suffix[i] <= 'Z') {
+      lower_suffix[i] += 'a' - 'A';
+    }
+  }
+
+  return (strcmp(lower_str + len_str - len_suf, lower_suffix) == 0);
+}
+
+/*
+  文字列を10進数で表した時の長さを返す関数
+  ただし、0の長さは0とする
+*/
+int number_len(int n) {
+  int len = 0;
+  while(n > 0) {
+    len++;
+    n /= 10;
+  }
+
+  return len;
+}
+
+/*
+  文字が空白、タブ、CR、LFのいずれかなら1を返す関数
+*/
+int isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+int loadRLE(const int height, const int width, int cell[height][width], FILE *fp) {
+
+  char buffer[(int)1e4+1]; // 1行は70文字以下だが念のため
+  int y = 0, x = 0;
+  int offsetY = 0, offsetX = 0;
+  while(fgets(buffer, 1e4, fp) != NULL) {
+
+    /* オフセット指定以外のヘッダー情報は読み飛ばす */
+    if (buffer[0] == '#') {
+      if (buffer[1] == 'P' || buffer[1] == 'R') {
+        sscanf(buffer+2, "%d%d", &offsetX, &offsetY);
+        if (offsetY < 0 || offsetX < 0) {
+          offsetY = 0;
+          offsetX = 0;
+        } else {
+          y = offsetY;
+          x = offsetX;
+        }
+      }
+      continue;
+    }
+
+    /* サイズ情報は読み飛ばし、ルールは反映する */
+    if (buffer[0] == 'x') {
+      int result = sscanf(buffer, "x = %*d, y = %*d, rule = B%9[^/n]/S%9s", rule_B, rule_S);
+
+      for (int i=0; i<=8; i++) {
+        can_survive[i] = 0;
+        can_born[i] = 0;
+      }
+
+      for (int i=0; i<10; i++) {
+        int s = rule_S[i] - '0';
+        int b = rule_B[i] - '0';
+        if (0 <= s && s <= 8) can_survive[s] = 1;
+        if (0 <= b && b <= 8) can_born[b] = 1;
+      }
+
+      continue;
+    }
+
+    int offset = 0; // 行の何文字目を次に読むか
+    while(1) {
+      int len = 0; // ランの長さ
+      char c; // タグ('o', 'b', '$', '!'のいずれか)
+
+      // 途中に空白が入っても対応可能
+      while(isWhitespace(buffer[offset])) offset++;
+
+      // ランの長さを取得(1が省略されている場合は何も読み込まない)
+      int result = sscanf(buffer+offset, "%d", &len);
+      // 読み込んだ分だけoffsetを加算(ただし0のままの場合は読みこんでないのでそのまま)
+      offset += number_len(len);
+
+      // 長さ省略時は1
+      if (len == 0) len = 1;
+
+      // ランのタグを取得
+      result = sscanf(buffer+offset, "%c", &c);
+      offset++;
+
+      if (result <= 0 || c == '!') { // 終了
+        break;
+      } else if (c == '$') { // 改行
+        y += len;
+        x = offsetX;
+      } else if (c == 'b') { // dead
+        x += len;
+      } else if (c == 'o') { // alive
+        for (int i=0; i<len; i++) {
+          cell[y][x] = 1;
+          x++;
+        }
+      } else {
+        fprintf(stderr,"Invalid syntax\n");
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ ファイルによるセルの初期化: 生きているセルの座標が記述されたファイルをもとに2次元配列の状態を初期化する
+ fp = NULL のときは、関数内で適宜定められた初期状態に初期化する。関数内初期値はdefault.lif と同じもの
+ */
+int my_init_cells(const int height, const int width, int cell[height][width], char filename[]) {
+
+  if (filename[0] == 0) {
+    /* ランダムに配置する */
+    srand(time(NULL));
+
+    for (int y=0; y<height; y++) {
+      for (int x=0; x<width; x++) {
+        cell[y][x] = (rand() % 10 == 0 ? 1 : 0);
+      }
+    }
+  } else {
+
+    FILE *fp = fopen(filename,"r");
+    if (fp == NULL) {
+      fprintf(stderr,"cannot open file %s\n", filename);
+      return EXIT_FAILURE;
+    }
+
+    if (ends_with(filename, ".lif")) {
+
+      fscanf(fp, "%*[^\n]\n"); // バージョン情報は読み飛ばす
+
+      int x, y;
+      while (fscanf(fp, "%d%d", &x, &y) > 0) {
+        cell[y][x] = 1;
+      }
+
+    } else if (ends_with(filename, ".rle")) {
+
+      int result = loadRLE(height, width, cell, fp);
+      if (result != 0) return EXIT_FAILURE;
+
+    } else {
+
+      fprintf(stderr,"Supported: .lif .rle\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ グリッドの描画: 世代情報とグリッドの配列等を受け取り、ファイルポインタに該当する出力にグリッドを描画する
+ */
+void my_print_cells(FILE *fp, int gen, const int height, const int width, int cell[height][width]) {
+
+  /* 0,1それぞれの状態のセルをカウント */
+  int count_cells[2] = {0, 0};
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      count_cells[cell[y][x]]++;
+    }
+  }
+
+  // 世代情報と存在比を表示
+  fprintf(fp, "rule: B%s/S%s, generateion = %d, alive:dead = %7d:%7d\r\n", rule_B, rule_S, gen, count_cells[1], count_cells[0]);
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  /* グリッド */
+  for (int y=0; y<height; y++) {
+    fprintf(fp, "|");
+    for (int x=0; x<width; x++) {
+      fprintf(fp, "\e[31m%c\e[0m", (cell[y][x] ? '#' : ' ')); // 赤色で表示
+    }
+    fprintf(fp, "|\r\n");
+  }
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  fflush(fp);
+}
+
+int in_cells(int y, int x, const int height, const int width) {
+
+  if (y < 0 || height <= y) return 0;
+  if (x < 0 || width <= x) return 0;
+
+  return 1;
+}
+
+/*
+ 着目するセルの周辺の生きたセルをカウントする関数
+ */
+int my_count_adjacent_cells(int y, int x, const int height, const int width, int cell[height][width]) {
+
+  /*
+    dy, dx: 相対位置
+    012
+    7.3
+    654
+  */
+  int dy[] = {-1, -1, -1, 0, 1, 1, 1, 0};
+  int dx[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+
+  int count = 0;
+  
+  for (int i=0; i<8; i++) {
+
+    int ny = y + dy[i];
+    int nx = x + dx[i];
+
+    if (in_cells(ny, nx, height, width) && cell[ny][nx]) {
+      count++;
+    }
+
+  }
+
+  return count;
+}
+
+/*
+  着目するセルの次の世代での状態を返す関数
+*/
+int next_state(int y, int x, const int height, const int width, int cell[height][width], int neighbors) {
+
+  if (cell[y][x]) { 
+    return can_survive[neighbors];
+  } else {
+    return can_born[neighbors];
+  }
+
+}
+
+/*
+ ライフゲームのルールに基づいて2次元配列の状態を更新する
+ */
+void my_update_cells(const int height, const int width, int cell[height][width]) {
+
+  int next_cell[height][width];
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      next_cell[y][x] = 0;
+    }
+  }
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      int neighbors = my_count_adjacent_cells(y, x, height, width, cell);
+      next_cell[y][x] = next_state(y, x, height, width, cell, neighbors);
+    }
+  }
+
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      cell[y][x] = next_cell[y][x];
+    }
+  }
+
+}
+
+#define KEYFRAME_INTERVAL 64 // キーフレームの間隔(世代数)のデフォルト
+#define MAX_KEYFRAMES 100000 // 索引に載せるキーフレーム数の上限
+
+/*
+  盤面を1bit/セルの行に詰める関数
+  1行は(width+7)/8バイトで、x番目のセルは(x/8)バイト目の(x%8)ビット目
+*/
+void pack_cells(const int height, const int width, int cell[height][width], uint8_t packed[]) {
+
+  const int row_bytes = (width + 7) / 8;
+  memset(packed, 0, (size_t)row_bytes * height);
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      if (cell[y][x]) packed[y * row_bytes + x / 8] |= 1 << (x % 8);
+    }
+  }
+}
+
+void unpack_cells(const int height, const int width, int cell[height][width], const uint8_t packed[]) {
+
+  const int row_bytes = (width + 7) / 8;
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      cell[y][x] = (packed[y * row_bytes + x / 8] >> (x % 8)) & 1;
+    }
+  }
+}
+
+/*
+  圧縮後の長さの上限
+  0と0以外が交互に並ぶと、2バイトごとに見出し2バイトが付いて1.5倍になるのが最悪
+*/
+size_t compressed_bound(size_t len) {
+  return len + len / 2 + 2;
+}
+
+/*
+  0の連続をまとめる圧縮
+  1バイト目が0x80以上なら(値&0x7f)個の0、そうでなければその個数だけ後ろのバイトをそのまま使う。
+  圧縮後の長さを返す(outにはcompressed_bound(len)バイト必要)
+*/
+size_t compress_zero_runs(const uint8_t in[], size_t len, uint8_t out[]) {
+
+  size_t i = 0, n = 0;
+  while (i < len) {
+    if (in[i] == 0) {
+      size_t run = 0;
+      while (i < len && in[i] == 0 && run < 127) {
+        i++;
+        run++;
+      }
+      out[n++] = 0x80 | run;
+    } else {
+      size_t start = i;
+      while (i < len && in[i] != 0 && i - start < 127) i++;
+      out[n++] = i - start;
+      memcpy(out + n, in + start, i - start);
+      n += i - start;
+    }
+  }
+  return n;
+}
+
+/*
+  compress_zero_runs()の逆。展開したバイト数を返す(lenを超える場合は-1)
+*/
+long decompress_zero_runs(const uint8_t in[], size_t in_len, uint8_t out[], size_t len) {
+
+  size_t i = 0, n = 0;
+  while (i < in_len) {
+    int run = in[i] & 0x7f;
+    if (n + run > len) return -1;
+    if (in[i++] & 0x80) {
+      memset(out + n, 0, run);
+    } else {
+      if (i + run > in_len) return -1;
+      memcpy(out + n, in + i, run);
+      i += run;
+    }
+    n += run;
+  }
+  return n;
+}
+
+/*
+  1フレームを書き出す関数
+*/
+void write_frame(FILE *fp, uint32_t gen, char type, const uint8_t data[], size_t len, uint8_t work[]) {
+
+  uint32_t clen = compress_zero_runs(data, len, work);
+  fwrite(&gen, sizeof(gen), 1, fp);
+  fwrite(&type, 1, 1, fp);
+  fwrite(&clen, sizeof(clen), 1, fp);
+  fwrite(work, 1, clen, fp);
+}
+
+/*
+  1フレームを読み込む関数(読み込めたら1を返す)
+*/
+int read_frame(FILE *fp, uint32_t *gen, char *type, uint8_t data[], size_t len, uint8_t work[], size_t work_len) {
+
+  uint32_t clen;
+  if (fread(gen, sizeof(*gen), 1, fp) != 1) return 0;
+  if (fread(type, 1, 1, fp) != 1) return 0;
+  if (fread(&clen, sizeof(clen), 1, fp) != 1) return 0;
+  if (clen > work_len || fread(work, 1, clen, fp) != clen) return 0;
+
+  return decompress_zero_runs(work, clen, data, len) == (long)len;
+}
+
+int record(const char pattern[], const char filename[], int gens, int interval) {
+
+  const int height = 40;
+  const int width = 70;
+  const size_t len = (size_t)(width + 7) / 8 * height;
+
+  int cell[height][width];
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      cell[y][x] = 0;
+    }
+  }
+
+  char name[255];
+  strcpy(name, pattern);
+  if (my_init_cells(height, width, cell, name) != 0) return EXIT_FAILURE;
+
+  FILE *fp = fopen(filename, "wb");
+  if (fp == NULL) {
+    fprintf(stderr, "cannot open file %s\n", filename);
+    return EXIT_FAILURE;
+  }
+
+  uint32_t header[3] = {height, width, interval};
+  fwrite("LIFELOG1", 1, 8, fp);
+  fwrite(header, sizeof(uint32_t), 3, fp);
+  fwrite(rule_B, 1, sizeof(rule_B), fp);
+  fwrite(rule_S, 1, sizeof(rule_S), fp);
+
+  uint8_t *prev = malloc(len);
+  uint8_t *cur = malloc(len);
+  uint8_t *diff = malloc(len);
+  uint8_t *work = malloc(compressed_bound(len));
+  uint32_t *key_gens = malloc(sizeof(uint32_t) * MAX_KEYFRAMES);
+  uint64_t *key_offsets = malloc(sizeof(uint64_t) * MAX_KEYFRAMES);
+  uint32_t keyframes = 0;
+
+  for (int gen=0; gen<=gens; gen++) {
+    if (gen > 0) my_update_cells(height, width, cell);
+    pack_cells(height, width, cell, cur);
+
+    if (gen % interval == 0 && keyframes < MAX_KEYFRAMES) {
+      key_gens[keyframes] = gen;
+      key_offsets[keyframes] = ftell(fp);
+      keyframes++;
+      write_frame(fp, gen, 'K', cur, len, work);
+    } else {
+      for (size_t i=0; i<len; i++) diff[i] = prev[i] ^ cur[i];
+      write_frame(fp, gen, 'D', diff, len, work);
+    }
+
+    uint8_t *tmp = prev;
+    prev = cur;
+    cur = tmp;
+  }
+
+  /* 索引と末尾 */
+  uint64_t index_offset = ftell(fp);
+  fwrite(&keyframes, sizeof(keyframes), 1, fp);
+  for (uint32_t i=0; i<keyframes; i++) {
+    fwrite(&key_gens[i], sizeof(uint32_t), 1, fp);
+    fwrite(&key_offsets[i], sizeof(uint64_t), 1, fp);
+  }
+  fwrite(&index_offset, sizeof(index_offset), 1, fp);
+  fwrite("LIFEIDX1", 1, 8, fp);
+
+  fprintf(stderr, "recorded %d generations (%u keyframes, %ld bytes) to %s\n", gens, keyframes, ftell(fp), filename);
+
+  fclose(fp);
+  free(prev);
+  free(cur);
+  free(diff);
+  free(work);
+  free(key_gens);
+  free(key_offsets);
+  return EXIT_SUCCESS;
+}
+
+int replay(const char filename[], int start, int delay_ms) {
+
+  FILE *fp = fopen(filename, "rb");
+  if (fp == NULL) {
+    fprintf(stderr, "cannot open file %s\n", filename);
+    return EXIT_FAILURE;
+  }
+
+  char magic[8];
+  uint32_t header[3];
+  if (fread(magic, 1, 8, fp) != 8 || memcmp(magic, "LIFELOG1", 8) != 0 ||
+      fread(header, sizeof(uint32_t), 3, fp) != 3 ||
+      fread(rule_B, 1, sizeof(rule_B), fp) != sizeof(rule_B) ||
+      fread(rule_S, 1, sizeof(rule_S), fp) != sizeof(rule_S)) {
+    fprintf(stderr, "%s is not a life log\n", filename);
+    fclose(fp);
+    return EXIT_FAILURE;
+  }
+  rule_B[sizeof(rule_B) - 1] = 0;
+  rule_S[sizeof(rule_S) - 1] = 0;
+
+  const int height = header[0];
+  const int width = header[1];
+  const size_t len = (size_t)(width + 7) / 8 * height;
+  const size_t work_len = compressed_bound(len);
+
+  /* 末尾から索引を読み、開始世代以前で最も近いキーフレームを探す */
+  uint64_t index_offset;
+  uint32_t keyframes;
+  fseek(fp, -(long)(sizeof(index_offset) + 8), SEEK_END);
+  if (fread(&index_offset, sizeof(index_offset), 1, fp) != 1 || fread(magic, 1, 8, fp) != 8 ||
+      memcmp(magic, "LIFEIDX1", 8) != 0) {
+    fprintf(stderr, "%s has no index\n", filename);
+    fclose(fp);
+    return EXIT_FAILURE;
+  }
+  fseek(fp, index_offset, SEEK_SET);
+  fread(&keyframes, sizeof(keyframes), 1, fp);
+
+  uint64_t seek_offset = 0;
+  for (uint32_t i=0; i<keyframes; i++) {
+    uint32_t key_gen;
+    uint64_t key_offset;
+    fread(&key_gen, sizeof(key_gen), 1, fp);
+    fread(&key_offset, sizeof(key_offset), 1, fp);
+    if (key_gen <= (uint32_t)start) seek_offset = key_offset;
+  }
+  if (seek_offset == 0) {
+    fprintf(stderr, "no keyframe before generation %d\n", start);
+    fclose(fp);
+    return EXIT_FAILURE;
+  }
+  fseek(fp, seek_offset, SEEK_SET);
+
+  uint8_t *frame = malloc(len);
+  uint8_t *data = malloc(len);
+  uint8_t *work = malloc(work_len);
+  int (*cell)[width] = malloc(sizeof(int) * height * width);
+
+  /* キーフレームから差分を当てて開始世代まで進め、その後は表示しながら進める */
+  uint32_t gen;
+  char type;
+  int printed = 0;
+  while (ftell(fp) < (long)index_offset && read_frame(fp, &gen, &type, data, len, work, work_len)) {
+    if (type == 'K') {
+      memcpy(frame, data, len);
+    } else {
+      for (size_t i=0; i<len; i++) frame[i] ^= data[i];
+    }
+
+    if (gen < (uint32_t)start) continue;
+
+    if (printed) fprintf(stdout, "\e[%dA", height+3); // height+3 の分、カーソルを上に戻す(壁2、表示部1)
+    unpack_cells(height, width, cell, frame);
+    my_print_cells(stdout, gen, height, width, cell);
+    printed = 1;
+    usleep(delay_ms * 1000);
+  }
+
+  if (!printed) fprintf(stderr, "generation %d is not recorded\n", start);
+
+  fclose(fp);
+  free(frame);
+  free(data);
+  free(work);
+  free(cell);
+  return printed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc >= 5 && argc <= 6 && strcmp(argv[1], "record") == 0) {
+    int interval = (argc == 6) ? atoi(argv[5]) : KEYFRAME_INTERVAL;
+    if (interval <= 0) interval = KEYFRAME_INTERVAL;
+    return record(argv[2], argv[3], atoi(argv[4]), interval);
+  } else if (argc >= 3 && argc <= 5 && strcmp(argv[1], "replay") == 0) {
+    int start = (argc >= 4) ? atoi(argv[3]) : 0;
+    int delay_ms = (argc == 5) ? atoi(argv[4]) : 200;
+    return replay(argv[2], start, delay_ms);
+  }
+
+  fprintf(stderr, "usage: %s record [filename for init] [log file] [generations] [keyframe interval]\n", argv[0]);
+  fprintf(stderr, "       %s replay [log file] [start generation] [delay(ms)]\n", argv[0]);
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,588 @@
+/*================================================================================================
+
+複数プロセスによる領域分割
+
+盤面を横方向の帯(strip)に分け、N個のワーカープロセスがそれぞれ1つの帯を担当して更新する。
+各ワーカーは自分の帯の上下にk行ずつ「のりしろ」(ghost行)を持ち、k世代ごとに隣のワーカーと
+自分の端のk行を交換する。のりしろの外側から誤りが1世代に1行ずつ入り込むが、
+k世代の間ならそれはのりしろの中に収まるので、自分の帯は正しく更新される。
+(k=1なら毎世代1行ずつ交換する。kを大きくすると交換の回数が減る代わりに、のりしろの計算が増える。)
+
+帯の更新にはmylife3.cのmy_update_cells()をそのまま使う。
+盤面の上端・下端にあたるのりしろは盤面の外なので、毎世代0に戻す。
+
+通信はTransport構造体の関数ポインタを通して行うので、実装を差し替えられる。
+ここではUnixドメインソケット(socketpair)による実装だけを用意した。
+各ワーカーは毎世代自分の帯を親プロセスに送り、親がつなぎ合わせてmy_print_cells()で表示する。
+
+-cを付けると、親プロセスが1プロセスのmy_update_cells()でも同じ盤面を更新し、
+毎世代ワーカーの結果と一致するか確認する(一致しなければ終了する)。
+
+引数
+  arg[1] -c(省略可)
+  arg[2] ワーカー数
+  arg[3] のりしろの行数k
+  arg[4] 初期状態のファイル(省略時はランダム)
+
+実行例
+  ./a.out 4 1 gosperglidergun.lif
+  ./a.out -c 3 2 Bomber.rle
+
+================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h> // sleep()関数を使う
+#include <time.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <signal.h>
+
+/* デフォルトのルール */
+int can_survive[9] = {0, 0, 1, 1, 0};
+int can_born[9] = {0, 0, 0, 1, 0};
+char rule_S[10] = "23";
+char rule_B[10] = "3";
+
+/*
+  文字列strの最後がsuffixに一致するか判定する関数
+*/
+int ends_with(const char str[], const char suffix[]) {
+
+  int len_str = strlen(str);
+  int len_suf = strlen(suffix);
+
+  if (len_str < len_suf) return 0;
+
+  char lower_str[255];
+  char lower_suffix[255];
+  strcpy(lower_str, str);
+  strcpy(lower_suffix, suffix);
+
+  /* 大文字は全て小文字にする */
+  for (int i=0; lower_str[i] != 0; i++) {
+    if ('A' <= lower_str[i] && lower_str[i] <= 'Z') {
+      lower_str[i] += 'a' - 'A';
+    }
+  }
+  for (int i=0; lower_suffix[i] != 0; i++) {
+    if ('A' <= lower_suffix[i] && lower_suffix[i] <= 'Z') {
+      lower_suffix[i] += 'a' - 'A';
+    }
+  }
+
+  return (strcmp(lower_str + len_str - len_suf, lower_suffix) == 0);
+}
+
+/*
+  文字列を10進数で表した時の長さを返す関数
+  ただし、0の長さは0とする
+*/
+int number_len(int n) {
+  int len = 0;
+  while(n > 0) {
+    len++;
+    n /= 10;
+  }
+
+  return len;
+}
+
+/*
+  文字が空白、タブ、CR、LFのいずれかなら1を返す関数
+*/
+int isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+int loadRLE(const int height, const int width, int cell[height][width], FILE *fp) {
+
+  char buffer[(int)1e4+1]; // 1行は70文字以下だが念のため
+  int y = 0, x = 0;
+  int offsetY = 0, offsetX = 0;
+  while(fgets(buffer, 1e4, fp) != NULL) {
+
+    /* オフセット指定以外のヘッダー情報は読み飛ばす */
+    if (buffer[0] == '#') {
+      if (buffer[1] == 'P' || buffer[1] == 'R') {
+        sscanf(buffer+2, "%d%d", &offsetX, &offsetY);
+        if (offsetY < 0 || offsetX < 0) {
+          offsetY = 0;
+          offsetX = 0;
+        } else {
+          y = offsetY;
+          x = offsetX;
+        }
+      }
+      continue;
+    }
+
+    /* サイズ情報は読み飛ばし、ルールは反映する */
+    if (buffer[0] == 'x') {
+      int result = sscanf(buffer, "x = %*d, y = %*d, rule = B%9[^/n]/S%9s", rule_B, rule_S);
+
+      for (int i=0; i<=8; i++) {
+        can_survive[i] = 0;
+        can_born[i] = 0;
+      }
+
+      for (int i=0; i<10; i++) {
+        int s = rule_S[i] - '0';
+        int b = rule_B[i] - '0';
+        if (0 <= s && s <= 8) can_survive[s] = 1;
+        if (0 <= b && b <= 8) can_born[b] = 1;
+      }
+
+      continue;
+    }
+
+    int offset = 0; // 行の何文字目を次に読むか
+    while(1) {
+      int len = 0; // ランの長さ
+      char c; // タグ('o', 'b', '$', '!'のいずれか)
+
+      // 途中に空白が入っても対応可能
+      while(isWhitespace(buffer[offset])) offset++;
+
+      // ランの長さを取得(1が省略されている場合は何も読み込まない)
+      int result = sscanf(buffer+offset, "%d", &len);
+      // 読み込んだ分だけoffsetを加算(ただし0のままの場合は読みこんでないのでそのまま)
+      offset += number_len(len);
+
+      // 長さ省略時は1
+      if (len == 0) len = 1;
+
+      // ランのタグを取得
+      result = sscanf(buffer+offset, "%c", &c);
+      offset++;
+
+      if (result <= 0 || c == '!') { // 終了
+        break;
+      } else if (c == '$') { // 改行
+        y += len;
+        x = offsetX;
+      } else if (c == 'b') { // dead
+        x += len;
+      } else if (c == 'o') { // alive
+        for (int i=0; i<len; i++) {
+          cell[y][x] = 1;
+          x++;
+        }
+      } else {
+        fprintf(stderr,"Invalid syntax\n");
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ ファイルによるセルの初期化: 生きているセルの座標が記述されたファイルをもとに2次元配列の状態を初期化する
+ fp = NULL のときは、関数内で適宜定められた初期状態に初期化する。関数内初期値はdefault.lif と同じもの
+ */
+int my_init_cells(const int height, const int width, int cell[height][width], char filename[]) {
+
+  if (filename[0] == 0) {
+    /* ランダムに配置する */
+    srand(time(NULL));
+
+    for (int y=0; y<height; y++) {
+      for (int x=0; x<width; x++) {
+        cell[y][x] = (rand() % 10 == 0 ? 1 : 0);
+      }
+    }
+  } else {
+
+    FILE *fp = fopen(filename,"r");
+    if (fp == NULL) {
+      fprintf(stderr,"cannot open file %s\n", filename);
+      return EXIT_FAILURE;
+    }
+
+    if (ends_with(filename, ".lif")) {
+
+      fscanf(fp, "%*[^\n]\n"); // バージョン情報は読み飛ばす
+
+      int x, y;
+      while (fscanf(fp, "%d%d", &x, &y) > 0) {
+        cell[y][x] = 1;
+      }
+
+    } else if (ends_with(filename, ".rle")) {
+
+      int result = loadRLE(height, width, cell, fp);
+      if (result != 0) return EXIT_FAILURE;
+
+    } else {
+
+      fprintf(stderr,"Supported: .lif .rle\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ グリッドの描画: 世代情報とグリッドの配列等を受け取り、ファイルポインタに該当する出力にグリッドを描画する
+ */
+void my_print_cells(FILE *fp, int gen, const int height, const int width, int cell[height][width]) {
+
+  /* 0,1それぞれの状態のセルをカウント */
+  int count_cells[2] = {0, 0};
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      count_cells[cell[y][x]]++;
+    }
+  }
+
+  // 世代情報と存在比を表示
+  fprintf(fp, "rule: B%s/S%s, generateion = %d, alive:dead = %7d:%7d\r\n", rule_B, rule_S, gen, count_cells[1], count_cells[0]);
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  /* グリッド */
+  for (int y=0; y<height; y++) {
+    fprintf(fp, "|");
+    for (int x=0; x<width; x++) {
+      fprintf(fp, "\e[31m%c\e[0m", (cell[y][x] ? '#' : ' ')); // 赤色で表示
+    }
+    fprintf(fp, "|\r\n");
+  }
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  fflush(fp);
+}
+
+int in_cells(int y, int x, const int height, const int width) {
+
+  if (y < 0 || height <= y) return 0;
+  if (x < 0 || width <= x) return 0;
+
+  return 1;
+}
+
+/*
+ 着目するセルの周辺の生きたセルをカウントする関数
+ */
+int my_count_adjacent_cells(int y, int x, const int height, const int width, int cell[height][width]) {
+
+  /*
+    dy, dx: 相対位置
+    012
+    7.3
+    654
+  */
+  int dy[] = {-1, -1, -1, 0, 1, 1, 1, 0};
+  int dx[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+
+  int count = 0;
+  
+  for (int i=0; i<8; i++) {
+
+    int ny = y + dy[i];
+    int nx = x + dx[i];
+
+    if (in_cells(ny, nx, height, width) && cell[ny][nx]) {
+      count++;
+    }
+
+  }
+
+  return count;
+}
+
+/*
+  着目するセルの次の世代での状態を返す関数
+*/
+int next_state(int y, int x, const int height, const int width, int cell[height][width], int neighbors) {
+
+  if (cell[y][x]) { 
+    return can_survive[neighbors];
+  } else {
+    return can_born[neighbors];
+  }
+
+}
+
+/*
+ ライフゲームのルールに基づいて2次元配列の状態を更新する
+ */
+void my_update_cells(const int height, const int width, int cell[height][width]) {
+
+  int next_cell[height][width];
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      next_cell[y][x] = 0;
+    }
+  }
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      int neighbors = my_count_adjacent_cells(y, x, height, width, cell);
+      next_cell[y][x] = next_state(y, x, height, width, cell, neighbors);
+    }
+  }
+
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      cell[y][x] = next_cell[y][x];
+    }
+  }
+
+}
+
+/*------------------------------------------------------------------------------------------------
+  通信(Transport)
+  peerはPEER_UP(上の帯), PEER_DOWN(下の帯), PEER_PARENT(親プロセス)のいずれか。
+  send/recvは指定したバイト数を全て送受信し終わるまで戻らない。失敗したら-1を返す。
+------------------------------------------------------------------------------------------------*/
+
+enum { PEER_UP, PEER_DOWN, PEER_PARENT, PEERS };
+
+typedef struct Transport {
+  int (*send)(struct Transport *t, int peer, const void *buf, size_t len);
+  int (*recv)(struct Transport *t, int peer, void *buf, size_t len);
+  void (*close)(struct Transport *t);
+  int fds[PEERS]; // ソケット実装で使う(相手がいなければ-1)
+} Transport;
+
+int socket_send(Transport *t, int peer, const void *buf, size_t len) {
+
+  const char *p = buf;
+  while (len > 0) {
+    ssize_t n = write(t->fds[peer], p, len);
+    if (n <= 0) return -1;
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+int socket_recv(Transport *t, int peer, void *buf, size_t len) {
+
+  char *p = buf;
+  while (len > 0) {
+    ssize_t n = read(t->fds[peer], p, len);
+    if (n <= 0) return -1;
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+void socket_close(Transport *t) {
+  for (int i=0; i<PEERS; i++) {
+    if (t->fds[i] != -1) close(t->fds[i]);
+    t->fds[i] = -1;
+  }
+}
+
+Transport socket_transport() {
+
+  Transport t;
+  t.send = socket_send;
+  t.recv = socket_recv;
+  t.close = socket_close;
+  for (int i=0; i<PEERS; i++) t.fds[i] = -1;
+  return t;
+}
+
+/*------------------------------------------------------------------------------------------------
+  ワーカー
+------------------------------------------------------------------------------------------------*/
+
+/*
+  ワーカーrankが担当する帯の最初の行を返す関数(rank = workersなら盤面の高さ)
+*/
+int strip_begin(int rank, int workers, int height) {
+  return height * rank / workers;
+}
+
+/*
+  隣のワーカーとのりしろを交換する関数
+  デッドロックを避けるため、上のワーカーが先に送り、下のワーカーが先に受け取る。
+*/
+int exchange_halo(Transport *t, int rank, int workers, int own_h, int halo, const int width, int local[own_h + 2*halo][width]) {
+
+  const size_t len = sizeof(int) * halo * width;
+
+  if (rank > 0) {
+    if (t->recv(t, PEER_UP, local[0], len) != 0) return -1;
+    if (t->send(t, PEER_UP, local[halo], len) != 0) return -1;
+  }
+  if (rank < workers - 1) {
+    if (t->send(t, PEER_DOWN, local[own_h], len) != 0) return -1;
+    if (t->recv(t, PEER_DOWN, local[own_h + halo], len) != 0) return -1;
+  }
+  return 0;
+}
+
+void worker_main(Transport *t, int rank, int workers, int halo, const int height, const int width, int cell[height][width]) {
+
+  const int begin = strip_begin(rank, workers, height);
+  const int own_h = strip_begin(rank + 1, workers, height) - begin;
+  const int local_h = own_h + 2 * halo;
+
+  /* local[halo]からlocal[halo+own_h-1]が自分の帯 */
+  int (*local)[width] = calloc((size_t)local_h * width, sizeof(int));
+  memcpy(local[halo], cell[begin], sizeof(int) * own_h * width);
+
+  for (int gen = 0 ;; gen++) {
+    if (gen % halo == 0) {
+      if (exchange_halo(t, rank, workers, own_h, halo, width, local) != 0) break;
+    }
+
+    my_update_cells(local_h, width, local);
+
+    /* 盤面の外にあたるのりしろは常に死んでいる */
+    if (rank == 0) memset(local[0], 0, sizeof(int) * halo * width);
+    if (rank == workers - 1) memset(local[own_h + halo], 0, sizeof(int) * halo * width);
+
+    if (t->send(t, PEER_PARENT, local[halo], sizeof(int) * own_h * width) != 0) break;
+  }
+
+  free(local);
+  t->close(t);
+}
+
+/*
+  ワーカーを起動する関数
+  親がワーカーiと話すためのソケットをparent_fds[i]に入れる
+*/
+int start_workers(int workers, int halo, const int height, const int width, int cell[height][width], pid_t pids[], int parent_fds[]) {
+
+  int down_fds[workers][2]; // ワーカーiとi+1をつなぐソケット
+  int up_fds[workers][2];   // 親とワーカーiをつなぐソケット
+
+  for (int i=0; i<workers; i++) {
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, up_fds[i]) != 0) return -1;
+    if (i < workers - 1 && socketpair(AF_UNIX, SOCK_STREAM, 0, down_fds[i]) != 0) return -1;
+  }
+
+  for (int i=0; i<workers; i++) {
+    pids[i] = fork();
+    if (pids[i] < 0) return -1;
+
+    if (pids[i] == 0) {
+      Transport t = socket_transport();
+      t.fds[PEER_PARENT] = up_fds[i][1];
+      if (i > 0) t.fds[PEER_UP] = down_fds[i-1][1];
+      if (i < workers - 1) t.fds[PEER_DOWN] = down_fds[i][0];
+
+      /* 自分が使わないソケットは閉じる */
+      for (int j=0; j<workers; j++) {
+        close(up_fds[j][0]);
+        if (j != i) close(up_fds[j][1]);
+        if (j < workers - 1) {
+          if (j != i) close(down_fds[j][0]);
+          if (j != i - 1) close(down_fds[j][1]);
+        }
+      }
+
+      worker_main(&t, i, workers, halo, height, width, cell);
+      exit(EXIT_SUCCESS);
+    }
+  }
+
+  for (int i=0; i<workers; i++) {
+    parent_fds[i] = up_fds[i][0];
+    close(up_fds[i][1]);
+    if (i < workers - 1) {
+      close(down_fds[i][0]);
+      close(down_fds[i][1]);
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  FILE *fp = stdout;
+  const int height = 40;
+  const int width = 70;
+  int check = 0;
+
+  int cell[height][width];
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      cell[y][x] = 0;
+    }
+  }
+
+  if (argc >= 2 && strcmp(argv[1], "-c") == 0) {
+    check = 1;
+    argc--;
+    argv++;
+  }
+
+  if (argc < 3 || argc > 4) {
+    fprintf(stderr, "usage: %s [-c] [workers] [halo rows] [filename for init]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const int workers = atoi(argv[1]);
+  const int halo = atoi(argv[2]);
+  if (workers < 1 || halo < 1 || height / workers < halo) {
+    fprintf(stderr, "each of %d workers needs at least %d rows\n", workers, halo);
+    return EXIT_FAILURE;
+  }
+
+  /* ファイルを引数にとるか、ない場合はデフォルトの初期値を使う */
+  int result = my_init_cells(height, width, cell, (argc == 4) ? argv[3] : "");
+  if (result != 0) return EXIT_FAILURE;
+
+  int ref[height][width];
+  memcpy(ref, cell, sizeof(ref));
+
+  pid_t pids[workers];
+  int parent_fds[workers];
+  if (start_workers(workers, halo, height, width, cell, pids, parent_fds) != 0) {
+    fprintf(stderr, "cannot start workers\n");
+    return EXIT_FAILURE;
+  }
+
+  Transport t = socket_transport();
+
+  my_print_cells(fp, 0, height, width, cell); // 表示する
+
+  /* 世代を進める*/
+  for (int gen = 1 ;; gen++) {
+
+    /* 各ワーカーから帯を受け取ってつなぎ合わせる */
+    for (int i=0; i<workers; i++) {
+      int begin = strip_begin(i, workers, height);
+      int own_h = strip_begin(i + 1, workers, height) - begin;
+      t.fds[PEER_PARENT] = parent_fds[i];
+      if (t.recv(&t, PEER_PARENT, cell[begin], sizeof(int) * own_h * width) != 0) {
+        fprintf(stderr, "worker %d stopped\n", i);
+        return EXIT_FAILURE;
+      }
+    }
+
+    if (check) {
+      my_update_cells(height, width, ref);
+      if (memcmp(ref, cell, sizeof(ref)) != 0) {
+        fprintf(stderr, "generation %d differs from single-process run\n", gen);
+        for (int i=0; i<workers; i++) kill(pids[i], SIGTERM);
+        return EXIT_FAILURE;
+      }
+    }
+
+    my_print_cells(fp, gen, height, width, cell);  // 表示する
+    usleep(200*1000); //0.2秒休止する
+    fprintf(fp,"\e[%dA",height+3);//height+3 の分、カーソルを上に戻す(壁2、表示部1)
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,918 @@
+/*================================================================================================
+
+シミュレーションサーバー
+
+これまでのプログラムは1回起動するごとに1つの盤面を読み込み、ANSIの文字で標準出力に描くだけだった。
+serveモードでは、複数の盤面(universe)をメモリに持ったままUnixドメインソケットで待ち受け、
+小さなバイナリプロトコルで操作できるようにする。起動やRLEの読み込みをクエリごとにやり直さなくてよい。
+
+プロトコル(整数は全てuint32_t、実行環境のバイト順)
+  リクエスト: op, universe id, ペイロード長, ペイロード
+  レスポンス: status(0なら成功), ペイロード長, ペイロード
+
+  op            ペイロード                          レスポンスのペイロード
+  OP_CREATE     height, width                       id
+  OP_LOAD       パターンの本文(RLEかLife 1.06)      なし
+  OP_STEP       世代数n                             進めた後の世代
+  OP_FETCH      y, x, h, w, 形式(FETCH_BITS/RLE)    1bit/セルに詰めた行、またはRLEの文字列
+  OP_STATS      なし                                世代, 生きているセル数, height, width
+  OP_FREE       なし                                なし
+
+1つの接続の中ではリクエストを返事を待たずに続けて送ってよい(パイプライン)。
+サーバーは受け取ったリクエストを全て処理し、レスポンスをまとめて1回で書き出す(バッチ)。
+universeは接続をまたいで共有され、idで指定する。
+
+パターンはfmemopen()でFILEとして開き、mylife3.cのloadRLE()でそのまま読み込む。
+ただしソケットから来たパターンで盤面の外に書き込まないよう、範囲外のセルは無視するようにした。
+ルールはuniverseごとに持ち、更新の前にcan_born, can_surviveに戻す。
+更新はmylife7.cと同じく2行分のバッファだけを使うその場更新にしている(大きな盤面でもスタックを使い切らない)。
+
+clientモードは動作確認用で、1つのuniverseを作ってパターンを読み込み、
+世代を進めて統計とRLEを取得するまでを1回のバッチで送る。
+
+引数
+  serve  [ソケットのパス]
+  client [ソケットのパス] [パターンファイル] [世代数]
+
+実行例
+  ./a.out serve /tmp/life.sock &
+  ./a.out client /tmp/life.sock Bomber.rle 100
+
+================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h> // sleep()関数を使う
+#include <time.h>
+#include <string.h>
+#include <stdint.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* デフォルトのルール */
+int can_survive[9] = {0, 0, 1, 1, 0};
+int can_born[9] = {0, 0, 0, 1, 0};
+char rule_S[10] = "23";
+char rule_B[10] = "3";
+
+/*
+  文字列strの最後がsuffixに一致するか判定する関数
+*/
+int ends_with(const char str[], const char suffix[]) {
+
+  int len_str = strlen(str);
+  int len_suf = strlen(suffix);
+
+  if (len_str < len_suf) return 0;
+
+  char lower_str[255];
+  char lower_suffix[255];
+  strcpy(lower_str, str);
+  strcpy(lower_suffix, suffix);
+
+  /* 大文字は全て小文字にする */
+  for (int i=0; lower_str[i] != 0; i++) {
+    if ('A' <= lower_str[i] && lower_str[i] <= 'Z') {
+      lower_str[i] += 'a' - 'A';
+    }
+  }
+  for (int i=0; lower_suffix[i] != 0; i++) {
+    if ('A' <= lower_suffix[i] && lower_suffix[i] <= 'Z') {
+      lower_suffix[i] += 'a' - 'A';
+    }
+  }
+
+  return (strcmp(lower_str + len_str - len_suf, lower_suffix) == 0);
+}
+
+/*
+  文字列を10進数で表した時の長さを返す関数
+  ただし、0の長さは0とする
+*/
+int number_len(int n) {
+  int len = 0;
+  while(n > 0) {
+    len++;
+    n /= 10;
+  }
+
+  return len;
+}
+
+/*
+  文字が空白、タブ、CR、LFのいずれかなら1を返す関数
+*/
+int isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+int loadRLE(const int height, const int width, int cell[height][width], FILE *fp) {
+
+  char buffer[(int)1e4+1]; // 1行は70文字以下だが念のため
+  int y = 0, x = 0;
+  int offsetY = 0, offsetX = 0;
+  while(fgets(buffer, 1e4, fp) != NULL) {
+
+    /* オフセット指定以外のヘッダー情報は読み飛ばす */
+    if (buffer[0] == '#') {
+      if (buffer[1] == 'P' || buffer[1] == 'R') {
+        sscanf(buffer+2, "%d%d", &offsetX, &offsetY);
+        if (offsetY < 0 || offsetX < 0) {
+          offsetY = 0;
+          offsetX = 0;
+        } else {
+          y = offsetY;
+          x = offsetX;
+        }
+      }
+      continue;
+    }
+
+    /* サイズ情報は読み飛ばし、ルールは反映する */
+    if (buffer[0] == 'x') {
+      int result = sscanf(buffer, "x = %*d, y = %*d, rule = B%9[^/n]/S%9s", rule_B, rule_S);
+
+      for (int i=0; i<=8; i++) {
+        can_survive[i] = 0;
+        can_born[i] = 0;
+      }
+
+      for (int i=0; i<10; i++) {
+        int s = rule_S[i] - '0';
+        int b = rule_B[i] - '0';
+        if (0 <= s && s <= 8) can_survive[s] = 1;
+        if (0 <= b && b <= 8) can_born[b] = 1;
+      }
+
+      continue;
+    }
+
+    int offset = 0; // 行の何文字目を次に読むか
+    while(1) {
+      int len = 0; // ランの長さ
+      char c; // タグ('o', 'b', '$', '!'のいずれか)
+
+      // 途中に空白が入っても対応可能
+      while(isWhitespace(buffer[offset])) offset++;
+
+      // ランの長さを取得(1が省略されている場合は何も読み込まない)
+      int result = sscanf(buffer+offset, "%d", &len);
+      // 読み込んだ分だけoffsetを加算(ただし0のままの場合は読みこんでないのでそのまま)
+      offset += number_len(len);
+
+      // 長さ省略時は1
+      if (len == 0) len = 1;
+
+      // ランのタグを取得
+      result = sscanf(buffer+offset, "%c", &c);
+      offset++;
+
+      if (result <= 0 || c == '!') { // 終了
+        break;
+      } else if (c == '$') { // 改行
+        y += len;
+        x = offsetX;
+      } else if (c == 'b') { // dead
+        x += len;
+      } else if (c == 'o') { // alive
+        for (int i=0; i<len; i++) {
+          if (0 <= y && y < height && 0 <= x && x < width) cell[y][x] = 1; // 盤面の外は無視する
+          x++;
+        }
+      } else {
+        fprintf(stderr,"Invalid syntax\n");
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ ファイルによるセルの初期化: 生きているセルの座標が記述されたファイルをもとに2次元配列の状態を初期化する
+ fp = NULL のときは、関数内で適宜定められた初期状態に初期化する。関数内初期値はdefault.lif と同じもの
+ */
+int my_init_cells(const int height, const int width, int cell[height][width], char filename[]) {
+
+  if (filename[0] == 0) {
+    /* ランダムに配置する */
+    srand(time(NULL));
+
+    for (int y=0; y<height; y++) {
+      for (int x=0; x<width; x++) {
+        cell[y][x] = (rand() % 10 == 0 ? 1 : 0);
+      }
+    }
+  } else {
+
+    FILE *fp = fopen(filename,"r");
+    if (fp == NULL) {
+      fprintf(stderr,"cannot open file %s\n", filename);
+      return EXIT_FAILURE;
+    }
+
+    if (ends_with(filename, ".lif")) {
+
+      fscanf(fp, "%*[^\n]\n"); // バージョン情報は読み飛ばす
+
+      int x, y;
+      while (fscanf(fp, "%d%d", &x, &y) > 0) {
+        cell[y][x] = 1;
+      }
+
+    } else if (ends_with(filename, ".rle")) {
+
+      int result = loadRLE(height, width, cell, fp);
+      if (result != 0) return EXIT_FAILURE;
+
+    } else {
+
+      fprintf(stderr,"Supported: .lif .rle\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ グリッドの描画: 世代情報とグリッドの配列等を受け取り、ファイルポインタに該当する出力にグリッドを描画する
+ */
+void my_print_cells(FILE *fp, int gen, const int height, const int width, int cell[height][width]) {
+
+  /* 0,1それぞれの状態のセルをカウント */
+  int count_cells[2] = {0, 0};
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      count_cells[cell[y][x]]++;
+    }
+  }
+
+  // 世代情報と存在比を表示
+  fprintf(fp, "rule: B%s/S%s, generateion = %d, alive:dead = %7d:%7d\r\n", rule_B, rule_S, gen, count_cells[1], count_cells[0]);
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  /* グリッド */
+  for (int y=0; y<height; y++) {
+    fprintf(fp, "|");
+    for (int x=0; x<width; x++) {
+      fprintf(fp, "\e[31m%c\e[0m", (cell[y][x] ? '#' : ' ')); // 赤色で表示
+    }
+    fprintf(fp, "|\r\n");
+  }
+
+  /* 壁 */
+  fprintf(fp, "+");
+  for (int x=0; x<width; x++) fprintf(fp, "-");
+  fprintf(fp, "+\r\n");
+
+  fflush(fp);
+}
+
+int in_cells(int y, int x, const int height, const int width) {
+
+  if (y < 0 || height <= y) return 0;
+  if (x < 0 || width <= x) return 0;
+
+  return 1;
+}
+
+/*
+ 着目するセルの周辺の生きたセルをカウントする関数
+ */
+int my_count_adjacent_cells(int y, int x, const int height, const int width, int cell[height][width]) {
+
+  /*
+    dy, dx: 相対位置
+    012
+    7.3
+    654
+  */
+  int dy[] = {-1, -1, -1, 0, 1, 1, 1, 0};
+  int dx[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+
+  int count = 0;
+  
+  for (int i=0; i<8; i++) {
+
+    int ny = y + dy[i];
+    int nx = x + dx[i];
+
+    if (in_cells(ny, nx, height, width) && cell[ny][nx]) {
+      count++;
+    }
+
+  }
+
+  return count;
+}
+
+/*
+  着目するセルの次の世代での状態を返す関数
+*/
+int next_state(int y, int x, const int height, const int width, int cell[height][width], int neighbors) {
+
+  if (cell[y][x]) { 
+    return can_survive[neighbors];
+  } else {
+    return can_born[neighbors];
+  }
+
+}
+
+/*
+ ライフゲームのルールに基づいて2次元配列の状態を更新する
+ */
+void my_update_cells(const int height, const int width, int cell[height][width]) {
+
+  int next_cell[height][width];
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      next_cell[y][x] = 0;
+    }
+  }
+
+  for (int y=0; y<height; y++) {
+    for (int x=0; x<width; x++) {
+      int neighbors = my_count_adjacent_cells(y, x, height, width, cell);
+      next_cell[y][x] = next_state(y, x, height, width, cell, neighbors);
+    }
+  }
+
+  for(int y = 0 ; y < height ; y++){
+    for(int x = 0 ; x < width ; x++){
+      cell[y][x] = next_cell[y][x];
+    }
+  }
+
+}
+
+/*
+  ライフゲームのルールに基づいて2次元配列の状態をその場で更新する(mylife7.cと同じ)
+ */
+void my_update_cells_inplace(const int height, const int width, int cell[height][width]) {
+
+  int *prev_row = malloc(sizeof(int) * width); // 1つ上の行の更新前の状態
+  int *cur_row = malloc(sizeof(int) * width);  // 今の行の更新前の状態
+
+  for (int y=0; y<height; y++) {
+    memcpy(cur_row, cell[y], sizeof(int) * width);
+
+    for (int x=0; x<width; x++) {
+      int neighbors = 0;
+      for (int nx=x-1; nx<=x+1; nx++) {
+        if (nx < 0 || width <= nx) continue;
+        if (y > 0) neighbors += prev_row[nx];
+        if (y < height - 1) neighbors += cell[y+1][nx];
+        if (nx != x) neighbors += cur_row[nx];
+      }
+      cell[y][x] = (cur_row[x] ? can_survive[neighbors] : can_born[neighbors]);
+    }
+
+    int *tmp = prev_row;
+    prev_row = cur_row;
+    cur_row = tmp;
+  }
+
+  free(prev_row);
+  free(cur_row);
+}
+
+/*------------------------------------------------------------------------------------------------
+  universe
+------------------------------------------------------------------------------------------------*/
+
+#define MAX_UNIVERSES 64
+#define MAX_CELLS (1 << 28) // 1つのuniverseのセル数の上限
+#define MAX_REQUEST (64 << 20) // 1つのリクエストのペイロード長の上限
+
+enum { OP_CREATE = 1, OP_LOAD, OP_STEP, OP_FETCH, OP_STATS, OP_FREE };
+enum { FETCH_BITS = 0, FETCH_RLE = 1 };
+enum { STATUS_OK = 0, STATUS_BAD_REQUEST, STATUS_NO_UNIVERSE, STATUS_FULL, STATUS_NO_MEMORY };
+
+typedef struct {
+  int used;
+  int height;
+  int width;
+  int *cells; // height x width
+  uint32_t gen;
+  int can_survive[9];
+  int can_born[9];
+  char rule_S[10];
+  char rule_B[10];
+} Universe;
+
+Universe universes[MAX_UNIVERSES];
+
+/*
+  ペイロードの応答を溜めておくバッファ
+*/
+typedef struct {
+  uint8_t *data;
+  size_t len;
+  size_t cap;
+} Buffer;
+
+void buffer_reserve(Buffer *b, size_t extra) {
+
+  if (b->len + extra <= b->cap) return;
+  while (b->len + extra > b->cap) b->cap = (b->cap == 0) ? 4096 : b->cap * 2;
+  b->data = realloc(b->data, b->cap);
+}
+
+void buffer_append(Buffer *b, const void *data, size_t len) {
+
+  buffer_reserve(b, len);
+  memcpy(b->data + b->len, data, len);
+  b->len += len;
+}
+
+void buffer_append_u32(Buffer *b, uint32_t v) {
+  buffer_append(b, &v, sizeof(v));
+}
+
+/*
+  レスポンスの頭を書き、ペイロード長を後で埋めるための位置を返す関数
+*/
+size_t begin_response(Buffer *out, uint32_t status) {
+
+  buffer_append_u32(out, status);
+  size_t pos = out->len;
+  buffer_append_u32(out, 0);
+  return pos;
+}
+
+void end_response(Buffer *out, size_t pos) {
+  uint32_t len = out->len - pos - sizeof(uint32_t);
+  memcpy(out->data + pos, &len, sizeof(len));
+}
+
+void error_response(Buffer *out, uint32_t status) {
+  end_response(out, begin_response(out, status));
+}
+
+/*
+  universeのルールをグローバルのcan_born, can_survive等に反映する関数
+*/
+void use_rule(const Universe *u) {
+
+  memcpy(can_survive, u->can_survive, sizeof(can_survive));
+  memcpy(can_born, u->can_born, sizeof(can_born));
+  memcpy(rule_S, u->rule_S, sizeof(rule_S));
+  memcpy(rule_B, u->rule_B, sizeof(rule_B));
+}
+
+void save_rule(Universe *u) {
+
+  memcpy(u->can_survive, can_survive, sizeof(can_survive));
+  memcpy(u->can_born, can_born, sizeof(can_born));
+  memcpy(u->rule_S, rule_S, sizeof(rule_S));
+  memcpy(u->rule_B, rule_B, sizeof(rule_B));
+}
+
+/*
+  ペイロードのパターンをuniverseに読み込む関数
+  "#Life 1.06"で始まればLife 1.06、それ以外はRLEとして読む
+*/
+int load_pattern(Universe *u, const uint8_t data[], size_t len) {
+
+  const int height = u->height;
+  const int width = u->width;
+  int (*cell)[width] = (int (*)[width])u->cells;
+
+  memset(u->cells, 0, sizeof(int) * height * width);
+  u->gen = 0;
+  if (len == 0) return 0;
+
+  FILE *fp = fmemopen((void *)data, len, "r");
+  if (fp == NULL) return -1;
+
+  /* デフォルトのルールに戻してから読む */
+  int default_survive[9] = {0, 0, 1, 1, 0};
+  int default_born[9] = {0, 0, 0, 1, 0};
+  memcpy(can_survive, default_survive, sizeof(can_survive));
+  memcpy(can_born, default_born, sizeof(can_born));
+  strcpy(rule_S, "23");
+  strcpy(rule_B, "3");
+
+  int result = 0;
+  if (len >= 10 && memcmp(data, "#Life 1.06", 10) == 0) {
+    fscanf(fp, "%*[^\n]\n"); // バージョン情報は読み飛ばす
+
+    int x, y;
+    while (fscanf(fp, "%d%d", &x, &y) > 0) {
+      if (in_cells(y, x, height, width)) cell[y][x] = 1;
+    }
+  } else {
+    result = loadRLE(height, width, cell, fp);
+  }
+
+  fclose(fp);
+  save_rule(u);
+  return result;
+}
+
+/*
+  universeの一部をRLEの文字列にして書き出す関数
+*/
+void append_rle(Buffer *out, const Universe *u, int y0, int x0, int h, int w) {
+
+  char line[64];
+  int n = snprintf(line, sizeof(line), "x = %d, y = %d, rule = B%s/S%s\n", w, h, u->rule_B, u->rule_S);
+  buffer_append(out, line, n);
+
+  int blank_rows = 0;
+  int written = 0; // 既に書いた行があるか
+  for (int y=y0; y<y0+h; y++) {
+    const int *row = u->cells + (size_t)y * u->width;
+
+    /* 右端の死んだセルは書かない */
+    int end = x0 + w;
+    while (end > x0 && !row[end - 1]) end--;
+
+    if (end == x0) {
+      blank_rows++;
+      continue;
+    }
+    /* 前に書いた行(無ければ領域の1つ上)からの改行数 */
+    int newlines = written ? blank_rows + 1 : blank_rows;
+    if (newlines > 0) {
+      n = (newlines > 1) ? snprintf(line, sizeof(line), "%d$", newlines) : snprintf(line, sizeof(line), "$");
+      buffer_append(out, line, n);
+    }
+    blank_rows = 0;
+    written = 1;
+
+    for (int x=x0; x<end; ) {
+      int state = row[x];
+      int run = 0;
+      while (x < end && row[x] == state) {
+        x++;
+        run++;
+      }
+      n = (run > 1) ? snprintf(line, sizeof(line), "%d%c", run, state ? 'o' : 'b') : snprintf(line, sizeof(line), "%c", state ? 'o' : 'b');
+      buffer_append(out, line, n);
+    }
+  }
+  buffer_append(out, "!\n", 2);
+}
+
+/*
+  リクエストを1つ処理してoutにレスポンスを追加する関数
+*/
+void handle_request(uint32_t op, uint32_t id, const uint8_t payload[], uint32_t len, Buffer *out) {
+
+  uint32_t args[5] = {0, 0, 0, 0, 0};
+  memcpy(args, payload, (len < sizeof(args)) ? len : sizeof(args));
+
+  if (op == OP_CREATE) {
+    if (len < 2 * sizeof(uint32_t) || args[0] == 0 || args[1] == 0 || (uint64_t)args[0] * args[1] > MAX_CELLS) {
+      error_response(out, STATUS_BAD_REQUEST);
+      return;
+    }
+    for (int i=0; i<MAX_UNIVERSES; i++) {
+      Universe *u = &universes[i];
+      if (u->used) continue;
+
+      int *cells = calloc((size_t)args[0] * args[1], sizeof(int));
+      if (cells == NULL) {
+        error_response(out, STATUS_NO_MEMORY);
+        return;
+      }
+      u->used = 1;
+      u->height = args[0];
+      u->width = args[1];
+      u->cells = cells;
+      load_pattern(u, NULL, 0);
+      save_rule(u);
+
+      size_t pos = begin_response(out, STATUS_OK);
+      buffer_append_u32(out, i);
+      end_response(out, pos);
+      return;
+    }
+    error_response(out, STATUS_FULL);
+    return;
+  }
+
+  if (id >= MAX_UNIVERSES || !universes[id].used) {
+    error_response(out, STATUS_NO_UNIVERSE);
+    return;
+  }
+  Universe *u = &universes[id];
+
+  if (op == OP_LOAD) {
+    if (load_pattern(u, payload, len) != 0) {
+      error_response(out, STATUS_BAD_REQUEST);
+      return;
+    }
+    error_response(out, STATUS_OK);
+
+  } else if (op == OP_STEP) {
+    use_rule(u);
+    for (uint32_t i=0; i<args[0]; i++) {
+      my_update_cells_inplace(u->height, u->width, (int (*)[u->width])u->cells);
+    }
+    u->gen += args[0];
+
+    size_t pos = begin_response(out, STATUS_OK);
+    buffer_append_u32(out, u->gen);
+    end_response(out, pos);
+
+  } else if (op == OP_FETCH) {
+    uint32_t y0 = args[0], x0 = args[1], h = args[2], w = args[3];
+    if (len < 5 * sizeof(uint32_t) || y0 > (uint32_t)u->height || h > u->height - y0 || x0 > (uint32_t)u->width || w > u->width - x0) {
+      error_response(out, STATUS_BAD_REQUEST);
+      return;
+    }
+
+    size_t pos = begin_response(out, STATUS_OK);
+    if (args[4] == FETCH_RLE) {
+      append_rle(out, u, y0, x0, h, w);
+    } else {
+      /* 1行は(w+7)/8バイトで、x番目のセルは(x/8)バイト目の(x%8)ビット目 */
+      size_t row_bytes = (w + 7) / 8;
+      buffer_reserve(out, row_bytes * h);
+      uint8_t *bits = out->data + out->len;
+      memset(bits, 0, row_bytes * h);
+      for (uint32_t y=0; y<h; y++) {
+        const int *row = u->cells + (size_t)(y0 + y) * u->width + x0;
+        for (uint32_t x=0; x<w; x++) {
+          if (row[x]) bits[y * row_bytes + x / 8] |= 1 << (x % 8);
+        }
+      }
+      out->len += row_bytes * h;
+    }
+    end_response(out, pos);
+
+  } else if (op == OP_STATS) {
+    uint32_t alive = 0;
+    for (size_t i=0; i<(size_t)u->height * u->width; i++) alive += u->cells[i];
+
+    size_t pos = begin_response(out, STATUS_OK);
+    buffer_append_u32(out, u->gen);
+    buffer_append_u32(out, alive);
+    buffer_append_u32(out, u->height);
+    buffer_append_u32(out, u->width);
+    end_response(out, pos);
+
+  } else if (op == OP_FREE) {
+    free(u->cells);
+    u->cells = NULL;
+    u->used = 0;
+    error_response(out, STATUS_OK);
+
+  } else {
+    error_response(out, STATUS_BAD_REQUEST);
+  }
+}
+
+/*------------------------------------------------------------------------------------------------
+  サーバー
+------------------------------------------------------------------------------------------------*/
+
+#define MAX_CLIENTS 32
+
+typedef struct {
+  int fd;
+  Buffer in; // 受け取ったがまだ処理していないバイト列
+} Client;
+
+int write_all(int fd, const void *buf, size_t len) {
+
+  const char *p = buf;
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+    if (n <= 0) return -1;
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+int read_all(int fd, void *buf, size_t len) {
+
+  char *p = buf;
+  while (len > 0) {
+    ssize_t n = read(fd, p, len);
+    if (n <= 0) return -1;
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+/*
+  クライアントから読めるだけ読み、揃ったリクエストを全て処理してまとめて返す関数
+  接続を閉じるべきときは-1を返す
+*/
+int serve_client(Client *c, Buffer *out) {
+
+  buffer_reserve(&c->in, 65536);
+  ssize_t n = read(c->fd, c->in.data + c->in.len, c->in.cap - c->in.len);
+  if (n <= 0) return -1;
+  c->in.len += n;
+
+  const size_t header = 3 * sizeof(uint32_t);
+  size_t pos = 0;
+  out->len = 0;
+
+  while (c->in.len - pos >= header) {
+    uint32_t h[3];
+    memcpy(h, c->in.data + pos, header);
+    if (h[2] > MAX_REQUEST) return -1;
+    if (c->in.len - pos < header + h[2]) {
+      buffer_reserve(&c->in, header + h[2]); // 残りを受け取れるように広げておく
+      break;
+    }
+    handle_request(h[0], h[1], c->in.data + pos + header, h[2], out);
+    pos += header + h[2];
+  }
+
+  /* 処理した分を詰める */
+  memmove(c->in.data, c->in.data + pos, c->in.len - pos);
+  c->in.len -= pos;
+
+  if (out->len > 0 && write_all(c->fd, out->data, out->len) != 0) return -1;
+  return 0;
+}
+
+int serve(const char path[]) {
+
+  int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "socket path too long: %s\n", path);
+    return EXIT_FAILURE;
+  }
+  strcpy(addr.sun_path, path);
+  unlink(path);
+
+  if (listen_fd < 0 || bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listen_fd, 8) != 0) {
+    fprintf(stderr, "cannot listen on %s\n", path);
+    return EXIT_FAILURE;
+  }
+  fprintf(stderr, "listening on %s\n", path);
+
+  Client clients[MAX_CLIENTS];
+  int client_count = 0;
+  Buffer out = {NULL, 0, 0};
+
+  while (1) {
+    struct pollfd fds[MAX_CLIENTS + 1];
+    fds[0].fd = listen_fd;
+    fds[0].events = POLLIN;
+    for (int i=0; i<client_count; i++) {
+      fds[i + 1].fd = clients[i].fd;
+      fds[i + 1].events = POLLIN;
+    }
+
+    if (poll(fds, client_count + 1, -1) < 0) continue;
+
+    /* 既存の接続(後ろから処理すれば閉じたものを詰めても番号がずれない) */
+    for (int i=client_count-1; i>=0; i--) {
+      if (fds[i + 1].revents == 0) continue;
+      if (serve_client(&clients[i], &out) != 0) {
+        close(clients[i].fd);
+        free(clients[i].in.data);
+        clients[i] = clients[--client_count];
+      }
+    }
+
+    /* 新しい接続 */
+    if (fds[0].revents & POLLIN) {
+      int fd = accept(listen_fd, NULL, NULL);
+      if (fd >= 0 && client_count < MAX_CLIENTS) {
+        clients[client_count].fd = fd;
+        clients[client_count].in = (Buffer){NULL, 0, 0};
+        client_count++;
+      } else if (fd >= 0) {
+        close(fd);
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*------------------------------------------------------------------------------------------------
+  動作確認用のクライアント
+------------------------------------------------------------------------------------------------*/
+
+void append_request(Buffer *b, uint32_t op, uint32_t id, const void *payload, uint32_t len) {
+
+  buffer_append_u32(b, op);
+  buffer_append_u32(b, id);
+  buffer_append_u32(b, len);
+  buffer_append(b, payload, len);
+}
+
+/*
+  レスポンスを1つ受け取る関数(ペイロードはpayloadに入る)
+*/
+int read_response(int fd, uint32_t *status, Buffer *payload) {
+
+  uint32_t h[2];
+  if (read_all(fd, h, sizeof(h)) != 0) return -1;
+  *status = h[0];
+  payload->len = 0;
+  buffer_reserve(payload, h[1] + 1);
+  if (read_all(fd, payload->data, h[1]) != 0) return -1;
+  payload->len = h[1];
+  payload->data[h[1]] = 0;
+  return 0;
+}
+
+int client(const char path[], const char filename[], uint32_t gens) {
+
+  FILE *pattern = fopen(filename, "rb");
+  if (pattern == NULL) {
+    fprintf(stderr, "cannot open file %s\n", filename);
+    return EXIT_FAILURE;
+  }
+  Buffer text = {NULL, 0, 0};
+  char chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), pattern)) > 0) buffer_append(&text, chunk, n);
+  fclose(pattern);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+  if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    fprintf(stderr, "cannot connect to %s\n", path);
+    return EXIT_FAILURE;
+  }
+
+  /* universeを作る */
+  Buffer req = {NULL, 0, 0};
+  Buffer res = {NULL, 0, 0};
+  uint32_t status;
+  uint32_t size[2] = {40, 70};
+  append_request(&req, OP_CREATE, 0, size, sizeof(size));
+  write_all(fd, req.data, req.len);
+  if (read_response(fd, &status, &res) != 0 || status != STATUS_OK) {
+    fprintf(stderr, "create failed\n");
+    return EXIT_FAILURE;
+  }
+  uint32_t id;
+  memcpy(&id, res.data, sizeof(id));
+
+  /* 残りは返事を待たずにまとめて送る */
+  uint32_t region[5] = {0, 0, size[0], size[1], FETCH_RLE};
+  req.len = 0;
+  append_request(&req, OP_LOAD, id, text.data, text.len);
+  append_request(&req, OP_STEP, id, &gens, sizeof(gens));
+  append_request(&req, OP_STATS, id, NULL, 0);
+  append_request(&req, OP_FETCH, id, region, sizeof(region));
+  append_request(&req, OP_FREE, id, NULL, 0);
+  write_all(fd, req.data, req.len);
+
+  const char *names[] = {"load", "step", "stats", "fetch", "free"};
+  for (int i=0; i<5; i++) {
+    if (read_response(fd, &status, &res) != 0) {
+      fprintf(stderr, "connection closed\n");
+      return EXIT_FAILURE;
+    }
+    if (status != STATUS_OK) {
+      fprintf(stderr, "%s failed (status %u)\n", names[i], status);
+      return EXIT_FAILURE;
+    }
+    if (i == 2) {
+      uint32_t stats[4];
+      memcpy(stats, res.data, sizeof(stats));
+      printf("generation = %u, alive = %u, size = %ux%u\n", stats[0], stats[1], stats[2], stats[3]);
+    } else if (i == 3) {
+      fwrite(res.data, 1, res.len, stdout);
+    }
+  }
+
+  close(fd);
+  free(text.data);
+  free(req.data);
+  free(res.data);
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc == 3 && strcmp(argv[1], "serve") == 0) {
+    return serve(argv[2]);
+  } else if (argc == 5 && strcmp(argv[1], "client") == 0) {
+    return client(argv[2], argv[3], atoi(argv[4]));
+  }
+
+  fprintf(stderr, "usage: %s serve [socket path]\n", argv[0]);
+  fprintf(stderr, "       %s client [socket path] [filename for init] [generations]\n", argv[0]);
+  return EXIT_FAILURE;
+}